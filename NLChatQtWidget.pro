@@ -1,4 +1,4 @@
-QT       += core gui serialport
+QT       += core gui serialport network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -22,9 +22,26 @@ SOURCES += \
     serialmanager.cpp \
     serialsettingsdialog.cpp \
     chatbubblewidget.cpp \
+    chatmessagemodel.cpp \
+    chatlistview.cpp \
+    historylog.cpp \
     messagelistwindow.cpp \
+    conversationmodel.cpp \
     uilayoutmanager.cpp \
-    serialcli.cpp
+    serialcli.cpp \
+    receivebuffer.cpp \
+    framematcher.cpp \
+    utf8validator.cpp \
+    portmonitor.cpp \
+    crc.cpp \
+    serialtransport.cpp \
+    serialporttransport.cpp \
+    fdtransport.cpp \
+    localsockettransport.cpp \
+    reliablelink.cpp \
+    filetransfer.cpp \
+    capturelog.cpp \
+    replaytransport.cpp
 
 HEADERS += \
     ch34x_qt.h \
@@ -32,9 +49,30 @@ HEADERS += \
     serialmanager.h \
     serialsettingsdialog.h \
     chatbubblewidget.h \
+    chatmessagemodel.h \
+    chatlistview.h \
+    historylog.h \
     messagelistwindow.h \
+    conversationmodel.h \
     uilayoutmanager.h \
-    serialcli.h
+    serialcli.h \
+    receivebuffer.h \
+    spscqueue.h \
+    framematcher.h \
+    utf8validator.h \
+    portmonitor.h \
+    crc.h \
+    serialtransport.h \
+    serialporttransport.h \
+    fdtransport.h \
+    localsockettransport.h \
+    reliablelink.h \
+    filetransfer.h \
+    capturelog.h \
+    replaytransport.h
+
+# openpty()
+unix:!macx: LIBS += -lutil
 
 FORMS += \
     nlchatwindow.ui
@@ -0,0 +1,11 @@
+# 各基准程序共用的设置
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD/..
+
+SOURCES += \
+    $$PWD/benchreport.cpp
+
+HEADERS += \
+    $$PWD/benchreport.h
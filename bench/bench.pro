@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+
+# 性能基准测试，与应用分开构建：qmake bench/bench.pro && make
+# 每个程序运行后在当前目录写出<名称>.json，可用--json <路径>指定
+SUBDIRS += \
+    framing \
+    pipeline \
+    widgets
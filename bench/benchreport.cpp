@@ -0,0 +1,57 @@
+#include "benchreport.h"
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTextStream>
+
+BenchReport::BenchReport(const QString& suite)
+    : m_suite(suite)
+{
+}
+
+void BenchReport::add(const QString& name, const QVariantMap& params, double value, const QString& unit)
+{
+    QJsonObject result;
+    result.insert("name", name);
+    result.insert("params", QJsonObject::fromVariantMap(params));
+    result.insert("value", value);
+    result.insert("unit", unit);
+    m_results.append(result);
+
+    QStringList fields;
+    for(auto it = params.constBegin(); it != params.constEnd(); ++it) {
+        fields << QString("%1=%2").arg(it.key(), it.value().toString());
+    }
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4\n").arg(name, -24).arg(fields.join(' '), -32)
+           .arg(value, 12, 'f', 2).arg(unit);
+    out.flush();
+}
+
+bool BenchReport::write(const QStringList& arguments) const
+{
+    QString path = m_suite + ".json";
+    const int index = arguments.indexOf("--json");
+    if(index >= 0 && index + 1 < arguments.size()) {
+        path = arguments.at(index + 1);
+    }
+
+    QJsonObject root;
+    root.insert("suite", m_suite);
+    root.insert("timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    root.insert("qt", QString::fromLatin1(qVersion()));
+    root.insert("cpu", QSysInfo::currentCpuArchitecture());
+    root.insert("os", QSysInfo::prettyProductName());
+    root.insert("results", m_results);
+
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QTextStream(stderr) << "无法写入 " << path << ": " << file.errorString() << "\n";
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson());
+    QTextStream(stdout) << "结果已写入 " << path << "\n";
+    return true;
+}
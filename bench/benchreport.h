@@ -0,0 +1,46 @@
+#ifndef BENCHREPORT_H
+#define BENCHREPORT_H
+
+#include <QJsonArray>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+/**
+ * @brief 基准测试结果收集与输出
+ *
+ * 每条结果同时打印到标准输出，并在结束时写成JSON：
+ * {
+ *   "suite": "pipeline", "timestamp": "...", "qt": "5.15.2",
+ *   "cpu": "x86_64", "os": "...",
+ *   "results": [ { "name": "...", "params": {...}, "value": 1.0, "unit": "MB/s" } ]
+ * }
+ * 同一name+params在不同运行之间可以直接对比。
+ */
+class BenchReport
+{
+public:
+    explicit BenchReport(const QString& suite);
+
+    /**
+     * @brief 记录一条结果
+     * @param name 测量项
+     * @param params 参数，如帧长、模式
+     * @param value 测量值
+     * @param unit 单位
+     */
+    void add(const QString& name, const QVariantMap& params, double value, const QString& unit);
+
+    /**
+     * @brief 写出JSON文件
+     * @param arguments 命令行参数，含"--json <路径>"时写到该路径，否则写到当前目录下的<suite>.json
+     * @return 是否成功
+     */
+    bool write(const QStringList& arguments) const;
+
+private:
+    QString m_suite;        ///< 测试集名称
+    QJsonArray m_results;   ///< 已记录的结果
+};
+
+#endif // BENCHREPORT_H
@@ -0,0 +1,14 @@
+QT       += core
+QT       -= gui
+
+TARGET = bench_framing
+
+# 帧分隔符/标记查找基准测试，对比旧路径与FrameMatcher各实现
+include(../bench.pri)
+
+SOURCES += \
+    main.cpp \
+    ../../framematcher.cpp
+
+HEADERS += \
+    ../../framematcher.h
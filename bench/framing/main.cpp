@@ -0,0 +1,162 @@
+#include <QCoreApplication>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QString>
+#include "framematcher.h"
+#include "benchreport.h"
+
+/**
+ * @brief 帧查找微基准
+ *
+ * 对比两条路径在16B、256B、4KB帧长下的扫描吞吐量：
+ * - legacy：旧processBuffer的做法，每帧都对QString标记调用toUtf8()再QByteArray::indexOf
+ * - FrameMatcher：预编译标记，分别使用scalar/sse2/avx2实现
+ *
+ * 只统计定位帧边界的开销，不包含拷贝和信号发送。
+ */
+
+namespace {
+
+const int STREAM_BYTES = 32 * 1024 * 1024;  ///< 每轮扫描的数据量
+const int ROUNDS = 5;                        ///< 取最快一轮
+
+/**
+ * @brief 生成由定长帧组成的数据流
+ * 负载使用小写字母，并混入标记首字节以考验候选过滤
+ */
+QByteArray makeStream(int frameSize, const QByteArray& start, const QByteArray& end)
+{
+    QByteArray stream;
+    stream.reserve(STREAM_BYTES + frameSize);
+
+    const int payload = qMax(1, frameSize - start.size() - end.size());
+    const char first = end.at(0);
+    quint32 seed = 12345;
+    while(stream.size() < STREAM_BYTES) {
+        stream.append(start);
+        for(int i = 0; i < payload; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            const char c = (seed >> 16) % 61 == 0 ? first : char('a' + (seed >> 16) % 26);
+            stream.append(end.size() == 1 && c == first ? 'x' : c);
+        }
+        stream.append(end);
+    }
+    return stream;
+}
+
+/**
+ * @brief 旧路径：每次查找都重新编码标记
+ */
+int scanLegacy(const QByteArray& stream, const QString& start, const QString& end)
+{
+    int frames = 0;
+    int pos = 0;
+    while(pos < stream.size()) {
+        int startPos = pos;
+        if(!start.isEmpty()) {
+            startPos = stream.indexOf(start.toUtf8(), pos);
+            if(startPos < 0) break;
+            startPos += start.length();
+        }
+        const int endPos = stream.indexOf(end.toUtf8(), startPos);
+        if(endPos < 0) break;
+        pos = endPos + end.length();
+        frames++;
+    }
+    return frames;
+}
+
+int scanMatcher(const QByteArray& stream, const FrameMatcher& start, const FrameMatcher& end)
+{
+    const char* data = stream.constData();
+    const int size = stream.size();
+    int frames = 0;
+    int pos = 0;
+    while(pos < size) {
+        int startPos = pos;
+        if(!start.isEmpty()) {
+            startPos = start.indexIn(data, size, pos);
+            if(startPos < 0) break;
+            startPos += start.size();
+        }
+        const int endPos = end.indexIn(data, size, startPos);
+        if(endPos < 0) break;
+        pos = endPos + end.size();
+        frames++;
+    }
+    return frames;
+}
+
+template <typename Scan>
+double bestThroughput(const QByteArray& stream, Scan scan, int* frames)
+{
+    qint64 bestNs = -1;
+    for(int round = 0; round < ROUNDS; ++round) {
+        QElapsedTimer timer;
+        timer.start();
+        *frames = scan();
+        const qint64 ns = timer.nsecsElapsed();
+        if(bestNs < 0 || ns < bestNs) {
+            bestNs = ns;
+        }
+    }
+    return stream.size() / 1048576.0 / (qMax<qint64>(bestNs, 1) / 1e9);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    BenchReport report("framing");
+
+    struct Mode {
+        const char* name;
+        QString start;
+        QString end;
+    };
+    const Mode modes[] = {
+        { "line", QString(), QStringLiteral("\n") },
+        { "package", QStringLiteral("$NL"), QStringLiteral("#END") }
+    };
+    const int frameSizes[] = { 16, 256, 4096 };
+    const FrameMatcher::Implementation impls[] = {
+        FrameMatcher::ScalarImplementation,
+        FrameMatcher::Sse2Implementation,
+        FrameMatcher::Avx2Implementation
+    };
+
+    for(const Mode& mode : modes) {
+        for(int frameSize : frameSizes) {
+            const QByteArray stream = makeStream(frameSize, mode.start.toUtf8(), mode.end.toUtf8());
+            int frames = 0;
+
+            double mbps = bestThroughput(stream, [&]() {
+                return scanLegacy(stream, mode.start, mode.end);
+            }, &frames);
+            report.add("scan", {{"mode", mode.name}, {"frame", frameSize}, {"impl", "legacy"}},
+                       mbps, "MB/s");
+
+            for(FrameMatcher::Implementation impl : impls) {
+                FrameMatcher start(mode.start.toUtf8());
+                FrameMatcher end(mode.end.toUtf8());
+                if(!start.setImplementation(impl) || !end.setImplementation(impl)) {
+                    continue;
+                }
+                int matched = 0;
+                mbps = bestThroughput(stream, [&]() {
+                    return scanMatcher(stream, start, end);
+                }, &matched);
+                if(matched != frames) {
+                    qWarning("%s/%d/%s: matched %d frames, expected %d", mode.name, frameSize,
+                             FrameMatcher::implementationName(impl), matched, frames);
+                }
+                report.add("scan", {{"mode", mode.name},
+                                    {"frame", frameSize},
+                                    {"impl", FrameMatcher::implementationName(impl)}},
+                           mbps, "MB/s");
+            }
+        }
+    }
+    return report.write(app.arguments()) ? 0 : 1;
+}
@@ -0,0 +1,554 @@
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ch34x_qt.h"
+#include "serialmanager.h"
+#include "fdtransport.h"
+#include "capturelog.h"
+#include "reliablelink.h"
+#include "benchreport.h"
+
+/**
+ * @brief 收发链路基准
+ *
+ * 所有测量都经过伪终端：被测对象打开"pty:链接路径"，本程序打开从设备扮演对端。
+ * - receive：对端持续写入定长帧，测从读取、分帧到发出framesReceived的吞吐量，
+ *   分行模式和包模式；raw一项只经PtyTransport读取同样的数据，作为pty本身的上限
+ * - latency：对端写入一行到SerialManager::messageReceived的时间，
+ *   分直接调用和I/O线程两种模式
+ * - write：writeData连续发送，直到对端读完全部数据的吞吐量
+ * - resync：两个ReliableLink在内存中直接相连，接收端在窗口中途重置（模拟对端重启），
+ *   测发送端从重新同步到全部消息确认的时间，以及以失败结束的消息数（应为0）
+ * - replay：给出"--replay 捕获文件"时以最高速度回放，测CH34xQt分帧和经I/O线程到
+ *   SerialManager解码的吞吐量；分帧方式由"--replay-framing line|binary|gap"指定，默认line
+ */
+
+namespace {
+
+const int STREAM_BYTES = 8 * 1024 * 1024;  ///< 每项吞吐量测量的数据量
+const int LATENCY_SAMPLES = 1000;          ///< 延迟采样次数
+const int TIMEOUT_MS = 30000;              ///< 单项超时
+const int RESYNC_MESSAGES = 64;            ///< 重新同步测量发送的消息数
+
+QString linkPath()
+{
+    return QDir::tempPath() + QString("/nlchat-bench-%1").arg(QCoreApplication::applicationPid());
+}
+
+QString benchPort()
+{
+    return QStringLiteral("pty:") + linkPath();
+}
+
+/**
+ * @brief 打开伪终端从设备，作为对端
+ */
+int openPeer()
+{
+    return ::open(QFile::encodeName(linkPath()).constData(), O_RDWR | O_NOCTTY);
+}
+
+bool writeAll(int fd, const char* data, qint64 size)
+{
+    while(size > 0) {
+        const ssize_t n = ::write(fd, data, static_cast<size_t>(size));
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+/**
+ * @brief 生成由定长帧组成的数据流
+ * @param frames 输出帧数
+ */
+QByteArray makeStream(int frameSize, const QByteArray& start, const QByteArray& end, int* frames)
+{
+    const int payload = qMax(1, frameSize - start.size() - end.size());
+    QByteArray frame = start;
+    for(int i = 0; i < payload; ++i) {
+        frame.append(char('a' + i % 26));
+    }
+    frame.append(end);
+
+    *frames = qMax(1, STREAM_BYTES / frame.size());
+    QByteArray stream;
+    stream.reserve(*frames * frame.size());
+    for(int i = 0; i < *frames; ++i) {
+        stream.append(frame);
+    }
+    return stream;
+}
+
+double toMBps(qint64 bytes, qint64 ns)
+{
+    return bytes / 1048576.0 / (qMax<qint64>(ns, 1) / 1e9);
+}
+
+/**
+ * @brief pty本身的吞吐量上限，不经过分帧
+ */
+double measureRawReceive()
+{
+    PtyTransport transport;
+    transport.setPortName(benchPort());
+    if(!transport.open()) {
+        qWarning("raw: %s", qPrintable(transport.errorString()));
+        return -1;
+    }
+    const int peer = openPeer();
+
+    int frames = 0;
+    const QByteArray stream = makeStream(256, QByteArray(), "\n", &frames);
+    qint64 received = 0;
+    QEventLoop loop;
+    QObject::connect(&transport, &SerialTransport::readyRead, &loop, [&]() {
+        received += transport.readAll().size();
+        if(received >= stream.size()) {
+            loop.quit();
+        }
+    });
+    QTimer::singleShot(TIMEOUT_MS, &loop, &QEventLoop::quit);
+
+    QElapsedTimer timer;
+    timer.start();
+    std::thread writer([&]() { writeAll(peer, stream.constData(), stream.size()); });
+    loop.exec();
+    const qint64 ns = timer.nsecsElapsed();
+
+    // 超时时关闭主设备，让阻塞的写入以EIO返回
+    transport.close();
+    writer.join();
+    ::close(peer);
+    return received < stream.size() ? -1 : toMBps(stream.size(), ns);
+}
+
+/**
+ * @brief 接收吞吐量
+ * @param start 包起始标记，为空且end为换行时使用行模式
+ * @param end 包结束标记
+ */
+double measureReceive(const QByteArray& start, const QByteArray& end, int frameSize)
+{
+    CH34xQt device;
+    if(!start.isEmpty() || end != "\n") {
+        device.setPackageMode(true, QString::fromLatin1(start), QString::fromLatin1(end), TIMEOUT_MS);
+    }
+    if(!device.openDevice(benchPort())) {
+        return -1;
+    }
+    const int peer = openPeer();
+
+    int frames = 0;
+    const QByteArray stream = makeStream(frameSize, start, end, &frames);
+    int received = 0;
+    QEventLoop loop;
+    QObject::connect(&device, &CH34xQt::framesReceived, &loop,
+                     [&](const QVector<CH34xQt::Frame>& batch) {
+        received += batch.size();
+        if(received >= frames) {
+            loop.quit();
+        }
+    });
+    QTimer::singleShot(TIMEOUT_MS, &loop, &QEventLoop::quit);
+
+    QElapsedTimer timer;
+    timer.start();
+    std::thread writer([&]() { writeAll(peer, stream.constData(), stream.size()); });
+    loop.exec();
+    const qint64 ns = timer.nsecsElapsed();
+
+    device.closeDevice();
+    writer.join();
+    ::close(peer);
+    if(received < frames) {
+        qWarning("receive: got %d of %d frames", received, frames);
+        return -1;
+    }
+    return toMBps(stream.size(), ns);
+}
+
+/**
+ * @brief 线上字节到messageReceived的延迟
+ */
+void measureLatency(BenchReport& report, bool useIoThread)
+{
+    SerialManager manager(nullptr, useIoThread);
+    SerialSettingsDialog::Settings settings;
+    settings.baudRate = QSerialPort::Baud115200;
+    settings.dataBits = QSerialPort::Data8;
+    settings.stopBits = QSerialPort::OneStop;
+    settings.parity = QSerialPort::NoParity;
+    settings.flowControl = QSerialPort::NoFlowControl;
+    settings.bufferSize = 64 * 1024;
+    settings.packageDelay = 0;
+    settings.gapFraming = false;
+    settings.autoScroll = false;
+    manager.applySettings(settings);
+
+    bool connected = false;
+    QEventLoop openLoop;
+    QObject::connect(&manager, &SerialManager::connectionStatusChanged, &openLoop, [&](bool status) {
+        connected = status;
+        openLoop.quit();
+    });
+    QTimer::singleShot(TIMEOUT_MS, &openLoop, &QEventLoop::quit);
+    // 不用设备线程时打开在openPort()内同步完成，quit()早于exec()，不能再等待
+    if(manager.openPort(benchPort()) && !manager.isOpen()) {
+        openLoop.exec();
+    }
+    connected = connected || manager.isOpen();
+    if(!connected) {
+        qWarning("latency: open failed");
+        return;
+    }
+    const int peer = openPeer();
+
+    QElapsedTimer clock;
+    clock.start();
+    qint64 sentNs = 0;
+    std::vector<qint64> samples;
+    samples.reserve(LATENCY_SAMPLES);
+
+    QEventLoop loop;
+    QTimer guard;
+    guard.setSingleShot(true);
+    QObject::connect(&guard, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QObject::connect(&manager, &SerialManager::messageReceived, &loop, [&](const QString&) {
+        samples.push_back(clock.nsecsElapsed() - sentNs);
+        loop.quit();
+    });
+
+    for(int i = 0; i < LATENCY_SAMPLES; ++i) {
+        const QByteArray line = "ping " + QByteArray::number(i) + '\n';
+        const size_t before = samples.size();
+        guard.start(1000);
+        sentNs = clock.nsecsElapsed();
+        writeAll(peer, line.constData(), line.size());
+        loop.exec();
+        if(samples.size() == before) {
+            qWarning("latency: sample %d timed out", i);
+            break;
+        }
+    }
+
+    manager.closePort();
+    ::close(peer);
+    if(samples.empty()) {
+        return;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const QVariantMap params{{"thread", useIoThread ? "io" : "direct"}};
+    report.add("latency_p50", params, samples[samples.size() / 2] / 1000.0, "us");
+    report.add("latency_p99", params, samples[samples.size() * 99 / 100] / 1000.0, "us");
+    report.add("latency_max", params, samples.back() / 1000.0, "us");
+}
+
+/**
+ * @brief 对端在窗口中途丢失接收状态后的恢复
+ *
+ * @details
+ * 1. 两个ReliableLink经transmit信号直接相连，发送端以默认窗口发出RESYNC_MESSAGES条消息
+ * 2. 接收端交付一半时reset()，之后发送端的段都落在对端的新状态之外
+ * 3. 从重置到发送端全部消息结束计时，记录重新同步次数和失败的消息数
+ */
+void measureResync(BenchReport& report)
+{
+    ReliableLink sender;
+    ReliableLink receiver;
+    QObject::connect(&sender, &ReliableLink::transmit, &receiver, [&](const QByteArray& packet) {
+        QList<QByteArray> messages;
+        receiver.handleFrame(packet, messages);
+    });
+    QObject::connect(&receiver, &ReliableLink::transmit, &sender, [&](const QByteArray& packet) {
+        QList<QByteArray> messages;
+        sender.handleFrame(packet, messages);
+    });
+
+    int finished = 0;
+    int failed = 0;
+    bool peerReset = false;
+    QElapsedTimer timer;
+    QEventLoop loop;
+    QObject::connect(&sender, &ReliableLink::delivered, &loop, [&](quint32, bool success) {
+        ++finished;
+        if(!success) {
+            ++failed;
+        }
+        if(!peerReset && finished == RESYNC_MESSAGES / 2) {
+            // 对端重启：接收状态丢失，之后收到的都是旧会话中间的段
+            peerReset = true;
+            timer.start();
+            receiver.reset();
+        }
+        if(finished == RESYNC_MESSAGES) {
+            loop.quit();
+        }
+    });
+    QTimer::singleShot(TIMEOUT_MS, &loop, &QEventLoop::quit);
+
+    for(int i = 0; i < RESYNC_MESSAGES; ++i) {
+        sender.send("resync " + QByteArray::number(i));
+    }
+    loop.exec();
+
+    if(finished < RESYNC_MESSAGES) {
+        qWarning("resync: %d of %d messages finished", finished, RESYNC_MESSAGES);
+        return;
+    }
+    const ReliableLink::Statistics stats = sender.statistics();
+    report.add("resync_recovery", {{"messages", RESYNC_MESSAGES}}, timer.nsecsElapsed() / 1e6, "ms");
+    report.add("resync_failed", {{"messages", RESYNC_MESSAGES}}, failed, "messages");
+    report.add("resync_count", {{"messages", RESYNC_MESSAGES}}, stats.resyncs, "resyncs");
+}
+
+/**
+ * @brief writeData吞吐量，行模式下每条消息另加一个换行
+ */
+double measureWrite(int messageSize)
+{
+    CH34xQt device;
+    if(!device.openDevice(benchPort())) {
+        return -1;
+    }
+    const int peer = openPeer();
+
+    const QByteArray message(messageSize, 'w');
+    const int count = STREAM_BYTES / (messageSize + 1);
+    const qint64 expected = qint64(count) * (messageSize + 1);
+    std::atomic<qint64> received(0);
+    std::thread reader([&]() {
+        QByteArray buffer(64 * 1024, Qt::Uninitialized);
+        while(received < expected) {
+            const ssize_t n = ::read(peer, buffer.data(), static_cast<size_t>(buffer.size()));
+            if(n > 0) {
+                received += n;
+            } else if(n < 0 && errno == EINTR) {
+                continue;
+            } else {
+                break;
+            }
+        }
+    });
+
+    // 保证事件循环定期醒来检查超时
+    QTimer wake;
+    wake.start(100);
+
+    QElapsedTimer timer;
+    timer.start();
+    bool timedOut = false;
+    for(int i = 0; i < count && !timedOut; ) {
+        if(device.writeData(message)) {
+            ++i;
+            continue;
+        }
+        // 超过高水位，等写出一部分再继续
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        timedOut = timer.elapsed() > TIMEOUT_MS;
+    }
+    while(device.pendingWriteBytes() > 0 && !timedOut) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        timedOut = timer.elapsed() > TIMEOUT_MS;
+    }
+
+    if(timedOut) {
+        device.closeDevice();
+    }
+    reader.join();
+    const qint64 ns = timer.nsecsElapsed();
+    device.closeDevice();
+    ::close(peer);
+
+    if(received < expected) {
+        qWarning("write: peer got %lld of %lld bytes", static_cast<long long>(received.load()),
+                 static_cast<long long>(expected));
+        return -1;
+    }
+    return toMBps(expected, ns);
+}
+
+/**
+ * @brief 以最高速度回放捕获文件
+ *
+ * @details
+ * 1. 先扫描一遍捕获文件，得到接收数据的总字节数和读取次数
+ * 2. CH34xQt直接打开replay:路径@max，接收字节数达到总数即结束，记录吞吐量和帧数
+ * 3. 行模式下SerialManager再以I/O线程模式打开同一文件，收到同样多的消息即结束
+ */
+void measureReplay(BenchReport& report, const QString& path, CH34xQt::FramingMode framing)
+{
+    CaptureReader reader;
+    if(!reader.open(path)) {
+        qWarning("replay: %s", qPrintable(reader.errorString()));
+        return;
+    }
+    qint64 total = 0;
+    qint64 reads = 0;
+    CaptureRecord record;
+    while(reader.next(record)) {
+        if(record.direction == CaptureRecord::Received) {
+            total += record.size;
+            ++reads;
+        }
+    }
+    reader.close();
+    if(total == 0) {
+        qWarning("replay: no received data in %s", qPrintable(path));
+        return;
+    }
+
+    const QString port = QStringLiteral("replay:") + path + QStringLiteral("@max");
+    const char* framingName = framing == CH34xQt::BinaryFraming ? "binary"
+                            : framing == CH34xQt::GapFraming ? "gap" : "line";
+    const QVariantMap params{{"framing", framingName}, {"reads", reads}};
+
+    qint64 frames = 0;
+    {
+        CH34xQt device;
+        CH34xQt::SerialConfig config = device.currentConfig();
+        config.portName = port;
+        config.framing = framing;
+        if(!device.applyConfig(config)) {
+            return;
+        }
+
+        QEventLoop loop;
+        QObject::connect(&device, &CH34xQt::framesReceived, &loop,
+                         [&](const QVector<CH34xQt::Frame>& batch) { frames += batch.size(); });
+        QTimer poll;
+        QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+            if(device.getStatistics().bytesReceived >= total) {
+                loop.quit();
+            }
+        });
+        poll.start(1);
+        QTimer::singleShot(TIMEOUT_MS, &loop, &QEventLoop::quit);
+
+        QElapsedTimer timer;
+        timer.start();
+        loop.exec();
+        const qint64 ns = timer.nsecsElapsed();
+        const qint64 received = device.getStatistics().bytesReceived;
+        device.closeDevice();
+        if(received < total) {
+            qWarning("replay: got %lld of %lld bytes", static_cast<long long>(received),
+                     static_cast<long long>(total));
+            return;
+        }
+        report.add("replay", params, toMBps(total, ns), "MB/s");
+        report.add("replay_frames", params, frames / (qMax<qint64>(ns, 1) / 1e9), "frames/s");
+    }
+    // 二进制帧可能属于可靠传输通道，空闲分帧的帧数与回放时序有关，
+    // 两者经SerialManager得到的消息数都不一定等于帧数，只测行模式
+    if(frames == 0 || framing != CH34xQt::LineFraming) {
+        return;
+    }
+
+    SerialManager manager(nullptr, true);
+    SerialSettingsDialog::Settings settings;
+    settings.baudRate = QSerialPort::Baud115200;
+    settings.dataBits = QSerialPort::Data8;
+    settings.stopBits = QSerialPort::OneStop;
+    settings.parity = QSerialPort::NoParity;
+    settings.flowControl = QSerialPort::NoFlowControl;
+    settings.bufferSize = 64 * 1024;
+    settings.packageDelay = 0;
+    settings.gapFraming = false;
+    settings.autoScroll = false;
+    manager.applySettings(settings);
+
+    qint64 messages = 0;
+    QEventLoop loop;
+    QObject::connect(&manager, &SerialManager::messagesReceived, &loop, [&](const QStringList& batch) {
+        messages += batch.size();
+        if(messages >= frames) {
+            loop.quit();
+        }
+    });
+    QTimer::singleShot(TIMEOUT_MS, &loop, &QEventLoop::quit);
+
+    QElapsedTimer timer;
+    timer.start();
+    if(manager.openPort(port)) {
+        loop.exec();
+    }
+    const qint64 ns = timer.nsecsElapsed();
+    manager.closePort();
+    if(messages < frames) {
+        qWarning("replay: manager got %lld of %lld messages", static_cast<long long>(messages),
+                 static_cast<long long>(frames));
+        return;
+    }
+    report.add("replay_manager", params, toMBps(total, ns), "MB/s");
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // SerialManager依赖设置对话框的类型，需要QApplication，但不显示任何窗口
+    if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    BenchReport report("pipeline");
+
+    report.add("receive", {{"mode", "raw"}, {"frame", 256}}, measureRawReceive(), "MB/s");
+
+    struct Mode {
+        const char* name;
+        QByteArray start;
+        QByteArray end;
+    };
+    const Mode modes[] = {
+        { "line", QByteArray(), "\n" },
+        { "package", "$NL", "#END" }
+    };
+    const int frameSizes[] = { 16, 256, 4096 };
+    for(const Mode& mode : modes) {
+        for(int frameSize : frameSizes) {
+            report.add("receive", {{"mode", mode.name}, {"frame", frameSize}},
+                       measureReceive(mode.start, mode.end, frameSize), "MB/s");
+        }
+    }
+
+    measureLatency(report, false);
+    measureLatency(report, true);
+
+    measureResync(report);
+
+    for(int messageSize : frameSizes) {
+        report.add("write", {{"message", messageSize}}, measureWrite(messageSize), "MB/s");
+    }
+
+    const QStringList arguments = app.arguments();
+    const int replayIndex = arguments.indexOf("--replay");
+    if(replayIndex >= 0 && replayIndex + 1 < arguments.size()) {
+        const int framingIndex = arguments.indexOf("--replay-framing");
+        const QString framing = framingIndex >= 0 && framingIndex + 1 < arguments.size()
+                              ? arguments.at(framingIndex + 1) : QString("line");
+        measureReplay(report, arguments.at(replayIndex + 1),
+                      framing == "binary" ? CH34xQt::BinaryFraming
+                      : framing == "gap" ? CH34xQt::GapFraming : CH34xQt::LineFraming);
+    }
+
+    return report.write(arguments) ? 0 : 1;
+}
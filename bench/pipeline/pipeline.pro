@@ -0,0 +1,49 @@
+QT       += core gui widgets serialport network
+
+TARGET = bench_pipeline
+
+# 收发链路基准测试：经伪终端驱动CH34xQt和SerialManager
+include(../bench.pri)
+
+SOURCES += \
+    main.cpp \
+    ../../ch34x_qt.cpp \
+    ../../serialmanager.cpp \
+    ../../serialsettingsdialog.cpp \
+    ../../uilayoutmanager.cpp \
+    ../../receivebuffer.cpp \
+    ../../framematcher.cpp \
+    ../../utf8validator.cpp \
+    ../../portmonitor.cpp \
+    ../../crc.cpp \
+    ../../serialtransport.cpp \
+    ../../serialporttransport.cpp \
+    ../../fdtransport.cpp \
+    ../../localsockettransport.cpp \
+    ../../reliablelink.cpp \
+    ../../filetransfer.cpp \
+    ../../capturelog.cpp \
+    ../../replaytransport.cpp
+
+HEADERS += \
+    ../../ch34x_qt.h \
+    ../../serialmanager.h \
+    ../../serialsettingsdialog.h \
+    ../../uilayoutmanager.h \
+    ../../receivebuffer.h \
+    ../../spscqueue.h \
+    ../../framematcher.h \
+    ../../utf8validator.h \
+    ../../portmonitor.h \
+    ../../crc.h \
+    ../../serialtransport.h \
+    ../../serialporttransport.h \
+    ../../fdtransport.h \
+    ../../localsockettransport.h \
+    ../../reliablelink.h \
+    ../../filetransfer.h \
+    ../../capturelog.h \
+    ../../replaytransport.h
+
+!unix: error("pipeline基准依赖伪终端，仅支持Unix")
+unix:!macx: LIBS += -lutil
@@ -0,0 +1,91 @@
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QScrollBar>
+#include "chatbubblewidget.h"
+#include "benchreport.h"
+
+/**
+ * @brief 聊天视图基准
+ *
+ * 在offscreen平台上显示一个400x600的ChatBubbleWidget：
+ * - fill：连续添加N条消息并完成一次布局和绘制的总时间
+ * - append：已有N条消息时，再添加一条并处理完布局和绘制的平均时间
+ * - scroll：已有N条消息时，从底部向上翻一页并重绘的平均时间
+ *
+ * "--max-messages <N>"可限制最大消息数，用于快速运行。
+ */
+
+namespace {
+
+const int APPEND_SAMPLES = 100;     ///< append采样次数
+const int SCROLL_SAMPLES = 100;     ///< scroll采样次数
+
+QString makeMessage(int index)
+{
+    // 长短交替，长消息会折行
+    return index % 3 == 0
+        ? QString("message %1 with a longer body that wraps across several lines in the bubble view").arg(index)
+        : QString("message %1").arg(index);
+}
+
+void settle(QWidget* widget)
+{
+    QCoreApplication::processEvents();
+    widget->repaint();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    BenchReport report("widgets");
+
+    int maxMessages = 1000000;
+    const QStringList arguments = app.arguments();
+    const int index = arguments.indexOf("--max-messages");
+    if(index >= 0 && index + 1 < arguments.size()) {
+        maxMessages = arguments.at(index + 1).toInt();
+    }
+
+    const int counts[] = { 1000, 10000, 100000, 1000000 };
+    for(int count : counts) {
+        if(count > maxMessages) {
+            break;
+        }
+
+        ChatBubbleWidget widget;
+        widget.resize(400, 600);
+        widget.show();
+        settle(&widget);
+
+        QElapsedTimer timer;
+        timer.start();
+        for(int i = 0; i < count; ++i) {
+            widget.addMessage(makeMessage(i), i % 2 == 0);
+        }
+        settle(&widget);
+        const qint64 fillNs = timer.nsecsElapsed();
+        report.add("fill", {{"messages", count}}, fillNs / 1e6, "ms");
+
+        timer.restart();
+        for(int i = 0; i < APPEND_SAMPLES; ++i) {
+            widget.addMessage(makeMessage(count + i), i % 2 == 0);
+            settle(&widget);
+        }
+        report.add("append", {{"messages", count}}, timer.nsecsElapsed() / 1e3 / APPEND_SAMPLES, "us");
+
+        QScrollBar* scrollBar = widget.findChild<ChatListView*>()->verticalScrollBar();
+        timer.restart();
+        for(int i = 0; i < SCROLL_SAMPLES; ++i) {
+            scrollBar->triggerAction(QAbstractSlider::SliderPageStepSub);
+            settle(&widget);
+        }
+        report.add("scroll", {{"messages", count}}, timer.nsecsElapsed() / 1e3 / SCROLL_SAMPLES, "us");
+    }
+
+    return report.write(arguments) ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+QT       += core gui widgets
+
+TARGET = bench_widgets
+
+# 聊天视图基准测试：ChatBubbleWidget::addMessage在不同消息数量下的开销
+include(../bench.pri)
+
+SOURCES += \
+    main.cpp \
+    ../../chatbubblewidget.cpp \
+    ../../chatmessagemodel.cpp \
+    ../../chatlistview.cpp \
+    ../../historylog.cpp
+
+HEADERS += \
+    ../../chatbubblewidget.h \
+    ../../chatmessagemodel.h \
+    ../../chatlistview.h \
+    ../../historylog.h
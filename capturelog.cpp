@@ -0,0 +1,210 @@
+#include "capturelog.h"
+#include <QtEndian>
+#include <QDateTime>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+const char MAGIC[] = "NLCAP1";
+const int MAGIC_SIZE = 8;       ///< 标识加两个保留字节
+const quint32 SENT_FLAG = 0x80000000u;
+
+} // namespace
+
+// ---------------------------------------------------------------- CaptureWriter
+
+CaptureWriter::CaptureWriter()
+    : m_capturedBytes(0)
+{
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    close();
+}
+
+bool CaptureWriter::open(const QString& path)
+{
+    close();
+
+    // 已有自己的缓冲区，不再经过QFile的缓冲
+    m_file.setFileName(path);
+    if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        return false;
+    }
+
+    uchar header[HEADER_SIZE] = {};
+    memcpy(header, MAGIC, sizeof(MAGIC) - 1);
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + MAGIC_SIZE);
+    if(m_file.write(reinterpret_cast<const char*>(header), HEADER_SIZE) != HEADER_SIZE) {
+        m_file.close();
+        return false;
+    }
+
+    m_buffer.reserve(BUFFER_SIZE + RECORD_HEADER_SIZE);
+    m_capturedBytes = 0;
+    m_clock.start();
+    return true;
+}
+
+void CaptureWriter::close()
+{
+    if(m_file.isOpen()) {
+        flush();
+        m_file.close();
+    }
+    m_buffer.clear();
+}
+
+bool CaptureWriter::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString CaptureWriter::path() const
+{
+    return m_file.fileName();
+}
+
+QString CaptureWriter::errorString() const
+{
+    return m_file.errorString();
+}
+
+void CaptureWriter::append(CaptureRecord::Direction direction, const char* data, int size)
+{
+    if(!m_file.isOpen() || size <= 0) {
+        return;
+    }
+
+    uchar header[RECORD_HEADER_SIZE];
+    qToLittleEndian<qint64>(m_clock.nsecsElapsed(), header);
+    qToLittleEndian<quint32>(quint32(size) | (direction == CaptureRecord::Sent ? SENT_FLAG : 0),
+                             header + 8);
+    m_buffer.append(reinterpret_cast<const char*>(header), RECORD_HEADER_SIZE);
+    m_buffer.append(data, size);
+    m_capturedBytes += size;
+
+    if(m_buffer.size() >= BUFFER_SIZE) {
+        flush();
+    }
+}
+
+bool CaptureWriter::flush()
+{
+    if(!m_file.isOpen()) {
+        return false;
+    }
+
+    if(!m_buffer.isEmpty()) {
+        const qint64 written = m_file.write(m_buffer);
+        const bool complete = written == m_buffer.size();
+        m_buffer.clear();
+        if(!complete) {
+            qWarning() << "Capture stopped:" << m_file.fileName() << m_file.errorString();
+            m_file.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+qint64 CaptureWriter::capturedBytes() const
+{
+    return m_capturedBytes;
+}
+
+// ---------------------------------------------------------------- CaptureReader
+
+CaptureReader::CaptureReader()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_pos(0)
+{
+}
+
+CaptureReader::~CaptureReader()
+{
+    close();
+}
+
+bool CaptureReader::open(const QString& path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if(!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+    if(m_size >= CaptureWriter::HEADER_SIZE) {
+        m_data = m_file.map(0, m_size);
+    }
+    if(!m_data || memcmp(m_data, MAGIC, sizeof(MAGIC) - 1) != 0) {
+        m_errorString = m_data ? QStringLiteral("不是捕获文件")
+                               : QStringLiteral("无法映射捕获文件: ") + m_file.errorString();
+        close();
+        return false;
+    }
+
+    m_pos = CaptureWriter::HEADER_SIZE;
+    m_errorString.clear();
+    return true;
+}
+
+void CaptureReader::close()
+{
+    if(m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+        m_data = nullptr;
+    }
+    m_file.close();
+    m_size = 0;
+    m_pos = 0;
+}
+
+bool CaptureReader::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+QString CaptureReader::errorString() const
+{
+    return m_errorString;
+}
+
+qint64 CaptureReader::startTime() const
+{
+    return m_data ? qFromLittleEndian<qint64>(m_data + MAGIC_SIZE) : 0;
+}
+
+bool CaptureReader::next(CaptureRecord& record)
+{
+    if(!m_data || m_size - m_pos < CaptureWriter::RECORD_HEADER_SIZE) {
+        return false;
+    }
+
+    const uchar* header = m_data + m_pos;
+    const quint32 dirLen = qFromLittleEndian<quint32>(header + 8);
+    const qint64 size = dirLen & ~SENT_FLAG;
+    if(m_size - m_pos - CaptureWriter::RECORD_HEADER_SIZE < size) {
+        return false;
+    }
+
+    record.timestamp = qFromLittleEndian<qint64>(header);
+    record.direction = (dirLen & SENT_FLAG) ? CaptureRecord::Sent : CaptureRecord::Received;
+    record.data = reinterpret_cast<const char*>(header + CaptureWriter::RECORD_HEADER_SIZE);
+    record.size = static_cast<int>(size);
+    m_pos += CaptureWriter::RECORD_HEADER_SIZE + size;
+    return true;
+}
+
+void CaptureReader::rewind()
+{
+    if(m_data) {
+        m_pos = CaptureWriter::HEADER_SIZE;
+    }
+}
@@ -0,0 +1,133 @@
+#ifndef CAPTURELOG_H
+#define CAPTURELOG_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QElapsedTimer>
+
+/**
+ * @brief 捕获文件中的一条记录
+ *
+ * 捕获文件记录设备实际收发的原始字节（小端）：
+ * - 文件头：| "NLCAP1" | 00 00 | 开始捕获的时刻(8，Unix毫秒) |
+ * - 记录：  | timestamp(8) | dirLen(4) | 数据 |
+ *   timestamp为相对开始捕获的单调时间(ns)；dirLen最高位为方向（1为发送），其余为数据长度
+ * 接收方向的一条记录即一次读取，保留了驱动上报数据的分块和间隔。
+ */
+struct CaptureRecord
+{
+    enum Direction {
+        Received = 0,   ///< 从设备读到的数据
+        Sent = 1        ///< 交给设备写出的数据
+    };
+
+    qint64 timestamp;       ///< 相对开始捕获的时间(ns)
+    Direction direction;    ///< 方向
+    const char* data;       ///< 数据，指向读取端的映射区域
+    int size;               ///< 数据长度
+};
+
+/**
+ * @brief 捕获文件的写入端
+ *
+ * 记录先追加到内存缓冲区，满BUFFER_SIZE或调用flush()时一次写入文件，
+ * 热路径上只有一次拷贝、没有系统调用。写入失败（如磁盘已满）时停止捕获并给出警告，
+ * 不影响收发。不是线程安全的，须在设备线程使用。
+ */
+class CaptureWriter
+{
+public:
+    CaptureWriter();
+    ~CaptureWriter();
+
+    /**
+     * @brief 新建捕获文件，已存在的文件被覆盖
+     * @return 是否成功，失败原因见errorString()
+     */
+    bool open(const QString& path);
+
+    /**
+     * @brief 写出缓冲的记录并关闭文件
+     */
+    void close();
+
+    bool isOpen() const;
+    QString path() const;
+    QString errorString() const;
+
+    /**
+     * @brief 追加一条记录，时间戳取调用时刻
+     */
+    void append(CaptureRecord::Direction direction, const char* data, int size);
+
+    /**
+     * @brief 把缓冲的记录写入文件
+     * @return 是否成功
+     */
+    bool flush();
+
+    /**
+     * @brief 已捕获的数据字节数，不含记录头
+     */
+    qint64 capturedBytes() const;
+
+    static const int HEADER_SIZE = 16;          ///< 文件头长度
+    static const int RECORD_HEADER_SIZE = 12;   ///< 记录头长度
+
+private:
+    QFile m_file;               ///< 捕获文件
+    QByteArray m_buffer;        ///< 尚未写入文件的记录
+    QElapsedTimer m_clock;      ///< 时间戳使用的单调时钟，打开时开始
+    qint64 m_capturedBytes;     ///< 已捕获的数据字节数
+
+    static const int BUFFER_SIZE = 256 * 1024;  ///< 缓冲区达到该长度即写入文件
+};
+
+/**
+ * @brief 捕获文件的读取端
+ *
+ * 整个文件只读映射到内存，记录数据直接指向映射区域，读取时不拷贝；
+ * 常驻内存由系统按访问的页决定，与文件大小无关。
+ * 文件末尾不完整的记录（捕获时进程被终止）被忽略。
+ */
+class CaptureReader
+{
+public:
+    CaptureReader();
+    ~CaptureReader();
+
+    /**
+     * @brief 打开捕获文件
+     * @return 是否成功，文件不存在或格式不符时为false，原因见errorString()
+     */
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+
+    /**
+     * @brief 开始捕获的时刻(Unix毫秒)
+     */
+    qint64 startTime() const;
+
+    /**
+     * @brief 读取下一条记录
+     * @return 是否读到，到达末尾时为false
+     */
+    bool next(CaptureRecord& record);
+
+    /**
+     * @brief 回到第一条记录
+     */
+    void rewind();
+
+private:
+    QFile m_file;               ///< 捕获文件
+    const uchar* m_data;        ///< 映射区域
+    qint64 m_size;              ///< 文件长度
+    qint64 m_pos;               ///< 下一条记录的偏移
+    QString m_errorString;      ///< 最近一次错误
+};
+
+#endif // CAPTURELOG_H
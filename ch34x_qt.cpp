@@ -1,18 +1,103 @@
 #include "ch34x_qt.h"
+#include "portmonitor.h"
+#include "crc.h"
+#include "serialtransport.h"
+#include <QtEndian>
 #include <QDateTime>
+#include <QMetaMethod>
+#include <QRandomGenerator>
+#include <cctype>
+#include <cstring>
+#ifdef Q_OS_LINUX
+#  include <pthread.h>
+#  include <sched.h>
+#  include <time.h>
+#endif
 
 /**
  * @brief 构造函数实现
  * 初始化串口对象、定时器和缓冲区
- * 设置定时器用于检测设备热插拔
+ * 热插拔检测由进程内共享的PortMonitor完成
  */
-CH34xQt::CH34xQt(QObject *parent) : QObject(parent) {
+CH34xQt::CH34xQt(QObject *parent)
+    : QObject(parent)
+    , m_packageStartFound(false)
+    , m_receiveBurstPeak(0)
+    , m_trimLastBytesRx(0)
+    , m_txSequence(0)
+    , m_rxExpectedSequence(0)
+    , m_rxSequenceValid(false)
+    , m_frameBatchCount(0)
+    , m_frameQueue(nullptr)
+    , m_framesNotified(false)
+    , m_isOpen(false)
+    , m_readPaused(false)
+    , m_resumeScheduled(false)
+    , m_discardingFrame(false)
+    , m_writeQueuedTotal(0)
+    , m_writeDoneTotal(0)
+    , m_writeFlushScheduled(false)
+    , m_writeQueueFull(false)
+    , m_pendingWriteBytes(0)
+    , m_writeHighWaterMark(DEFAULT_WRITE_BUFFER_SIZE)
+    , m_nextWriteId(1)
+    , m_statsStartNs(0)
+    , m_rateLastNs(0)
+    , m_rateLastBytesRx(0)
+    , m_rateLastBytesTx(0)
+    , m_rateLastFramesRx(0)
+    , m_receiveByteRate(0)
+    , m_sendByteRate(0)
+    , m_receiveFrameRate(0)
+    , m_rateLastCpuNs(-1)
+    , m_ioCpuLoad(0)
+    , m_state(Closed)
+    , m_openPhaseStartNs(0)
+    , m_openRetryDelay(OPEN_RETRY_MIN)
+    , m_openTimeout(OPEN_TIMEOUT)
+    , m_reconnectAttempts(0)
+    , m_reconnecting(false)
+    , m_linkLostNs(0)
+    , m_recoveredNs(-1)
+    , m_recoveredAttempts(0)
+    , m_lastReadNs(0)
+    , m_lowLatencyActive(false)
+    , m_threadTuned(false)
+    , m_savedSchedPolicy(0)
+    , m_savedSchedPriority(0)
+{
+    qRegisterMetaType<CH34xQt::Statistics>("CH34xQt::Statistics");
+    qRegisterMetaType<CH34xQt::Frame>("CH34xQt::Frame");
+    qRegisterMetaType<QVector<CH34xQt::Frame>>("QVector<CH34xQt::Frame>");
+    qRegisterMetaType<CH34xQt::OpenTiming>("CH34xQt::OpenTiming");
+    qRegisterMetaType<CH34xQt::DeviceState>("CH34xQt::DeviceState");
+    qRegisterMetaType<QSerialPort::SerialPortError>("QSerialPort::SerialPortError");
+    
     // 初始化基本组件
-    m_serialPort = new QSerialPort(this);
-    m_portCheckTimer = new QTimer(this);
+    m_transport = nullptr;
     m_reconnectTimer = new QTimer(this);
+    m_reconnectTimer->setSingleShot(true);
     m_packageTimer = new QTimer(this);
-    m_receiveBuffer.reserve(BUFFER_SIZE);
+    m_packageTimer->setSingleShot(true);
+    m_packageTimer->setTimerType(Qt::PreciseTimer);
+    m_ioWatchdogTimer = new QTimer(this);
+    m_ioWatchdogTimer->setTimerType(Qt::PreciseTimer);
+    m_writeTimer = new QTimer(this);
+    m_writeTimer->setSingleShot(true);
+    m_writeTimer->setInterval(WRITE_TIMEOUT);
+    m_statsTimer = new QTimer(this);
+    m_openTimer = new QTimer(this);
+    m_openTimer->setSingleShot(true);
+    m_bufferTrimTimer = new QTimer(this);
+    m_bufferTrimTimer->setTimerType(Qt::VeryCoarseTimer);
+    m_captureFlushTimer = new QTimer(this);
+    m_captureFlushTimer->setTimerType(Qt::VeryCoarseTimer);
+    m_captureFlushTimer->setInterval(CAPTURE_FLUSH_INTERVAL);
+    m_receiveBuffer.reserve(INITIAL_BUFFER_CAPACITY);
+    m_lineMatcher.setPattern("\n");
+    m_endMatcher.setPattern("\n");
+    m_binarySyncMatcher.setPattern(QByteArray("\xA5\x5A", 2));
+    m_clock.start();
     
     // 初始化统计信息
     resetStatistics();
@@ -23,29 +108,44 @@ CH34xQt::CH34xQt(QObject *parent) : QObject(parent) {
     m_config.stopBits = QSerialPort::OneStop;
     m_config.parity = QSerialPort::NoParity;
     m_config.flowControl = QSerialPort::NoFlowControl;
-    m_config.readBufferSize = BUFFER_SIZE;
-    m_config.writeBufferSize = BUFFER_SIZE;
-    m_config.autoReconnect = false;
+    m_config.readBufferSize = DEFAULT_READ_BUFFER_SIZE;
+    m_config.writeBufferSize = DEFAULT_WRITE_BUFFER_SIZE;
+    m_config.autoReconnect = true;
     m_config.reconnectInterval = 5000;
-    m_config.maxReconnectAttempts = 3;
+    m_config.maxReconnectAttempts = 0;
     m_config.packageTimeout = 1000;
     m_config.usePackageMode = false;
     m_config.packageEnd = "\n";
+    m_config.framing = LineFraming;
+    m_config.binaryCrc32 = false;
+    m_config.frameGap = 50;
+    m_config.lowLatency = false;
+    m_config.ioThreadCpu = -1;
+    m_config.ioThreadPriority = 0;
+    loadConfig(m_config);
     
     // 连接信号槽
-    connect(m_serialPort, &QSerialPort::readyRead, 
-            this, &CH34xQt::handleReadyRead);
-    connect(m_serialPort, &QSerialPort::errorOccurred,
-            this, &CH34xQt::handleError);
-    connect(m_portCheckTimer, &QTimer::timeout,
-            this, &CH34xQt::checkPorts);
+    connect(m_writeTimer, &QTimer::timeout,
+            this, &CH34xQt::handleWriteTimeout);
+    connect(PortMonitor::instance(), &PortMonitor::portsChanged,
+            this, &CH34xQt::handlePortsChanged);
     connect(m_reconnectTimer, &QTimer::timeout,
             this, &CH34xQt::tryReconnect);
     connect(m_packageTimer, &QTimer::timeout,
-            this, [this]() { emit packageTimeout(); });
+            this, &CH34xQt::handleIdleTimeout);
+    connect(m_ioWatchdogTimer, &QTimer::timeout,
+            this, &CH34xQt::checkIoLatency);
+    connect(m_statsTimer, &QTimer::timeout,
+            this, &CH34xQt::publishStatistics);
+    connect(m_openTimer, &QTimer::timeout,
+            this, &CH34xQt::continueOpen);
+    connect(m_bufferTrimTimer, &QTimer::timeout,
+            this, &CH34xQt::trimBuffers);
+    connect(m_captureFlushTimer, &QTimer::timeout,
+            this, [this]() { m_capture.flush(); });
             
-    m_portCheckTimer->start(2000);
-    m_lastPorts = availablePorts();
+    m_statsTimer->start(DEFAULT_STATS_INTERVAL);
+    m_bufferTrimTimer->start(BUFFER_TRIM_INTERVAL);
 }
 
 /**
@@ -54,7 +154,7 @@ CH34xQt::CH34xQt(QObject *parent) : QObject(parent) {
  */
 CH34xQt::~CH34xQt() {
     closeDevice();
-    delete m_serialPort;
+    delete m_frameQueue;
 }
 
 /**
@@ -62,96 +162,410 @@ CH34xQt::~CH34xQt() {
  * 
  * @details
  * 1. 如果已有打开的设备，先关闭
- * 2. 设置串口参数（默认115200 8N1）
+ * 2. 串口参数已由配置写入串口对象，打开时一次性生效
  * 3. 清空接收缓冲区
- * 4. 等待设备就绪
- * 5. 尝试打开设备
+ * 4. 尝试打开设备
  * 
  * @param portName 要打开的串口名称
  * @return 是否成功打开设备
  */
 bool CH34xQt::openDevice(const QString& portName) {
-    if(m_serialPort->isOpen()) {
+    stopReconnect();
+    if(m_state != Closed) {
         closeDevice();
     }
     
-    m_serialPort->setPortName(portName);
-    
-    // 设置默认的串口参数
-    m_serialPort->setBaudRate(QSerialPort::Baud115200);
-    m_serialPort->setDataBits(QSerialPort::Data8);
-    m_serialPort->setParity(QSerialPort::NoParity);
-    m_serialPort->setStopBits(QSerialPort::OneStop);
-    m_serialPort->setFlowControl(QSerialPort::NoFlowControl);
+    m_config.portName = portName;
+    prepareTransport(portName);
     
     m_receiveBuffer.clear();  // 清空接收缓冲区
+    m_packageStartFound = false;
     
-    QThread::msleep(100);  // 等待设备准备就绪
-    
-    if(!m_serialPort->open(QIODevice::ReadWrite)) {
+    setDeviceState(Opening);
+    if(!m_transport->open()) {
+        setDeviceState(Closed);
         QString errorMsg = tr("无法打开端口 %1: %2\n"
                             "请检查以下可能的原因：\n"
                             "1. 端口是否被其他程序占用\n"
                             "2. 是否有权限访问该端口\n"
                             "3. 设备是否正确连接")
                             .arg(portName)
-                            .arg(m_serialPort->errorString());
+                            .arg(m_transport->errorString());
         emit errorOccurred(errorMsg);
         return false;
     }
     
+    m_isOpen = true;
+    applyLowLatency();
+    setDeviceState(Ready);
+    return true;
+}
+
+/**
+ * @brief 异步打开设备的实现
+ * 
+ * @details
+ * 1. 关闭已打开的设备，载入完整配置
+ * 2. 清空接收缓冲区，开始计时
+ * 3. 进入Opening状态并立即尝试第一次打开
+ * 
+ * @param config 串口配置
+ * @return 是否已开始打开
+ */
+bool CH34xQt::openDeviceAsync(const SerialConfig& config) {
+    if(m_state == Opening || m_state == Configuring) {
+        return false;
+    }
+    
+    stopReconnect();
+    m_recoveredNs = -1;
+    startOpen(config, OPEN_TIMEOUT);
+    return true;
+}
+
+void CH34xQt::startOpen(const SerialConfig& config, int timeout) {
+    if(m_state != Closed) {
+        closeDevice();
+    }
+    
+    loadConfig(config);
+    m_receiveBuffer.clear();
+    m_packageStartFound = false;
+    
+    m_openTiming.openUs = 0;
+    m_openTiming.configureUs = 0;
+    m_openTiming.totalUs = 0;
+    m_openTiming.attempts = 0;
+    m_openRetryDelay = OPEN_RETRY_MIN;
+    m_openTimeout = timeout;
+    m_openClock.start();
+    m_openPhaseStartNs = 0;
+    
+    setDeviceState(Opening);
+    continueOpen();
+}
+
+CH34xQt::DeviceState CH34xQt::state() const {
+    return m_state;
+}
+
+/**
+ * @brief 推进异步打开状态机
+ * 
+ * @details
+ * Opening：
+ * 1. 尝试打开端口，成功则丢弃打开前残留的数据并进入Configuring
+ * 2. 设备节点不存在或无权限时视为设备尚未就绪，退避后重试
+ * 3. 其他错误（如被占用）立即失败
+ * 
+ * Configuring：
+ * 1. 探测传输层是否可以收发，串口读取调制解调器信号线，驱动能响应说明设备已完成初始化
+ * 2. 探测失败则退避后重试，超时即失败
+ * 3. 成功后进入Ready并发出openFinished
+ */
+void CH34xQt::continueOpen() {
+    if(m_state == Opening) {
+        m_openTiming.attempts++;
+        if(m_transport->open()) {
+            const qint64 now = m_openClock.nsecsElapsed();
+            m_openTiming.openUs = (now - m_openPhaseStartNs) / 1000;
+            m_openPhaseStartNs = now;
+            m_openRetryDelay = OPEN_RETRY_MIN;
+            setDeviceState(Configuring);
+            m_transport->clear(QSerialPort::AllDirections);
+            continueOpen();
+            return;
+        }
+        
+        const QSerialPort::SerialPortError error = m_transport->error();
+        const QString errorString = m_transport->errorString();
+        m_transport->clearError();
+        const bool notReadyYet = error == QSerialPort::DeviceNotFoundError ||
+                                 error == QSerialPort::PermissionError;
+        if(!notReadyYet || !scheduleOpenRetry()) {
+            failOpen(tr("无法打开端口 %1: %2\n"
+                        "请检查以下可能的原因：\n"
+                        "1. 端口是否被其他程序占用\n"
+                        "2. 是否有权限访问该端口\n"
+                        "3. 设备是否正确连接")
+                     .arg(m_config.portName)
+                     .arg(errorString));
+        }
+    } else if(m_state == Configuring) {
+        if(m_transport->probe()) {
+            const qint64 now = m_openClock.nsecsElapsed();
+            m_openTiming.configureUs = (now - m_openPhaseStartNs) / 1000;
+            m_openTiming.totalUs = now / 1000;
+            m_isOpen = true;
+            
+            const bool recovered = m_reconnecting;
+            qint64 recoveryUs = 0;
+            if(recovered) {
+                m_recoveredNs = m_clock.nsecsElapsed();
+                m_recoveredAttempts = m_reconnectAttempts;
+                recoveryUs = (m_recoveredNs - m_linkLostNs) / 1000;
+                stopReconnect();
+                m_counters.recoveries.fetch_add(1, std::memory_order_relaxed);
+                m_counters.lastRecoveryUs.store(recoveryUs, std::memory_order_relaxed);
+                updateMax(m_counters.maxRecoveryUs, recoveryUs);
+            }
+            
+            applyLowLatency();
+            setDeviceState(Ready);
+            emit openFinished(true, m_openTiming);
+            if(recovered) {
+                emit reconnected(recoveryUs);
+            }
+            return;
+        }
+        if(!scheduleOpenRetry()) {
+            failOpen(tr("设备 %1 未就绪").arg(m_config.portName));
+        }
+    }
+}
+
+bool CH34xQt::scheduleOpenRetry() {
+    if(m_openClock.elapsed() + m_openRetryDelay > m_openTimeout) {
+        return false;
+    }
+    m_openTimer->start(m_openRetryDelay);
+    m_openRetryDelay = qMin(m_openRetryDelay * 2, int(OPEN_RETRY_MAX));
     return true;
 }
 
+void CH34xQt::failOpen(const QString& message) {
+    m_openTimer->stop();
+    if(m_transport->isOpen()) {
+        m_transport->close();
+    }
+    m_openTiming.totalUs = m_openClock.nsecsElapsed() / 1000;
+    setDeviceState(Closed);
+    
+    // 重连期间设备多半还没回来，逐次失败不作为错误报告
+    const bool reconnecting = m_reconnecting;
+    if(!reconnecting) {
+        emit errorOccurred(message);
+    }
+    emit openFinished(false, m_openTiming);
+    if(reconnecting && m_reconnecting) {
+        scheduleReconnect();
+    }
+}
+
+void CH34xQt::setDeviceState(DeviceState state) {
+    if(m_state == state) {
+        return;
+    }
+    m_state = state;
+    emit stateChanged(state);
+}
+
 /**
  * @brief 关闭当前打开的设备
- * 如果设备已打开则关闭它
+ * 如果设备已打开则关闭它，正在进行的异步打开和等待中的重连会被取消
  */
 void CH34xQt::closeDevice() {
-    if(m_serialPort->isOpen()) {
-        m_serialPort->close();
+    stopReconnect();
+    failPendingWrites();
+    m_openTimer->stop();
+    m_packageTimer->stop();
+    
+    if(m_readPaused) {
+        m_readPaused = false;
+        m_transport->setReadBufferSize(m_config.readBufferSize);
     }
+    m_discardingFrame = false;
+    releaseLowLatency();
+    
+    if(m_transport->isOpen()) {
+        m_transport->close();
+    }
+    m_isOpen = false;
+    setDeviceState(Closed);
 }
 
 /**
  * @brief 发送数据的实现
+ * @param data 要发送的数据
+ * @return 是否成功加入发送队列
+ */
+bool CH34xQt::writeData(const QByteArray& data) {
+    return queueWrite(data) != 0;
+}
+
+/**
+ * @brief 异步发送的实现
  * 
  * @details
  * 1. 检查设备是否打开
- * 2. 确保数据以换行符结束
- * 3. 写入数据并等待完成
+ * 2. 按高水位检查并预占发送队列空间
+ * 3. 分配消息编号，转交设备线程分帧入队
  * 
  * @param data 要发送的数据
- * @return 是否成功发送
+ * @return 消息编号，被拒绝时返回0
  */
-bool CH34xQt::writeData(const QByteArray& data) {
-    if(!m_serialPort->isOpen()) {
+quint32 CH34xQt::queueWrite(const QByteArray& data, quint8 channel) {
+    if(!m_isOpen) {
         emit errorOccurred(tr("设备未打开"));
-        return false;
+        return 0;
+    }
+    
+    const qint64 pending = m_pendingWriteBytes.fetch_add(data.size()) + data.size();
+    if(pending > m_writeHighWaterMark && pending > data.size()) {
+        // 超过高水位，拒绝本条消息；单条超大消息在队列为空时仍允许发送
+        m_pendingWriteBytes.fetch_sub(data.size());
+        m_writeQueueFull = true;
+        return 0;
+    }
+    
+    quint32 id = m_nextWriteId.fetch_add(1);
+    if(id == 0) {
+        id = m_nextWriteId.fetch_add(1);
+    }
+    
+    if(QThread::currentThread() == thread()) {
+        enqueueWrite(id, data, channel);
+    } else {
+        QMetaObject::invokeMethod(this, [this, id, data, channel]() {
+            enqueueWrite(id, data, channel);
+        }, Qt::QueuedConnection);
+    }
+    return id;
+}
+
+qint64 CH34xQt::pendingWriteBytes() const {
+    return m_pendingWriteBytes;
+}
+
+/**
+ * @brief 分帧并加入发送暂存区
+ * 
+ * @details
+ * 1. 确保数据以换行符结束（数据包模式下添加起止标记，二进制模式下编码成帧）
+ * 2. 修正预占的队列字节数
+ * 3. 安排一次合并写出，同一轮事件循环内的多条消息会合并成一次写操作
+ */
+void CH34xQt::enqueueWrite(quint32 id, const QByteArray& data, quint8 channel) {
+    if(!m_transport->isOpen() ||
+       (m_config.framing == BinaryFraming && data.size() > BINARY_MAX_PAYLOAD)) {
+        m_pendingWriteBytes.fetch_sub(data.size());
+        emit writeCompleted(id, false);
+        return;
     }
     
     QByteArray sendData = data;
-    if(m_config.usePackageMode) {
-        if(!m_config.packageStart.isEmpty()) {
-            sendData.prepend(m_config.packageStart.toUtf8());
+    if(m_config.framing == BinaryFraming) {
+        sendData = encodeBinaryFrame(data, channel, m_txSequence++, m_config.binaryCrc32);
+    } else if(m_config.framing == MarkerFraming) {
+        if(!m_startMatcher.isEmpty()) {
+            sendData.prepend(m_startMatcher.pattern());
         }
-        if(!m_config.packageEnd.isEmpty()) {
-            sendData.append(m_config.packageEnd.toUtf8());
+        if(!m_endMatcher.isEmpty()) {
+            sendData.append(m_endMatcher.pattern());
         }
-    } else if(!sendData.endsWith('\n')) {
+    } else if(m_config.framing != GapFraming && !sendData.endsWith('\n')) {
+        // GapFraming按原样发送，帧边界由发送节奏决定
         sendData.append('\n');
     }
+    m_pendingWriteBytes.fetch_add(sendData.size() - data.size());
+    
+    m_writeBuffer.append(sendData);
+    m_counters.writeBufferCapacity.store(m_writeBuffer.capacity(), std::memory_order_relaxed);
+    updateMax(m_counters.writeBufferPeak, m_writeBuffer.capacity());
+    m_writeQueuedTotal += sendData.size();
+    
+    PendingWrite pending;
+    pending.id = id;
+    pending.size = sendData.size();
+    pending.endOffset = m_writeQueuedTotal;
+    m_pendingWrites.append(pending);
+    
+    if(!m_writeFlushScheduled) {
+        m_writeFlushScheduled = true;
+        QMetaObject::invokeMethod(this, [this]() {
+            m_writeFlushScheduled = false;
+            flushWriteQueue();
+        }, Qt::QueuedConnection);
+    }
+}
+
+void CH34xQt::flushWriteQueue() {
+    if(!m_transport->isOpen()) {
+        return;
+    }
     
-    qint64 bytesWritten = m_serialPort->write(sendData);
-    if(bytesWritten != sendData.size()) {
-        if(!m_serialPort->waitForBytesWritten(3000)) {
-            emit errorOccurred(tr("数据写入超时"));
-            return false;
+    while(!m_writeBuffer.isEmpty() && m_transport->bytesToWrite() < WRITE_CHUNK_SIZE) {
+        const int chunk = qMin(m_writeBuffer.size(), int(WRITE_CHUNK_SIZE));
+        const qint64 written = m_transport->write(m_writeBuffer.data(), chunk);
+        if(written <= 0) {
+            break;
         }
+        m_capture.append(CaptureRecord::Sent, m_writeBuffer.data(), static_cast<int>(written));
+        m_writeBuffer.consume(static_cast<int>(written));
     }
     
-    updateStatistics(0, bytesWritten, 0, 1);
-    return true;
+    if(!m_pendingWrites.isEmpty() && !m_writeTimer->isActive()) {
+        m_writeTimer->start();
+    }
+}
+
+/**
+ * @brief 处理写出进度
+ * 
+ * @details
+ * 1. 累加已写出字节数，结束所有最后一个字节已写出的消息
+ * 2. 低于低水位时通知调用方可继续发送
+ * 3. 继续交付暂存区中的数据
+ */
+void CH34xQt::handleBytesWritten(qint64 bytes) {
+    m_writeDoneTotal += bytes;
+    
+    while(!m_pendingWrites.isEmpty() && m_pendingWrites.first().endOffset <= m_writeDoneTotal) {
+        const PendingWrite done = m_pendingWrites.takeFirst();
+        m_pendingWriteBytes.fetch_sub(done.size);
+        updateStatistics(0, done.size, 0, 1);
+        emit writeCompleted(done.id, true);
+    }
+    
+    if(m_pendingWrites.isEmpty()) {
+        m_writeTimer->stop();
+    } else {
+        m_writeTimer->start();  // 有进展，重新计时
+    }
+    
+    if(m_pendingWriteBytes < m_writeHighWaterMark / 2 && m_writeQueueFull.exchange(false)) {
+        emit writeQueueDrained();
+    }
+    
+    flushWriteQueue();
+}
+
+void CH34xQt::handleWriteTimeout() {
+    if(m_pendingWrites.isEmpty()) {
+        return;
+    }
+    
+    m_transport->clear(QSerialPort::Output);
+    failPendingWrites();
+    emit errorOccurred(tr("数据写入超时"));
+}
+
+void CH34xQt::failPendingWrites() {
+    m_writeTimer->stop();
+    m_writeBuffer.clear();
+    m_writeQueuedTotal = m_writeDoneTotal = 0;
+    
+    const QList<PendingWrite> failed = m_pendingWrites;
+    m_pendingWrites.clear();
+    for(const PendingWrite& pending : failed) {
+        m_pendingWriteBytes.fetch_sub(pending.size);
+        m_counters.errors.fetch_add(1, std::memory_order_relaxed);
+        emit writeCompleted(pending.id, false);
+    }
+    
+    if(m_writeQueueFull.exchange(false)) {
+        emit writeQueueDrained();
+    }
 }
 
 /**
@@ -159,7 +573,7 @@ bool CH34xQt::writeData(const QByteArray& data) {
  * @return 设备打开状态
  */
 bool CH34xQt::isOpen() const {
-    return m_serialPort->isOpen();
+    return m_isOpen;
 }
 
 /**
@@ -175,7 +589,15 @@ bool CH34xQt::isOpen() const {
  * 
  * @return 可用的CH34x设备串口名称列表
  */
-QStringList CH34xQt::availablePorts() {
+QStringList CH34xQt::availablePorts(bool includeVirtual) {
+    QStringList ports = PortMonitor::instance()->ports();
+    if(includeVirtual) {
+        ports << SerialTransport::virtualPorts();
+    }
+    return ports;
+}
+
+QStringList CH34xQt::enumeratePorts() {
     QStringList result;
     
     for(const QSerialPortInfo& info : QSerialPortInfo::availablePorts()) {
@@ -197,26 +619,124 @@ QStringList CH34xQt::availablePorts() {
  * @brief 处理串口数据可读事件
  * 
  * @details
- * 1. 读取所有可用数据
- * 2. 添加到接收缓冲区
- * 3. 如果缓冲区过大，清理旧数据
+ * 1. 暂停读取期间直接返回，数据留在串口缓冲中形成背压
+ * 2. 读取所有可用数据并添加到接收缓冲区，记录与上次读取的间隔
+ * 3. 需要空闲超时的分帧方式在定时器空闲时设置截止时间，不在每次读取时重启定时器
  * 4. 处理接收到的数据包
+ * 5. 剩余数据是一个尚未结束的帧，超过缓冲区上限时整帧丢弃并计数
+ * 6. 帧队列达到高水位时暂停读取
  */
 void CH34xQt::handleReadyRead() {
-    QByteArray newData = m_serialPort->readAll();
+    if(m_readPaused) {
+        return;
+    }
+    
+    QByteArray newData = m_transport->readAll();
+    m_capture.append(CaptureRecord::Received, newData.constData(), newData.size());
     updateStatistics(newData.size(), 0, 0, 0);
+    recordReadSize(newData.size());
+    
+    const qint64 now = m_clock.nsecsElapsed();
+    if(m_lastReadNs > 0) {
+        recordReadGap(now - m_lastReadNs,
+                      m_config.framing == GapFraming && !m_receiveBuffer.isEmpty());
+    }
+    m_lastReadNs = now;
     
     m_receiveBuffer.append(newData);
+    m_receiveBurstPeak = qMax(m_receiveBurstPeak, m_receiveBuffer.size());
+    m_counters.receiveBufferCapacity.store(m_receiveBuffer.capacity(), std::memory_order_relaxed);
+    updateMax(m_counters.receiveBufferPeak, m_receiveBuffer.capacity());
+    
+    const int timeout = idleTimeout();
+    if(timeout > 0 && !m_packageTimer->isActive()) {
+        m_packageTimer->start(timeout);
+    }
+    
+    processBuffer();
+    
+    if(m_receiveBuffer.size() > BUFFER_SIZE && m_config.framing != BinaryFraming) {
+        // 帧的其余部分在parseFrames中丢弃到下一个分隔符为止，届时计为一帧
+        recordDrop(m_receiveBuffer.size(), 0);
+        m_receiveBuffer.clear();
+        m_packageStartFound = false;
+        m_discardingFrame = true;
+    }
+    m_counters.receiveBufferBytes.store(m_receiveBuffer.size(), std::memory_order_relaxed);
+    
+    if(m_frameQueue && m_frameQueue->size() >= m_frameQueue->capacity() * 3 / 4) {
+        pauseReading();
+    }
+    
+    notifyFramesPending();
+}
+
+void CH34xQt::notifyFramesPending() {
+    // 队列由空变为非空后只通知一次，消费者取空队列前不再重复投递事件
+    if(m_frameQueue && m_frameQueue->size() > 0 && !m_framesNotified.exchange(true)) {
+        emit framesPending();
+    }
+}
+
+int CH34xQt::idleTimeout() const {
+    switch(m_config.framing) {
+        case GapFraming:
+            return m_config.frameGap;
+        case MarkerFraming:
+            return m_config.packageTimeout;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief 空闲截止时间到达
+ * 
+ * @details
+ * 1. 定时器只在空闲时设置，期间到达的数据不会重启它，
+ *    因此先按最后一次读取的时刻计算实际空闲了多久
+ * 2. 不足超时则按剩余时间顺延，到期时与最后一个字节的间隔正好是超时时间
+ * 3. 足够空闲时GapFraming结束当前帧，MarkerFraming发出packageTimeout
+ */
+void CH34xQt::handleIdleTimeout() {
+    const int timeout = idleTimeout();
+    if(timeout <= 0) {
+        return;
+    }
     
-    if(m_receiveBuffer.size() > BUFFER_SIZE) {
-        m_receiveBuffer = m_receiveBuffer.right(BUFFER_SIZE / 2);
+    const qint64 idleNs = m_clock.nsecsElapsed() - m_lastReadNs;
+    const qint64 timeoutNs = qint64(timeout) * 1000000;
+    if(idleNs < timeoutNs) {
+        m_packageTimer->start(static_cast<int>((timeoutNs - idleNs + 999999) / 1000000));
+        return;
     }
     
-    if(m_config.usePackageMode) {
-        m_packageTimer->start(); // 重置超时定时器
+    if(m_config.framing == GapFraming) {
+        flushGapFrame();
+    } else {
+        emit packageTimeout();
+    }
+}
+
+void CH34xQt::flushGapFrame() {
+    if(m_receiveBuffer.isEmpty()) {
+        return;
     }
     
+    if(m_discardingFrame) {
+        // 超长帧的前段已在handleReadyRead中丢弃，这里丢弃剩余部分并计为一帧
+        recordDrop(m_receiveBuffer.size(), 1);
+        m_discardingFrame = false;
+    } else {
+        const char* data = m_receiveBuffer.data();
+        const int size = m_receiveBuffer.size();
+        deliverFrame(QByteArray(data, size), Utf8Validator::validate(data, size));
+    }
+    m_receiveBuffer.clear();
+    m_counters.receiveBufferBytes.store(0, std::memory_order_relaxed);
+    
     processBuffer();
+    notifyFramesPending();
 }
 
 /**
@@ -232,7 +752,8 @@ void CH34xQt::handleReadyRead() {
  * @param error 错误类型
  */
 void CH34xQt::handleError(QSerialPort::SerialPortError error) {
-    if(error == QSerialPort::NoError) {
+    // 异步打开期间的错误由状态机处理，结束时统一报告
+    if(error == QSerialPort::NoError || m_state == Opening || m_state == Configuring) {
         return;
     }
     
@@ -241,12 +762,29 @@ void CH34xQt::handleError(QSerialPort::SerialPortError error) {
         case QSerialPort::PermissionError:
         case QSerialPort::OpenError:
             emit errorOccurred(tr("串口错误: %1")
-                          .arg(m_serialPort->errorString()));
+                          .arg(m_transport->errorString()));
             break;
             
         case QSerialPort::ResourceError:
+            // 关闭后传输层可能再次报告同一错误，只处理第一次
+            if(m_state != Ready) {
+                break;
+            }
+            if(!canReconnect()) {
+                // 对端已经结束，重新打开只会接上同一个已关闭的输入
+                const QString reason = m_transport->errorString();
+                closeDevice();
+                emit errorOccurred(tr("连接已结束: %1").arg(reason));
+                break;
+            }
             closeDevice();
-            emit errorOccurred(tr("设备已断开连接"));
+            if(m_config.autoReconnect) {
+                // 重连过程只通过reconnecting通知，放弃重连时才作为错误报告
+                startReconnect();
+                emit reconnecting(0, m_config.maxReconnectAttempts);
+            } else {
+                emit errorOccurred(tr("设备已断开连接"));
+            }
             break;
             
         default:
@@ -254,28 +792,14 @@ void CH34xQt::handleError(QSerialPort::SerialPortError error) {
     }
 }
 
-/**
- * @brief 检查设备列表变化
- * 
- * @details
- * 定期检查可用设备列表，如有变化则发出信号
- * 用于实现设备热插拔检测
- */
-void CH34xQt::checkPorts() {
-    QStringList currentPorts = availablePorts();
-    if(currentPorts != m_lastPorts) {
-        m_lastPorts = currentPorts;
-        emit portsChanged();
-    }
-}
-
 /**
  * @brief 处理接收缓冲区数据
  * 
  * @details
- * 1. 查找完整的数据包（以换行符分隔）
+ * 1. 从上次扫描停止处继续查找完整的数据包（以换行符分隔）
  * 2. 处理UTF-8编码
- * 3. 发出数据接收信号
+ * 3. 移动读游标消费该数据包，不拷贝剩余数据
+ * 4. 本次解析出的所有数据包通过一次framesReceived发出
  * 
  * 数据包格式：
  * - 以换行符分隔
@@ -283,128 +807,517 @@ void CH34xQt::checkPorts() {
  * - 如果不是UTF-8则尝试本地编码
  */
 void CH34xQt::processBuffer() {
-    if(m_config.usePackageMode) {
+    parseFrames();
+    
+    // 本次读取解析出的所有帧合并成一次统计更新和一次信号发送
+    if(m_frameBatchCount > 0) {
+        updateStatistics(0, 0, m_frameBatchCount, 0);
+        m_frameBatchCount = 0;
+    }
+    if(!m_frameBatch.isEmpty()) {
+        QVector<Frame> batch;
+        batch.swap(m_frameBatch);
+        emit framesReceived(batch);
+    }
+}
+
+/**
+ * @brief 从接收缓冲区中解析出全部完整的数据帧
+ */
+void CH34xQt::parseFrames() {
+    if(m_config.framing == GapFraming) {
+        // 帧在线路空闲时由flushGapFrame()结束
+        return;
+    }
+    
+    if(m_discardingFrame) {
+        // 丢弃超长帧的剩余部分，直到该帧的结束分隔符
+        const FrameMatcher& end = m_config.framing == MarkerFraming ? m_endMatcher : m_lineMatcher;
+        const int endPos = end.indexIn(m_receiveBuffer.data(), m_receiveBuffer.size(), 0);
+        if(endPos < 0) {
+            const int keep = qMin(m_receiveBuffer.size(), qMax(0, end.size() - 1));
+            recordDrop(m_receiveBuffer.size() - keep, 0);
+            m_receiveBuffer.consume(m_receiveBuffer.size() - keep);
+            m_receiveBuffer.setScanPos(0);
+            return;
+        }
+        recordDrop(endPos + end.size(), 1);
+        m_receiveBuffer.consume(endPos + end.size());
+        m_receiveBuffer.setScanPos(0);
+        m_discardingFrame = false;
+    }
+    
+    if(m_config.framing == BinaryFraming) {
+        parseBinaryFrames();
+    } else if(m_config.framing == MarkerFraming) {
         // 数据包模式处理
+        if(m_endMatcher.isEmpty()) {
+            return;
+        }
+        
         while(!m_receiveBuffer.isEmpty()) {
-            int startPos = 0;
-            if(!m_config.packageStart.isEmpty()) {
-                startPos = m_receiveBuffer.indexOf(m_config.packageStart.toUtf8());
-                if(startPos < 0) break;
-                startPos += m_config.packageStart.length();
-            }
+            const char* data = m_receiveBuffer.data();
+            const int size = m_receiveBuffer.size();
             
-            int endPos = m_receiveBuffer.indexOf(m_config.packageEnd.toUtf8(), startPos);
-            if(endPos < 0) break;
+            if(!m_startMatcher.isEmpty() && !m_packageStartFound) {
+                int startPos = m_startMatcher.indexIn(data, size, m_receiveBuffer.scanPos());
+                if(startPos < 0) {
+                    // 起始标记前的数据无用，只保留可能是半个标记的尾部
+                    m_receiveBuffer.consume(size - (m_startMatcher.size() - 1));
+                    m_receiveBuffer.setScanPos(0);
+                    break;
+                }
+                m_receiveBuffer.consume(startPos);
+                m_receiveBuffer.setScanPos(m_startMatcher.size());
+                m_packageStartFound = true;
+                continue;
+            }
             
-            QByteArray packet = m_receiveBuffer.mid(startPos, endPos - startPos);
-            m_receiveBuffer = m_receiveBuffer.mid(endPos + m_config.packageEnd.length());
+            const int bodyPos = m_packageStartFound ? m_startMatcher.size() : 0;
+            int endPos = m_endMatcher.indexIn(data, size, qMax(bodyPos, m_receiveBuffer.scanPos()));
+            if(endPos < 0) {
+                // 下次从可能是半个结束标记的位置继续扫描
+                m_receiveBuffer.setScanPos(qMax(bodyPos, size - m_endMatcher.size() + 1));
+                break;
+            }
             
-            if(!packet.isEmpty()) {
-                emit dataReceived(packet);
-                updateStatistics(0, 0, 1, 0);
+            if(endPos > bodyPos) {
+                const char* body = m_receiveBuffer.data() + bodyPos;
+                const int bodySize = endPos - bodyPos;
+                deliverFrame(QByteArray(body, bodySize),
+                             Utf8Validator::validate(body, bodySize));
             }
+            
+            m_receiveBuffer.consume(endPos + m_endMatcher.size());
+            m_receiveBuffer.setScanPos(0);
+            m_packageStartFound = false;
         }
     } else {
         // 原有的处理逻辑
-        static const int MIN_PACKET_SIZE = 1;
-        while(m_receiveBuffer.size() >= MIN_PACKET_SIZE) {
-            int endPos = m_receiveBuffer.indexOf('\n');
-            if(endPos < 0) break;
+        while(!m_receiveBuffer.isEmpty()) {
+            const char* data = m_receiveBuffer.data();
+            const int size = m_receiveBuffer.size();
+            const int scanPos = m_receiveBuffer.scanPos();
             
-            QByteArray packet = m_receiveBuffer.left(endPos);
-            m_receiveBuffer = m_receiveBuffer.mid(endPos + 1);
-            packet = packet.trimmed();
+            const int endPos = m_lineMatcher.indexIn(data, size, scanPos);
+            if(endPos < 0) {
+                m_receiveBuffer.setScanPos(size);
+                break;
+            }
             
-            if(!packet.isEmpty()) {
-                QTextCodec *codec = QTextCodec::codecForName("UTF-8");
-                QTextCodec::ConverterState state;
-                QString text = codec->toUnicode(packet.constData(), packet.size(), &state);
-                
-                if(state.invalidChars == 0) {
-                    emit dataReceived(packet);
-                } else {
-                    text = QString::fromLocal8Bit(packet);
-                    emit dataReceived(text.toUtf8());
-                }
-                updateStatistics(0, 0, 1, 0);
+            // 在缓冲区内就地去除首尾空白，避免trimmed()产生额外拷贝
+            int begin = 0;
+            int end = endPos;
+            while(begin < end && isspace(static_cast<uchar>(data[begin]))) ++begin;
+            while(end > begin && isspace(static_cast<uchar>(data[end - 1]))) --end;
+            
+            if(end > begin) {
+                // 只校验不解码，结果随帧传递，由使用方一次性解码
+                deliverFrame(QByteArray(data + begin, end - begin),
+                             Utf8Validator::validate(data + begin, end - begin));
+            }
+            
+            m_receiveBuffer.consume(endPos + 1);
+            m_receiveBuffer.setScanPos(0);
+        }
+    }
+}
+
+/**
+ * @brief 解析二进制帧
+ * 
+ * @details
+ * 1. 查找同步字A5 5A，之前的字节无法组成帧，直接丢弃
+ * 2. 帧头到齐后校验CRC-8，失败说明同步字是负载中的偶然数据，跳过后重新查找
+ * 3. 按长度字段等待整帧到齐，期间不再扫描负载
+ * 4. 校验负载CRC，失败则同样跳过同步字重新查找
+ * 5. 检查序号连续性，交付负载
+ */
+void CH34xQt::parseBinaryFrames() {
+    const std::memory_order relaxed = std::memory_order_relaxed;
+    
+    while(m_receiveBuffer.size() >= BINARY_HEADER_SIZE) {
+        const char* data = m_receiveBuffer.data();
+        const int size = m_receiveBuffer.size();
+        
+        const int syncPos = m_binarySyncMatcher.indexIn(data, size, 0);
+        if(syncPos < 0) {
+            // 保留可能是半个同步字的最后一个字节
+            m_receiveBuffer.consume(size - 1);
+            break;
+        }
+        if(syncPos > 0) {
+            m_receiveBuffer.consume(syncPos);
+            continue;
+        }
+        
+        const uchar* header = reinterpret_cast<const uchar*>(data);
+        if(Crc::crc8(data, BINARY_HEADER_SIZE - 1) != header[BINARY_HEADER_SIZE - 1]) {
+            m_counters.framingErrors.fetch_add(1, relaxed);
+            m_receiveBuffer.consume(2);
+            continue;
+        }
+        
+        const bool crc32 = (header[2] & 0x01) != 0;
+        const quint8 channel = header[3];
+        const quint16 sequence = qFromLittleEndian<quint16>(header + 4);
+        const int length = qFromLittleEndian<quint16>(header + 6);
+        const int trailer = crc32 ? 4 : 2;
+        const int total = BINARY_HEADER_SIZE + length + trailer;
+        if(size < total) {
+            break;  // 等待帧的其余部分
+        }
+        
+        const char* payload = data + BINARY_HEADER_SIZE;
+        const uchar* crcField = header + BINARY_HEADER_SIZE + length;
+        const bool crcOk = crc32
+                ? Crc::crc32c(payload, length) == qFromLittleEndian<quint32>(crcField)
+                : Crc::crc16(payload, length) == qFromLittleEndian<quint16>(crcField);
+        if(!crcOk) {
+            m_counters.crcErrors.fetch_add(1, relaxed);
+            m_receiveBuffer.consume(2);
+            continue;
+        }
+        
+        if(m_rxSequenceValid && sequence != m_rxExpectedSequence) {
+            m_counters.sequenceErrors.fetch_add(
+                        static_cast<quint16>(sequence - m_rxExpectedSequence), relaxed);
+        }
+        m_rxExpectedSequence = static_cast<quint16>(sequence + 1);
+        m_rxSequenceValid = true;
+        
+        deliverFrame(QByteArray(payload, length), Utf8Validator::validate(payload, length),
+                     channel, sequence);
+        m_receiveBuffer.consume(total);
+    }
+    m_receiveBuffer.setScanPos(0);
+}
+
+QByteArray CH34xQt::encodeBinaryFrame(const QByteArray& payload, quint8 channel,
+                                      quint16 sequence, bool crc32)
+{
+    if(payload.size() > BINARY_MAX_PAYLOAD) {
+        return QByteArray();
+    }
+    
+    const int trailer = crc32 ? 4 : 2;
+    QByteArray frame(BINARY_HEADER_SIZE + payload.size() + trailer, Qt::Uninitialized);
+    uchar* p = reinterpret_cast<uchar*>(frame.data());
+    p[0] = 0xA5;
+    p[1] = 0x5A;
+    p[2] = crc32 ? 0x01 : 0x00;
+    p[3] = channel;
+    qToLittleEndian<quint16>(sequence, p + 4);
+    qToLittleEndian<quint16>(static_cast<quint16>(payload.size()), p + 6);
+    p[8] = Crc::crc8(frame.constData(), BINARY_HEADER_SIZE - 1);
+    
+    std::memcpy(p + BINARY_HEADER_SIZE, payload.constData(), static_cast<size_t>(payload.size()));
+    uchar* crcField = p + BINARY_HEADER_SIZE + payload.size();
+    if(crc32) {
+        qToLittleEndian<quint32>(Crc::crc32c(payload.constData(), payload.size()), crcField);
+    } else {
+        qToLittleEndian<quint16>(Crc::crc16(payload.constData(), payload.size()), crcField);
+    }
+    return frame;
+}
+
+/**
+ * @brief 交付数据帧
+ * 
+ * @details
+ * 帧队列模式下帧被写入无锁队列，队列已满时丢弃并计数，
+ * 保证I/O线程不会因为GUI线程繁忙而阻塞。
+ * 
+ * 直接模式下帧先暂存，processBuffer结束时通过framesReceived一次发出；
+ * 逐帧的frameReceived/dataReceived仅在有连接时才发出以保持兼容，
+ * 其中dataReceived在行模式下会把非UTF-8数据按本地编码转换为UTF-8。
+ */
+void CH34xQt::deliverFrame(const QByteArray& packet, Utf8Validator::Result encoding,
+                           quint8 channel, quint16 sequence)
+{
+    Frame frame;
+    frame.data = packet;
+    frame.timestamp = m_clock.nsecsElapsed();
+    frame.encoding = encoding;
+    frame.channel = channel;
+    frame.sequence = sequence;
+    m_frameBatchCount++;
+    recordFrameSize(packet.size());
+    
+    if(!m_frameQueue) {
+        static const QMetaMethod frameSignal = QMetaMethod::fromSignal(&CH34xQt::frameReceived);
+        static const QMetaMethod dataSignal = QMetaMethod::fromSignal(&CH34xQt::dataReceived);
+        
+        m_frameBatch.append(frame);
+        if(isSignalConnected(frameSignal)) {
+            emit frameReceived(frame);
+        }
+        if(isSignalConnected(dataSignal)) {
+            if(encoding == Utf8Validator::Invalid && m_config.framing == LineFraming) {
+                emit dataReceived(QString::fromLocal8Bit(packet).toUtf8());
+            } else {
+                emit dataReceived(packet);
             }
         }
+        return;
+    }
+    
+    if(!m_frameQueue->push(frame)) {
+        m_counters.frameQueueOverflows.fetch_add(1, std::memory_order_relaxed);
+        recordDrop(packet.size(), 1);
+    }
+}
+
+void CH34xQt::trimBuffers()
+{
+    const qint64 bytesRx = m_counters.bytesReceived.load(std::memory_order_relaxed);
+    if(bytesRx == m_trimLastBytesRx) {
+        m_receiveBuffer.shrink(qMax(int(INITIAL_BUFFER_CAPACITY), m_receiveBurstPeak * 2));
+        m_receiveBurstPeak = 0;
+    }
+    m_trimLastBytesRx = bytesRx;
+    
+    if(m_writeBuffer.isEmpty()) {
+        m_writeBuffer.shrink(INITIAL_BUFFER_CAPACITY);
+    }
+    
+    m_counters.receiveBufferCapacity.store(m_receiveBuffer.capacity(), std::memory_order_relaxed);
+    m_counters.writeBufferCapacity.store(m_writeBuffer.capacity(), std::memory_order_relaxed);
+}
+
+void CH34xQt::recordDrop(qint64 bytes, qint64 frames)
+{
+    m_counters.droppedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    m_counters.droppedFrames.fetch_add(frames, std::memory_order_relaxed);
+}
+
+void CH34xQt::pauseReading()
+{
+    if(m_readPaused) {
+        return;
+    }
+    m_readPaused = true;
+    m_counters.readPauses.fetch_add(1, std::memory_order_relaxed);
+    
+    const qint64 limit = m_config.readBufferSize;
+    if(limit <= 0 || limit > PAUSED_READ_BUFFER_SIZE) {
+        m_transport->setReadBufferSize(PAUSED_READ_BUFFER_SIZE);
+    }
+    
+    // 消费者可能在设置标记之前已经取空队列，此时由这里安排恢复
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_frameQueue->size() <= m_frameQueue->capacity() / 4 &&
+       !m_resumeScheduled.exchange(true)) {
+        QMetaObject::invokeMethod(this, [this]() { resumeReading(); }, Qt::QueuedConnection);
+    }
+}
+
+void CH34xQt::resumeReading()
+{
+    m_resumeScheduled = false;
+    if(!m_readPaused) {
+        return;
+    }
+    m_readPaused = false;
+    m_transport->setReadBufferSize(m_config.readBufferSize);
+    
+    // 暂停期间积压在串口缓冲中的数据不会再次触发readyRead
+    if(m_transport->isOpen() && m_transport->bytesAvailable() > 0) {
+        handleReadyRead();
     }
 }
 
+void CH34xQt::enableFrameQueue(int capacity)
+{
+    if(m_frameQueue) {
+        return;
+    }
+    
+    m_frameQueue = new SpscQueue<Frame>(capacity);
+    m_ioWatchdogClock.start();
+    m_ioWatchdogTimer->start(IO_WATCHDOG_INTERVAL);
+}
+
+int CH34xQt::takeFrames(QVector<Frame>& frames)
+{
+    if(!m_frameQueue) {
+        return 0;
+    }
+    
+    // 先清除通知标记再取数据，保证之后入队的帧一定会再次触发framesPending
+    m_framesNotified = false;
+    
+    const qint64 now = m_clock.nsecsElapsed();
+    qint64 maxLatency = 0;
+    int count = 0;
+    Frame frame;
+    while(m_frameQueue->pop(frame)) {
+        maxLatency = qMax(maxLatency, now - frame.timestamp);
+        frames.append(frame);
+        count++;
+    }
+    
+    updateMax(m_counters.maxHandoffLatencyNs, maxLatency);
+    
+    // 回落到低水位后通知设备线程恢复读取
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_readPaused && m_frameQueue->size() <= m_frameQueue->capacity() / 4 &&
+       !m_resumeScheduled.exchange(true)) {
+        QMetaObject::invokeMethod(this, [this]() { resumeReading(); }, Qt::QueuedConnection);
+    }
+    return count;
+}
+
+void CH34xQt::checkIoLatency()
+{
+    const qint64 elapsedUs = m_ioWatchdogClock.nsecsElapsed() / 1000;
+    m_ioWatchdogClock.restart();
+    
+    const qint64 lateUs = elapsedUs - IO_WATCHDOG_INTERVAL * 1000;
+    updateMax(m_counters.maxIoLatencyUs, lateUs);
+    
+    int bucket = 0;
+    while(bucket < WAKE_LATENCY_BUCKETS - 1 && lateUs > (qint64(10) << bucket)) {
+        ++bucket;
+    }
+    m_counters.wakeLatencyHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
 // 串口参数设置函数组实现
 void CH34xQt::setBaudRate(qint32 baudRate)
 {
-    if(m_serialPort && m_serialPort->isOpen()) {
-        m_serialPort->setBaudRate(baudRate);
-    }
+    // 端口关闭时传输层只记录参数，打开时生效
+    m_config.baudRate = baudRate;
+    m_transport->setBaudRate(baudRate);
 }
 
 void CH34xQt::setDataBits(QSerialPort::DataBits dataBits)
 {
-    if(m_serialPort && m_serialPort->isOpen()) {
-        m_serialPort->setDataBits(dataBits);
-    }
+    m_config.dataBits = dataBits;
+    m_transport->setDataBits(dataBits);
 }
 
 void CH34xQt::setStopBits(QSerialPort::StopBits stopBits)
 {
-    if(m_serialPort && m_serialPort->isOpen()) {
-        m_serialPort->setStopBits(stopBits);
-    }
+    m_config.stopBits = stopBits;
+    m_transport->setStopBits(stopBits);
 }
 
 void CH34xQt::setParity(QSerialPort::Parity parity)
 {
-    if(m_serialPort && m_serialPort->isOpen()) {
-        m_serialPort->setParity(parity);
-    }
+    m_config.parity = parity;
+    m_transport->setParity(parity);
 }
 
 void CH34xQt::setFlowControl(QSerialPort::FlowControl flowControl)
 {
-    if(m_serialPort && m_serialPort->isOpen()) {
-        m_serialPort->setFlowControl(flowControl);
-    }
+    m_config.flowControl = flowControl;
+    m_transport->setFlowControl(flowControl);
 }
 
 void CH34xQt::setReadBufferSize(qint64 size)
 {
-    if(m_serialPort) {
-        m_serialPort->setReadBufferSize(size);
-    }
+    m_config.readBufferSize = static_cast<int>(size);
+    m_transport->setReadBufferSize(size);
+}
+
+void CH34xQt::setWriteBufferSize(qint64 size)
+{
+    m_config.writeBufferSize = static_cast<int>(size);
+    m_writeHighWaterMark = size;
 }
 
+/**
+ * @brief 应用串口配置的实现
+ * 
+ * @details
+ * 端口已打开且端口名不变时直接修改参数，不再关闭重开；
+ * 否则载入配置后打开一次，参数随open()一次性生效
+ */
 bool CH34xQt::applyConfig(const SerialConfig& config)
 {
-    if(m_serialPort->isOpen()) {
-        closeDevice();
+    if(config.portName.isEmpty()) {
+        loadConfig(config);
+        return false;
     }
     
+    if(m_state == Ready && config.portName == m_config.portName) {
+        loadConfig(config);
+        return true;
+    }
+    
+    if(m_state != Closed) {
+        closeDevice();
+    }
+    loadConfig(config);
+    return openDevice(config.portName);
+}
+
+void CH34xQt::loadConfig(const SerialConfig& config)
+{
+    const QString previousCapture = m_config.capturePath;
     m_config = config;
     
-    if(!config.portName.isEmpty()) {
-        m_serialPort->setPortName(config.portName);
-        m_serialPort->setBaudRate(config.baudRate);
-        m_serialPort->setDataBits(config.dataBits);
-        m_serialPort->setStopBits(config.stopBits);
-        m_serialPort->setParity(config.parity);
-        m_serialPort->setFlowControl(config.flowControl);
-        m_serialPort->setReadBufferSize(config.readBufferSize);
-        
-        setAutoReconnect(config.autoReconnect, 
-                        config.reconnectInterval,
-                        config.maxReconnectAttempts);
-                        
-        setPackageMode(config.usePackageMode,
-                      config.packageStart,
-                      config.packageEnd,
-                      config.packageTimeout);
-        
-        return openDevice(config.portName);
+    prepareTransport(config.portName);
+    m_writeHighWaterMark = config.writeBufferSize;
+    
+    setAutoReconnect(config.autoReconnect, 
+                    config.reconnectInterval,
+                    config.maxReconnectAttempts);
+                    
+    setPackageMode(config.usePackageMode,
+                  config.packageStart,
+                  config.packageEnd,
+                  config.packageTimeout);
+    
+    // 兼容只设置usePackageMode的旧配置
+    setFramingMode(config.framing == LineFraming && config.usePackageMode
+                   ? MarkerFraming : config.framing);
+    
+    // 捕获文件不变时继续写入，重新打开会覆盖已捕获的数据
+    if(config.capturePath != previousCapture) {
+        setCapture(config.capturePath);
+    }
+    
+    // 已就绪时直接修改参数，低延迟设置按新配置重新应用
+    if(m_state == Ready) {
+        releaseLowLatency();
+        applyLowLatency();
+    }
+}
+
+/**
+ * @brief 按端口名准备传输层
+ * 
+ * @details
+ * 1. 端口名前缀对应的传输层类型变化时替换传输层对象并重新连接信号
+ * 2. 把当前配置中的线路参数和读缓冲上限写入传输层，打开时生效
+ */
+void CH34xQt::prepareTransport(const QString& portName)
+{
+    const SerialTransport::Kind kind = SerialTransport::kindForPort(portName);
+    if(!m_transport || m_transport->kind() != kind) {
+        if(m_transport) {
+            m_transport->close();
+            m_transport->disconnect(this);
+            m_transport->deleteLater();
+        }
+        m_transport = SerialTransport::create(portName, this);
+        connect(m_transport, &SerialTransport::readyRead,
+                this, &CH34xQt::handleReadyRead);
+        connect(m_transport, &SerialTransport::errorOccurred,
+                this, &CH34xQt::handleError);
+        connect(m_transport, &SerialTransport::bytesWritten,
+                this, &CH34xQt::handleBytesWritten);
     }
     
-    return false;
+    m_transport->setPortName(portName);
+    m_transport->setBaudRate(m_config.baudRate);
+    m_transport->setDataBits(m_config.dataBits);
+    m_transport->setStopBits(m_config.stopBits);
+    m_transport->setParity(m_config.parity);
+    m_transport->setFlowControl(m_config.flowControl);
+    m_transport->setReadBufferSize(m_config.readBufferSize);
 }
 
 CH34xQt::SerialConfig CH34xQt::currentConfig() const
@@ -412,16 +1325,143 @@ CH34xQt::SerialConfig CH34xQt::currentConfig() const
     return m_config;
 }
 
+/**
+ * @brief 生成统计快照
+ * 
+ * @details
+ * 计数器以relaxed方式读取，各字段之间不保证严格同一时刻，
+ * 但每个字段本身都是完整的值，可在任意线程调用。
+ */
 CH34xQt::Statistics CH34xQt::getStatistics() const
 {
-    return m_statistics;
+    const std::memory_order relaxed = std::memory_order_relaxed;
+    
+    Statistics stats;
+    stats.bytesReceived = m_counters.bytesReceived.load(relaxed);
+    stats.bytesSent = m_counters.bytesSent.load(relaxed);
+    stats.packetsReceived = m_counters.packetsReceived.load(relaxed);
+    stats.packetsSent = m_counters.packetsSent.load(relaxed);
+    stats.errors = m_counters.errors.load(relaxed);
+    stats.reconnects = m_counters.reconnects.load(relaxed);
+    stats.recoveries = m_counters.recoveries.load(relaxed);
+    stats.lastRecoveryUs = m_counters.lastRecoveryUs.load(relaxed);
+    stats.maxRecoveryUs = m_counters.maxRecoveryUs.load(relaxed);
+    stats.frameQueueOverflows = m_counters.frameQueueOverflows.load(relaxed);
+    stats.maxIoLatencyUs = m_counters.maxIoLatencyUs.load(relaxed);
+    stats.maxHandoffLatencyUs = m_counters.maxHandoffLatencyNs.load(relaxed) / 1000;
+    stats.framingErrors = m_counters.framingErrors.load(relaxed);
+    stats.crcErrors = m_counters.crcErrors.load(relaxed);
+    stats.sequenceErrors = m_counters.sequenceErrors.load(relaxed);
+    stats.droppedFrames = m_counters.droppedFrames.load(relaxed);
+    stats.droppedBytes = m_counters.droppedBytes.load(relaxed);
+    stats.readPauses = m_counters.readPauses.load(relaxed);
+    stats.frameQueueDepth = m_frameQueue ? m_frameQueue->size() : 0;
+    stats.writeQueueBytes = m_pendingWriteBytes.load(relaxed);
+    stats.receiveBufferBytes = m_counters.receiveBufferBytes.load(relaxed);
+    stats.receiveBufferCapacity = m_counters.receiveBufferCapacity.load(relaxed);
+    stats.receiveBufferPeak = m_counters.receiveBufferPeak.load(relaxed);
+    stats.writeBufferCapacity = m_counters.writeBufferCapacity.load(relaxed);
+    stats.writeBufferPeak = m_counters.writeBufferPeak.load(relaxed);
+    for(int i = 0; i < FRAME_SIZE_BUCKETS; ++i) {
+        stats.frameSizeHistogram[i] = m_counters.frameSizeHistogram[i].load(relaxed);
+    }
+    for(int i = 0; i < READ_GAP_BUCKETS; ++i) {
+        stats.readGapHistogram[i] = m_counters.readGapHistogram[i].load(relaxed);
+    }
+    stats.maxIntraFrameGapUs = m_counters.maxIntraFrameGapUs.load(relaxed);
+    stats.reads = m_counters.reads.load(relaxed);
+    for(int i = 0; i < READ_SIZE_BUCKETS; ++i) {
+        stats.readSizeHistogram[i] = m_counters.readSizeHistogram[i].load(relaxed);
+    }
+    for(int i = 0; i < WAKE_LATENCY_BUCKETS; ++i) {
+        stats.wakeLatencyHistogram[i] = m_counters.wakeLatencyHistogram[i].load(relaxed);
+    }
+    stats.lowLatencyActive = m_lowLatencyActive.load(relaxed);
+    
+    const qint64 lastReceiveNs = m_counters.lastReceiveNs.load(relaxed);
+    const qint64 lastSendNs = m_counters.lastSendNs.load(relaxed);
+    
+    QMutexLocker locker(&m_statsMutex);
+    stats.receiveByteRate = m_receiveByteRate;
+    stats.sendByteRate = m_sendByteRate;
+    stats.receiveFrameRate = m_receiveFrameRate;
+    stats.ioCpuLoad = m_ioCpuLoad;
+    stats.startTime = m_statsStartTime;
+    // 单调时钟换算为日历时间，只在生成快照时做一次
+    if(lastReceiveNs > 0) {
+        stats.lastReceiveTime = m_statsStartTime.addMSecs((lastReceiveNs - m_statsStartNs) / 1000000);
+    }
+    if(lastSendNs > 0) {
+        stats.lastSendTime = m_statsStartTime.addMSecs((lastSendNs - m_statsStartNs) / 1000000);
+    }
+    return stats;
 }
 
 void CH34xQt::resetStatistics()
 {
-    m_statistics = Statistics();
-    m_statistics.startTime = QDateTime::currentDateTime();
-    emit statisticsUpdated(m_statistics);
+    const std::memory_order relaxed = std::memory_order_relaxed;
+    m_counters.bytesReceived.store(0, relaxed);
+    m_counters.bytesSent.store(0, relaxed);
+    m_counters.packetsReceived.store(0, relaxed);
+    m_counters.packetsSent.store(0, relaxed);
+    m_counters.errors.store(0, relaxed);
+    m_counters.reconnects.store(0, relaxed);
+    m_counters.recoveries.store(0, relaxed);
+    m_counters.lastRecoveryUs.store(0, relaxed);
+    m_counters.maxRecoveryUs.store(0, relaxed);
+    m_counters.frameQueueOverflows.store(0, relaxed);
+    m_counters.maxIoLatencyUs.store(0, relaxed);
+    m_counters.maxHandoffLatencyNs.store(0, relaxed);
+    m_counters.framingErrors.store(0, relaxed);
+    m_counters.crcErrors.store(0, relaxed);
+    m_counters.sequenceErrors.store(0, relaxed);
+    m_counters.droppedFrames.store(0, relaxed);
+    m_counters.droppedBytes.store(0, relaxed);
+    m_counters.readPauses.store(0, relaxed);
+    m_counters.receiveBufferBytes.store(0, relaxed);
+    m_counters.receiveBufferCapacity.store(m_receiveBuffer.capacity(), relaxed);
+    m_counters.receiveBufferPeak.store(m_receiveBuffer.capacity(), relaxed);
+    m_counters.writeBufferCapacity.store(m_writeBuffer.capacity(), relaxed);
+    m_counters.writeBufferPeak.store(m_writeBuffer.capacity(), relaxed);
+    m_counters.lastReceiveNs.store(0, relaxed);
+    m_counters.lastSendNs.store(0, relaxed);
+    for(int i = 0; i < FRAME_SIZE_BUCKETS; ++i) {
+        m_counters.frameSizeHistogram[i].store(0, relaxed);
+    }
+    for(int i = 0; i < READ_GAP_BUCKETS; ++i) {
+        m_counters.readGapHistogram[i].store(0, relaxed);
+    }
+    m_counters.maxIntraFrameGapUs.store(0, relaxed);
+    m_counters.reads.store(0, relaxed);
+    for(int i = 0; i < READ_SIZE_BUCKETS; ++i) {
+        m_counters.readSizeHistogram[i].store(0, relaxed);
+    }
+    for(int i = 0; i < WAKE_LATENCY_BUCKETS; ++i) {
+        m_counters.wakeLatencyHistogram[i].store(0, relaxed);
+    }
+    
+    {
+        QMutexLocker locker(&m_statsMutex);
+        m_statsStartTime = QDateTime::currentDateTime();
+        m_statsStartNs = m_clock.nsecsElapsed();
+        m_rateLastNs = m_statsStartNs;
+        m_rateLastBytesRx = m_rateLastBytesTx = m_rateLastFramesRx = 0;
+        m_receiveByteRate = m_sendByteRate = m_receiveFrameRate = 0;
+        // CPU时间只能在设备线程取样，由下次发布重新开始
+        m_rateLastCpuNs = -1;
+        m_ioCpuLoad = 0;
+    }
+    
+    emit statisticsUpdated(getStatistics());
+}
+
+void CH34xQt::setStatisticsInterval(int msec)
+{
+    if(msec > 0) {
+        m_statsTimer->start(msec);
+    } else {
+        m_statsTimer->stop();
+    }
 }
 
 void CH34xQt::setAutoReconnect(bool enable, int interval, int maxAttempts)
@@ -429,13 +1469,18 @@ void CH34xQt::setAutoReconnect(bool enable, int interval, int maxAttempts)
     m_config.autoReconnect = enable;
     m_config.reconnectInterval = interval;
     m_config.maxReconnectAttempts = maxAttempts;
-    m_reconnectAttempts = 0;
     
+    // 重连中重新载入配置（包括重连自身）时保留已尝试的次数
     if(!enable) {
-        m_reconnectTimer->stop();
+        stopReconnect();
     }
 }
 
+bool CH34xQt::isReconnecting() const
+{
+    return m_reconnecting;
+}
+
 void CH34xQt::setPackageMode(bool enable, const QString& start, 
                             const QString& end, int timeout)
 {
@@ -443,47 +1488,353 @@ void CH34xQt::setPackageMode(bool enable, const QString& start,
     m_config.packageStart = start;
     m_config.packageEnd = end;
     m_config.packageTimeout = timeout;
+    m_startMatcher.setPattern(start.toUtf8());
+    m_endMatcher.setPattern(end.toUtf8());
     
     if(enable) {
-        m_packageTimer->setInterval(timeout);
+        setFramingMode(MarkerFraming);
     } else {
-        m_packageTimer->stop();
+        setFramingMode(m_config.framing == MarkerFraming ? LineFraming : m_config.framing);
+    }
+}
+
+void CH34xQt::setFramingMode(FramingMode mode)
+{
+    m_config.framing = mode;
+    m_config.usePackageMode = (mode == MarkerFraming);
+    
+    // 分帧方式或标记变化后之前的扫描进度失效
+    m_receiveBuffer.setScanPos(0);
+    m_packageStartFound = false;
+    m_rxSequenceValid = false;
+    
+    // 空闲超时随分帧方式变化，下次读到数据时重新设置
+    m_packageTimer->stop();
+}
+
+void CH34xQt::setFrameGap(int msec)
+{
+    m_config.frameGap = msec;
+}
+
+void CH34xQt::setLowLatency(bool enable, int cpu, int priority)
+{
+    const bool ready = m_state == Ready;
+    if(ready) {
+        releaseLowLatency();
+    }
+    m_config.lowLatency = enable;
+    m_config.ioThreadCpu = cpu;
+    m_config.ioThreadPriority = priority;
+    if(ready) {
+        applyLowLatency();
+    }
+}
+
+bool CH34xQt::setCapture(const QString& path)
+{
+    m_captureFlushTimer->stop();
+    m_capture.close();
+    m_config.capturePath = path;
+    if(path.isEmpty()) {
+        return true;
+    }
+    
+    if(!m_capture.open(path)) {
+        emit errorOccurred(tr("无法创建捕获文件 %1: %2").arg(path, m_capture.errorString()));
+        m_config.capturePath.clear();
+        return false;
+    }
+    m_captureFlushTimer->start();
+    qDebug() << "Capturing raw traffic to" << path;
+    return true;
+}
+
+/**
+ * @brief 启用低延迟设置
+ * 
+ * @details
+ * 1. 传输层启用低延迟设置，不支持时忽略
+ * 2. 记录当前线程的CPU亲和性和调度策略，再按配置绑定CPU、切换到SCHED_FIFO，
+ *    失败只给出警告，不影响收发
+ * 3. 启动I/O看门狗，采样唤醒延迟
+ */
+void CH34xQt::applyLowLatency()
+{
+    if(!m_config.lowLatency) {
+        return;
+    }
+    
+    m_lowLatencyActive = m_transport->setLowLatency(true);
+    
+#ifdef Q_OS_LINUX
+    const int cpu = m_config.ioThreadCpu;
+    const int priority = m_config.ioThreadPriority;
+    if(!m_threadTuned && (cpu >= 0 || priority > 0)) {
+        const pthread_t self = ::pthread_self();
+        cpu_set_t cpus;
+        sched_param param;
+        if(::pthread_getaffinity_np(self, sizeof(cpus), &cpus) == 0 &&
+           ::pthread_getschedparam(self, &m_savedSchedPolicy, &param) == 0) {
+            m_savedSchedPriority = param.sched_priority;
+            m_savedCpus.clear();
+            for(int i = 0; i < CPU_SETSIZE; ++i) {
+                if(CPU_ISSET(i, &cpus)) {
+                    m_savedCpus.append(i);
+                }
+            }
+            m_threadTuned = true;
+            
+            if(cpu >= 0 && cpu < CPU_SETSIZE) {
+                cpu_set_t target;
+                CPU_ZERO(&target);
+                CPU_SET(cpu, &target);
+                const int result = ::pthread_setaffinity_np(self, sizeof(target), &target);
+                if(result != 0) {
+                    qWarning() << "CH34xQt: cannot pin thread to CPU" << cpu << qt_error_string(result);
+                }
+            }
+            if(priority > 0) {
+                sched_param realtime;
+                realtime.sched_priority = qBound(::sched_get_priority_min(SCHED_FIFO), priority,
+                                                 ::sched_get_priority_max(SCHED_FIFO));
+                const int result = ::pthread_setschedparam(self, SCHED_FIFO, &realtime);
+                if(result != 0) {
+                    qWarning() << "CH34xQt: cannot switch to SCHED_FIFO" << qt_error_string(result);
+                }
+            }
+        }
+    }
+#endif
+    
+    if(!m_ioWatchdogTimer->isActive()) {
+        m_ioWatchdogClock.start();
+        m_ioWatchdogTimer->start(IO_WATCHDOG_INTERVAL);
+    }
+}
+
+void CH34xQt::releaseLowLatency()
+{
+    if(m_lowLatencyActive) {
+        m_transport->setLowLatency(false);
+        m_lowLatencyActive = false;
+    }
+    
+#ifdef Q_OS_LINUX
+    if(m_threadTuned) {
+        const pthread_t self = ::pthread_self();
+        sched_param param;
+        param.sched_priority = m_savedSchedPriority;
+        ::pthread_setschedparam(self, m_savedSchedPolicy, &param);
+        
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for(int cpu : m_savedCpus) {
+            CPU_SET(cpu, &cpus);
+        }
+        ::pthread_setaffinity_np(self, sizeof(cpus), &cpus);
+        m_threadTuned = false;
+    }
+#endif
+    
+    // I/O线程模式下看门狗一直运行
+    if(!m_frameQueue) {
+        m_ioWatchdogTimer->stop();
     }
 }
 
 void CH34xQt::updateStatistics(qint64 bytesRx, qint64 bytesTx,
                               qint64 packetsRx, qint64 packetsTx)
 {
-    m_statistics.bytesReceived += bytesRx;
-    m_statistics.bytesSent += bytesTx;
-    m_statistics.packetsReceived += packetsRx;
-    m_statistics.packetsSent += packetsTx;
-    
+    const std::memory_order relaxed = std::memory_order_relaxed;
     if(bytesRx > 0) {
-        m_statistics.lastReceiveTime = QDateTime::currentDateTime();
+        m_counters.bytesReceived.fetch_add(bytesRx, relaxed);
+        m_counters.lastReceiveNs.store(m_clock.nsecsElapsed(), relaxed);
     }
     if(bytesTx > 0) {
-        m_statistics.lastSendTime = QDateTime::currentDateTime();
+        m_counters.bytesSent.fetch_add(bytesTx, relaxed);
+        m_counters.lastSendNs.store(m_clock.nsecsElapsed(), relaxed);
+    }
+    if(packetsRx > 0) {
+        m_counters.packetsReceived.fetch_add(packetsRx, relaxed);
+    }
+    if(packetsTx > 0) {
+        m_counters.packetsSent.fetch_add(packetsTx, relaxed);
+    }
+}
+
+void CH34xQt::recordFrameSize(int size)
+{
+    int bucket = 0;
+    while(bucket < FRAME_SIZE_BUCKETS - 1 && size > (16 << bucket)) {
+        ++bucket;
+    }
+    m_counters.frameSizeHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void CH34xQt::recordReadGap(qint64 gapNs, bool withinFrame)
+{
+    const qint64 gapUs = gapNs / 1000;
+    int bucket = 0;
+    while(bucket < READ_GAP_BUCKETS - 1 && gapUs > (qint64(100) << bucket)) {
+        ++bucket;
+    }
+    m_counters.readGapHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    if(withinFrame) {
+        updateMax(m_counters.maxIntraFrameGapUs, gapUs);
+    }
+}
+
+void CH34xQt::recordReadSize(int size)
+{
+    if(size <= 0) {
+        return;
+    }
+    int bucket = 0;
+    while(bucket < READ_SIZE_BUCKETS - 1 && size > (1 << bucket)) {
+        ++bucket;
+    }
+    m_counters.reads.fetch_add(1, std::memory_order_relaxed);
+    m_counters.readSizeHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 发布统计快照
+ * 
+ * @details
+ * 1. 与上次发布时的计数相减得到本周期的速率
+ * 2. 发布定时器运行在设备线程，同时取样本线程的CPU时间，得到本周期的CPU占用
+ * 3. 生成快照并发出statisticsUpdated
+ */
+void CH34xQt::publishStatistics()
+{
+    const std::memory_order relaxed = std::memory_order_relaxed;
+    const qint64 now = m_clock.nsecsElapsed();
+#ifdef Q_OS_LINUX
+    timespec cpuTime;
+    const qint64 cpuNs = ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime) == 0
+                         ? qint64(cpuTime.tv_sec) * 1000000000 + cpuTime.tv_nsec : -1;
+#else
+    const qint64 cpuNs = -1;
+#endif
+    const qint64 bytesRx = m_counters.bytesReceived.load(relaxed);
+    const qint64 bytesTx = m_counters.bytesSent.load(relaxed);
+    const qint64 framesRx = m_counters.packetsReceived.load(relaxed);
+    
+    {
+        QMutexLocker locker(&m_statsMutex);
+        const double seconds = (now - m_rateLastNs) / 1e9;
+        if(seconds > 0) {
+            m_receiveByteRate = (bytesRx - m_rateLastBytesRx) / seconds;
+            m_sendByteRate = (bytesTx - m_rateLastBytesTx) / seconds;
+            m_receiveFrameRate = (framesRx - m_rateLastFramesRx) / seconds;
+            if(cpuNs >= 0 && m_rateLastCpuNs >= 0) {
+                m_ioCpuLoad = (cpuNs - m_rateLastCpuNs) / 1e9 / seconds;
+            }
+        }
+        m_rateLastCpuNs = cpuNs;
+        m_rateLastNs = now;
+        m_rateLastBytesRx = bytesRx;
+        m_rateLastBytesTx = bytesTx;
+        m_rateLastFramesRx = framesRx;
     }
     
-    emit statisticsUpdated(m_statistics);
+    emit statisticsUpdated(getStatistics());
 }
 
-void CH34xQt::tryReconnect()
+void CH34xQt::updateMax(std::atomic<qint64>& target, qint64 value)
+{
+    qint64 current = target.load(std::memory_order_relaxed);
+    while(value > current &&
+          !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief 设备断开，开始重连
+ * 记录断开时刻，恢复耗时从这里算起
+ */
+void CH34xQt::startReconnect()
+{
+    m_reconnecting = true;
+    m_linkLostNs = m_clock.nsecsElapsed();
+    // 刚重连上又断开说明链路在反复掉线，接着之前的次数退避，次数上限也照常生效
+    const bool flapping = m_recoveredNs >= 0 &&
+                          m_linkLostNs - m_recoveredNs < qint64(RECONNECT_STABLE_TIME) * 1000000;
+    m_reconnectAttempts = flapping ? m_recoveredAttempts : 0;
+    scheduleReconnect();
+}
+
+bool CH34xQt::canReconnect() const
+{
+    const SerialTransport::Kind kind = m_transport->kind();
+    return kind == SerialTransport::SerialPortKind || kind == SerialTransport::LocalSocketKind;
+}
+
+void CH34xQt::stopReconnect()
 {
-    if(!m_config.autoReconnect || 
+    m_reconnecting = false;
+    m_reconnectAttempts = 0;
+    m_reconnectTimer->stop();
+}
+
+/**
+ * @brief 安排下一次重连
+ * 
+ * @details
+ * 1. 次数用尽时结束重连并报告错误
+ * 2. 等待时间为RECONNECT_MIN_DELAY * 2^已尝试次数，不超过reconnectInterval
+ * 3. 一半固定、一半随机，避免同时断开的多个设备一起重试
+ */
+void CH34xQt::scheduleReconnect()
+{
+    if(m_config.maxReconnectAttempts > 0 &&
        m_reconnectAttempts >= m_config.maxReconnectAttempts) {
-        m_reconnectTimer->stop();
+        const int attempts = m_reconnectAttempts;
+        stopReconnect();
+        emit errorOccurred(tr("重连 %1 失败，已尝试%2次")
+                          .arg(m_config.portName).arg(attempts));
+        return;
+    }
+    
+    const int cap = qMax(m_config.reconnectInterval, int(RECONNECT_MIN_DELAY));
+    const int shift = qMin(m_reconnectAttempts, 16);
+    const int base = static_cast<int>(qMin<qint64>(qint64(RECONNECT_MIN_DELAY) << shift, cap));
+    const int delay = base / 2 + QRandomGenerator::global()->bounded(base / 2 + 1);
+    m_reconnectTimer->start(delay);
+}
+
+/**
+ * @brief 尝试重新连接
+ * 以完整的当前配置异步打开，结果在continueOpen()/failOpen()中处理
+ */
+void CH34xQt::tryReconnect()
+{
+    if(!m_reconnecting || m_state != Closed) {
         return;
     }
     
     m_reconnectAttempts++;
-    m_statistics.reconnects++;
+    m_counters.reconnects.fetch_add(1, std::memory_order_relaxed);
     
     emit reconnecting(m_reconnectAttempts, m_config.maxReconnectAttempts);
     
-    if(openDevice(m_config.portName)) {
+    // 载入配置的过程会逐项改写m_config，传入副本
+    const SerialConfig config = m_config;
+    startOpen(config, RECONNECT_OPEN_TIMEOUT);
+}
+
+void CH34xQt::handlePortsChanged()
+{
+    emit portsChanged();
+    
+    // 设备重新出现时不必等到退避结束
+    if(!m_reconnecting || m_state != Closed || !m_reconnectTimer->isActive()) {
+        return;
+    }
+    if(SerialTransport::kindForPort(m_config.portName) == SerialTransport::SerialPortKind &&
+       PortMonitor::instance()->ports().contains(m_config.portName)) {
         m_reconnectTimer->stop();
-        m_reconnectAttempts = 0;
+        tryReconnect();
     }
-} 
+}
@@ -7,8 +7,17 @@
 #include <QDebug>
 #include <QTimer>
 #include <QDateTime>
-#include <QTextCodec>
 #include <QThread>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <atomic>
+#include "receivebuffer.h"
+#include "spscqueue.h"
+#include "framematcher.h"
+#include "utf8validator.h"
+#include "capturelog.h"
+
+class SerialTransport;
 
 /**
  * @brief 浩瀚银河开源CH34x系列USB转串口芯片的Qt封装类
@@ -28,11 +37,45 @@
  * - 编码自动识别转换
  * - 错误重试机制
  * - 数据统计功能
+ * - I/O线程模式（经无锁队列向GUI线程移交数据帧）
+ * - 可替换的传输层（伪终端、Unix域套接字、标准输入/输出），见SerialTransport
+ * - 原始收发数据捕获与回放，见CaptureWriter和ReplayTransport
  */
 class CH34xQt : public QObject {
     Q_OBJECT
     
 public:
+    /**
+     * @brief 设备连接状态
+     */
+    enum DeviceState {
+        Closed,         ///< 未打开
+        Opening,        ///< 正在打开端口（设备节点可能尚未就绪，按退避重试）
+        Configuring,    ///< 端口已打开，正在清理缓冲并探测设备是否就绪
+        Ready           ///< 可以收发数据
+    };
+    Q_ENUM(DeviceState)
+    
+    /**
+     * @brief 一次异步打开各阶段的耗时，用于跟踪连接延迟
+     */
+    struct OpenTiming {
+        qint64 openUs;          ///< Opening阶段耗时(us)，含重试等待
+        qint64 configureUs;     ///< Configuring阶段耗时(us)，含就绪探测
+        qint64 totalUs;         ///< 从调用openDeviceAsync()到结束的总耗时(us)
+        int attempts;           ///< 打开端口的尝试次数
+    };
+    
+    /**
+     * @brief 分帧方式
+     */
+    enum FramingMode {
+        LineFraming,        ///< 以换行符分隔的文本行
+        MarkerFraming,      ///< 起止标记包围的数据包（即usePackageMode）
+        BinaryFraming,      ///< 带长度前缀、序号和CRC的二进制帧，可承载任意数据
+        GapFraming          ///< 线路空闲超过frameGap即结束一帧（类似Modbus RTU的t3.5），用于不发送分隔符的设备
+    };
+    
     /**
      * @brief 串口配置结构体
      */
@@ -45,17 +88,30 @@ public:
         QSerialPort::FlowControl flowControl;///< 流控制
         int readBufferSize;                 ///< 读取缓冲区大小
         int writeBufferSize;                ///< 写入缓冲区大小
-        bool autoReconnect;                 ///< 自动重连
-        int reconnectInterval;              ///< 重连间隔(ms)
-        int maxReconnectAttempts;           ///< 最大重连次数
+        bool autoReconnect;                 ///< 设备断开（ResourceError）后自动重连
+        int reconnectInterval;              ///< 重连退避间隔的上限(ms)
+        int maxReconnectAttempts;           ///< 最大重连次数，0表示不限
         int packageTimeout;                 ///< 数据包超时时间(ms)
         bool usePackageMode;                ///< 是否使用数据包模式
         QString packageStart;               ///< 数据包起始标记
         QString packageEnd;                 ///< 数据包结束标记
+        FramingMode framing;                ///< 分帧方式，LineFraming且usePackageMode时视为MarkerFraming
+        bool binaryCrc32;                   ///< 二进制帧发送时使用CRC-32C（否则CRC-16）
+        int frameGap;                       ///< GapFraming下结束一帧的空闲时间(ms)
+        bool lowLatency;                    ///< 低延迟模式，以CPU占用换取更低的接收延迟
+        int ioThreadCpu;                    ///< 低延迟模式下设备线程绑定的CPU，-1表示不绑定
+        int ioThreadPriority;               ///< 低延迟模式下设备线程的SCHED_FIFO优先级(1-99)，0表示不修改
+        QString capturePath;                ///< 原始收发数据的捕获文件，为空表示不捕获
     };
     
+    static const int FRAME_SIZE_BUCKETS = 12;  ///< 帧长直方图桶数
+    static const int READ_GAP_BUCKETS = 12;    ///< 读取间隔直方图桶数
+    static const int READ_SIZE_BUCKETS = 12;   ///< 单次读取字节数直方图桶数
+    static const int WAKE_LATENCY_BUCKETS = 10;    ///< 唤醒延迟直方图桶数
+    
     /**
      * @brief 串口统计信息结构体
+     * 由热路径上的原子计数器生成的快照，可在任意线程获取
      */
     struct Statistics {
         qint64 bytesReceived;              ///< 接收字节数
@@ -63,11 +119,52 @@ public:
         qint64 packetsReceived;            ///< 接收数据包数
         qint64 packetsSent;                ///< 发送数据包数
         qint64 errors;                     ///< 错误次数
-        qint64 reconnects;                 ///< 重连次数
+        qint64 reconnects;                 ///< 重连尝试次数
+        qint64 recoveries;                 ///< 断开后重连成功的次数
+        qint64 lastRecoveryUs;             ///< 最近一次从断开到重新就绪的耗时(us)
+        qint64 maxRecoveryUs;              ///< 断开到重新就绪的最大耗时(us)
+        qint64 frameQueueOverflows;        ///< 帧队列满导致丢弃的帧数
+        qint64 maxIoLatencyUs;             ///< I/O事件循环最大延迟(us)，即读取被推迟的上界
+        qint64 maxHandoffLatencyUs;        ///< 帧从入队到被取走的最大耗时(us)
+        qint64 framingErrors;              ///< 二进制帧头校验失败、需要重新同步的次数
+        qint64 crcErrors;                  ///< 二进制帧负载CRC错误数
+        qint64 sequenceErrors;             ///< 二进制帧序号不连续时缺失的帧数
+        qint64 droppedFrames;              ///< 整帧丢弃的帧数（超长帧、帧队列溢出）
+        qint64 droppedBytes;               ///< 丢弃的字节数
+        qint64 readPauses;                 ///< 帧队列达到高水位而暂停读取的次数
+        double receiveByteRate;            ///< 接收速率(字节/秒)，按上一个发布周期计算
+        double sendByteRate;               ///< 发送速率(字节/秒)
+        double receiveFrameRate;           ///< 接收帧速率(帧/秒)
+        int frameQueueDepth;               ///< 帧队列中待取走的帧数
+        qint64 writeQueueBytes;            ///< 发送队列中尚未写出的字节数
+        qint64 receiveBufferBytes;         ///< 接收缓冲区中尚未成帧的字节数
+        qint64 receiveBufferCapacity;      ///< 接收缓冲区当前占用的内存(字节)
+        qint64 receiveBufferPeak;          ///< 接收缓冲区内存的历史最大值(字节)
+        qint64 writeBufferCapacity;        ///< 发送暂存区当前占用的内存(字节)
+        qint64 writeBufferPeak;            ///< 发送暂存区内存的历史最大值(字节)
+        qint64 frameSizeHistogram[FRAME_SIZE_BUCKETS]; ///< 帧长分布：第0桶≤16字节，第i桶≤(16<<i)字节，末桶为更长的帧
+        qint64 readGapHistogram[READ_GAP_BUCKETS];     ///< 相邻两次读到数据的间隔分布：第i桶≤(100<<i)us，末桶为更长的间隔
+        qint64 maxIntraFrameGapUs;         ///< GapFraming下同一帧内的最大读取间隔(us)，接近frameGap说明空闲阈值偏小
+        qint64 reads;                      ///< 读到数据的次数，即接收路径的唤醒次数
+        qint64 readSizeHistogram[READ_SIZE_BUCKETS];   ///< 单次读取字节数分布：第i桶≤(1<<i)字节，末桶为更多；集中在高位说明数据被攒批后才上报
+        qint64 wakeLatencyHistogram[WAKE_LATENCY_BUCKETS]; ///< 设备线程唤醒延迟分布：第i桶≤(10<<i)us，末桶为更长；由看门狗采样，I/O线程或低延迟模式下才有数据
+        double ioCpuLoad;                  ///< 设备线程在上一个发布周期内的CPU占用(0~1)，仅Linux
+        bool lowLatencyActive;             ///< 传输层的低延迟设置是否已生效
         QDateTime startTime;               ///< 开始时间
         QDateTime lastReceiveTime;         ///< 最后接收时间
         QDateTime lastSendTime;            ///< 最后发送时间
     };
+    
+    /**
+     * @brief 已解析的数据帧
+     */
+    struct Frame {
+        QByteArray data;                   ///< 帧内容
+        qint64 timestamp;                  ///< 解析完成时刻(ns，单调时钟)
+        Utf8Validator::Result encoding;    ///< 编码校验结果，使用方据此选择解码方式，无需再次校验
+        quint8 channel;                    ///< 二进制帧的通道号，文本帧为0
+        quint16 sequence;                  ///< 二进制帧的序号，文本帧为0
+    };
 
     /**
      * @brief 构造函数，初始化串口对象和定时器
@@ -82,11 +179,30 @@ public:
     
     /**
      * @brief 打开指定串口设备
+     * 使用当前配置同步打开，不等待设备就绪
      * @param portName 串口名称（如COM1）
      * @return 是否成功打开设备
      */
     bool openDevice(const QString& portName);
     
+    /**
+     * @brief 异步打开设备
+     * 
+     * 完整配置在打开端口前一次性设置，端口打开时一并生效。设备节点不存在或
+     * 权限尚未就绪（刚插入时udev仍在处理）时按5ms起的指数退避重试，打开后
+     * 通过读取调制解调器信号线确认驱动已就绪，整个过程不超过OPEN_TIMEOUT。
+     * 进度通过stateChanged发出，结束时发出openFinished。
+     * 
+     * @param config 串口配置
+     * @return 是否已开始打开（正在打开其他设备时为false）
+     */
+    bool openDeviceAsync(const SerialConfig& config);
+    
+    /**
+     * @brief 当前连接状态
+     */
+    DeviceState state() const;
+    
     /**
      * @brief 关闭当前打开的设备
      */
@@ -94,11 +210,33 @@ public:
     
     /**
      * @brief 发送数据到串口设备
+     * 等价于 queueWrite(data) != 0，不会阻塞
      * @param data 要发送的数据
-     * @return 是否成功发送
+     * @return 是否成功加入发送队列
      */
     bool writeData(const QByteArray& data);
     
+    /**
+     * @brief 将一条消息加入异步发送队列
+     * 
+     * 可在任意线程调用。消息在设备线程中分帧后进入发送暂存区，与相邻的小消息
+     * 合并成较大的写操作交给串口；实际写出进度通过QSerialPort::bytesWritten跟踪，
+     * 每条消息写完或失败时发出writeCompleted。
+     * 
+     * 已排队但未写出的字节数达到写入缓冲区大小（高水位）时拒绝新消息，
+     * 回落到一半以下时发出writeQueueDrained。
+     * 
+     * @param data 要发送的数据
+     * @param channel 二进制分帧时写入帧头的通道号，其他分帧方式忽略
+     * @return 消息编号，被拒绝时返回0
+     */
+    quint32 queueWrite(const QByteArray& data, quint8 channel = 0);
+    
+    /**
+     * @brief 已排队但尚未写出的字节数（可跨线程读取）
+     */
+    qint64 pendingWriteBytes() const;
+    
     /**
      * @brief 检查设备是否打开
      * @return 设备是否打开
@@ -107,9 +245,18 @@ public:
     
     /**
      * @brief 获取系统中所有可用的CH34x设备列表
+     * 返回PortMonitor维护的缓存，不会枚举设备，可在任意线程调用
+     * @param includeVirtual 是否附加pty:、stdio:、unix:等虚拟端口
+     * @return 可用设备的串口名称列表
+     */
+    static QStringList availablePorts(bool includeVirtual = false);
+    
+    /**
+     * @brief 直接枚举系统串口并筛选出CH34x设备
+     * 需要遍历所有串口设备，开销较大，供PortMonitor刷新缓存使用
      * @return 可用设备的串口名称列表
      */
-    static QStringList availablePorts();
+    static QStringList enumeratePorts();
     
     // 串口参数设置函数组
     /**
@@ -148,6 +295,47 @@ public:
      */
     void setReadBufferSize(qint64 size);
     
+    /**
+     * @brief 设置写入缓冲区大小，即发送队列的高水位
+     * @param size 缓冲区大小（字节）
+     */
+    void setWriteBufferSize(qint64 size);
+    
+    /**
+     * @brief 设置GapFraming的帧间空闲时间
+     * @param msec 空闲时间(ms)
+     */
+    void setFrameGap(int msec);
+    
+    /**
+     * @brief 设置低延迟模式
+     * 
+     * 面向交互式的短消息，以CPU占用换取更低的p99接收延迟。设备就绪时：
+     * - 传输层启用低延迟设置，见SerialTransport::setLowLatency()
+     * - 设备对象所在的线程按需绑定到指定CPU并提升为SCHED_FIFO实时调度，
+     *   关闭设备时恢复（I/O线程模式下即I/O线程；实时调度需要CAP_SYS_NICE，
+     *   没有权限时只给出警告）
+     * - 启用I/O看门狗，记录唤醒延迟分布
+     * 设备已就绪时立即生效，须在设备线程调用。
+     * 
+     * @param enable 是否启用
+     * @param cpu 绑定的CPU编号，-1表示不绑定
+     * @param priority SCHED_FIFO优先级(1-99)，0表示不修改调度策略
+     */
+    void setLowLatency(bool enable, int cpu = -1, int priority = 0);
+    
+    /**
+     * @brief 捕获原始收发数据
+     * 
+     * 每次从传输层读到的数据、每次交给传输层写出的数据，连同单调时间戳(ns)和方向
+     * 追加到捕获文件，格式见CaptureRecord。捕获不随设备关闭而停止，重连前后写入
+     * 同一文件。捕获文件可用"replay:路径[@速度]"端口回放。须在设备线程调用。
+     * 
+     * @param path 捕获文件路径，已存在时覆盖；为空时停止捕获
+     * @return 是否成功，失败时发出errorOccurred
+     */
+    bool setCapture(const QString& path);
+    
     /**
      * @brief 应用串口配置
      * @param config 串口配置结构体
@@ -172,16 +360,38 @@ public:
      */
     void resetStatistics();
     
+    /**
+     * @brief 设置统计快照的发布周期
+     * 计数器始终更新，statisticsUpdated只按此周期发出（须在设备线程调用）
+     * @param msec 周期(ms)，0表示不主动发布
+     */
+    void setStatisticsInterval(int msec);
+    
     /**
      * @brief 设置自动重连
+     * 
+     * 设备就绪后发生ResourceError（如USB断开）时关闭端口并按指数退避重连，
+     * 等待时间从RECONNECT_MIN_DELAY开始翻倍，加入随机抖动，不超过interval；
+     * PortMonitor报告端口列表变化时立即尝试一次。重连使用完整的当前配置。
+     * 主动调用closeDevice()或重新打开会取消重连。
+     * 只有真实串口和Unix域套接字会重连；伪终端、标准输入输出和回放无法重新接上同一个对端，
+     * 读到结束即作为错误报告。重连成功后RECONNECT_STABLE_TIME内再次断开时，
+     * 接着之前的次数和等待时间退避，不从头开始。
+     * 
      * @param enable 是否启用
-     * @param interval 重连间隔(ms)
-     * @param maxAttempts 最大重试次数
+     * @param interval 退避间隔上限(ms)
+     * @param maxAttempts 最大重试次数，0表示不限
      */
-    void setAutoReconnect(bool enable, int interval = 5000, int maxAttempts = 3);
+    void setAutoReconnect(bool enable, int interval = 5000, int maxAttempts = 0);
+    
+    /**
+     * @brief 是否正在等待重连
+     */
+    bool isReconnecting() const;
     
     /**
      * @brief 设置数据包模式
+     * 起止标记在此处编码并预处理，接收路径上直接使用编译好的查找器
      * @param enable 是否启用
      * @param start 起始标记
      * @param end 结束标记
@@ -189,7 +399,53 @@ public:
      */
     void setPackageMode(bool enable, const QString& start = "", 
                        const QString& end = "\n", int timeout = 1000);
-
+    
+    /**
+     * @brief 设置分帧方式
+     * MarkerFraming使用setPackageMode()设置的起止标记
+     * @param mode 分帧方式
+     */
+    void setFramingMode(FramingMode mode);
+    
+    /**
+     * @brief 编码一个二进制帧
+     * 
+     * 帧格式（多字节字段均为小端）：
+     * | A5 5A | flags | channel | seq(2) | len(2) | hcrc | payload | crc |
+     * - flags bit0：负载校验使用CRC-32C(4字节)，否则CRC-16/CCITT-FALSE(2字节)
+     * - hcrc：前8字节的CRC-8，用于排除负载中偶然出现的A5 5A
+     * 
+     * @param payload 负载，最长65535字节
+     * @param channel 通道号
+     * @param sequence 序号
+     * @param crc32 是否使用CRC-32C
+     * @return 编码后的帧，负载超长时为空
+     */
+    static QByteArray encodeBinaryFrame(const QByteArray& payload, quint8 channel,
+                                        quint16 sequence, bool crc32);
+    
+    static const int BINARY_HEADER_SIZE = 9;        ///< 二进制帧头长度
+    static const int BINARY_MAX_PAYLOAD = 0xFFFF;   ///< 二进制帧最大负载
+    
+    /**
+     * @brief 启用帧队列（I/O线程模式）
+     * 
+     * 启用后解析出的帧不再通过dataReceived发出，而是写入单生产者/单消费者
+     * 无锁队列，并在队列由空变为非空时发出framesPending，由消费者线程调用
+     * takeFrames()批量取走。须在moveToThread()之前调用。
+     * 
+     * @param capacity 队列容量（帧数）
+     */
+    void enableFrameQueue(int capacity = DEFAULT_FRAME_QUEUE_CAPACITY);
+    
+    /**
+     * @brief 取走队列中全部待处理的帧（仅限消费者线程调用）
+     * @param frames 输出的帧列表，新帧追加在末尾
+     * @return 取走的帧数
+     */
+    int takeFrames(QVector<Frame>& frames);
+    
+    static const int DEFAULT_FRAME_QUEUE_CAPACITY = 8192;  ///< 默认帧队列容量
 signals:
     /**
      * @brief 收到数据信号
@@ -197,6 +453,20 @@ signals:
      */
     void dataReceived(const QByteArray& data);
     
+    /**
+     * @brief 收到数据帧信号（直接模式）
+     * 与dataReceived同时发出，额外携带编码校验结果
+     * @param frame 数据帧
+     */
+    void frameReceived(const CH34xQt::Frame& frame);
+    
+    /**
+     * @brief 批量数据帧信号（直接模式）
+     * 一次读取解析出的所有帧通过一次信号发出，推荐使用
+     * @param frames 按接收顺序排列的数据帧
+     */
+    void framesReceived(const QVector<CH34xQt::Frame>& frames);
+    
     /**
      * @brief 发生错误信号
      * @param error 错误信息
@@ -211,23 +481,73 @@ signals:
     
     /**
      * @brief 统计信息更新信号
+     * 按setStatisticsInterval()设置的周期发出
      * @param stats 最新的统计信息
      */
     void statisticsUpdated(const Statistics& stats);
     
     /**
-     * @brief 重连状态信号
-     * @param attempt 当前重试次数
-     * @param maxAttempts 最大重试次数
+     * @brief 重连状态信号，设备断开开始重连时发出一次，之后每次尝试前发出
+     * @param attempt 当前重试次数，开始重连时为0
+     * @param maxAttempts 最大重试次数，0表示不限
      */
     void reconnecting(int attempt, int maxAttempts);
     
+    /**
+     * @brief 断开后重连成功
+     * @param recoveryUs 从断开到重新就绪的耗时(us)
+     */
+    void reconnected(qint64 recoveryUs);
+    
     /**
      * @brief 数据包接收超时信号
+     * 数据包模式下线路空闲超过packageTimeout时发出，每个空闲期一次
      */
     void packageTimeout();
+    
+    /**
+     * @brief 连接状态变化信号
+     * @param state 新状态
+     */
+    void stateChanged(CH34xQt::DeviceState state);
+    
+    /**
+     * @brief 异步打开结束信号
+     * @param success 是否已进入Ready状态
+     * @param timing 各阶段耗时
+     */
+    void openFinished(bool success, const CH34xQt::OpenTiming& timing);
+    
+    /**
+     * @brief 帧队列中有待取走的数据帧
+     * 每次消费者取空队列后最多触发一次
+     */
+    void framesPending();
+    
+    /**
+     * @brief 消息发送结束信号
+     * @param id queueWrite()返回的消息编号
+     * @param success 是否已全部写出
+     */
+    void writeCompleted(quint32 id, bool success);
+    
+    /**
+     * @brief 发送队列回落到低水位以下，可以继续发送
+     */
+    void writeQueueDrained();
 
 private slots:
+    /**
+     * @brief 推进异步打开状态机
+     * 由openDeviceAsync()和重试定时器调用，每次执行当前阶段的一步
+     */
+    void continueOpen();
+    
+    /**
+     * @brief 端口列表变化，正在重连时立即尝试一次
+     */
+    void handlePortsChanged();
+    
     /**
      * @brief 处理串口数据可读事件
      * 当有新数据到达时被调用
@@ -241,18 +561,61 @@ private slots:
     void handleError(QSerialPort::SerialPortError error);
     
     /**
-     * @brief 定期检查设备列表变化
-     * 由定时器触发，检查设备热插拔
+     * @brief 测量I/O事件循环的调度延迟
+     * 由看门狗定时器触发，迟到的时间即读取可能被推迟的时间
      */
-    void checkPorts();
+    void checkIoLatency();
     
-private:
-    QSerialPort* m_serialPort;      ///< 串口对象指针
-    QTimer* m_portCheckTimer;       ///< 端口检查定时器
-    QStringList m_lastPorts;        ///< 上次检测到的端口列表
+    /**
+     * @brief 处理串口写出进度
+     * @param bytes 本次写出的字节数
+     */
+    void handleBytesWritten(qint64 bytes);
+    
+    /**
+     * @brief 发送超时，视为链路阻塞，放弃所有在途消息
+     */
+    void handleWriteTimeout();
+    
+    /**
+     * @brief 帧队列回落到低水位后恢复读取
+     */
+    void resumeReading();
+    
+    /**
+     * @brief 空闲时收缩收发缓冲区
+     * 一个检查周期内没有收到数据时，接收缓冲区收缩到最近突发长度的两倍，
+     * 连续空闲两个周期即回到初始容量；发送暂存区为空时收缩到初始容量
+     */
+    void trimBuffers();
+    
+    /**
+     * @brief 空闲截止时间到达
+     * 线路确实空闲了足够长时GapFraming结束当前帧、MarkerFraming发出packageTimeout，
+     * 否则按最后一次读取的时刻顺延
+     */
+    void handleIdleTimeout();
     
-    static const int BUFFER_SIZE = 1024 * 1024 * 10;  ///< 接收缓冲区大小（10MB）
-    QByteArray m_receiveBuffer;     ///< 数据接收缓冲区
+private:
+    SerialTransport* m_transport;   ///< 传输层，类型由端口名前缀决定
+    
+    static const int BUFFER_SIZE = 1024 * 1024 * 10;  ///< 接收缓冲区上限（10MB），即单个未完成帧的最大长度，并不预先分配
+    static const int INITIAL_BUFFER_CAPACITY = 4096;     ///< 收发缓冲区的初始及最小容量
+    static const int DEFAULT_READ_BUFFER_SIZE = 64 * 1024;       ///< QSerialPort内部读缓冲默认上限
+    static const int DEFAULT_WRITE_BUFFER_SIZE = 1024 * 1024;    ///< 发送队列默认高水位
+    static const int BUFFER_TRIM_INTERVAL = 5000;        ///< 空闲检查周期(ms)
+    QTimer* m_bufferTrimTimer;      ///< 缓冲区空闲收缩定时器
+    int m_receiveBurstPeak;         ///< 上次收缩以来接收缓冲区的最大数据量，即实测突发长度
+    qint64 m_trimLastBytesRx;       ///< 上个检查周期结束时的接收字节数
+    ReceiveBuffer m_receiveBuffer;  ///< 数据接收缓冲区
+    bool m_packageStartFound;       ///< 数据包模式下已定位到起始标记
+    FrameMatcher m_lineMatcher;     ///< 行模式分隔符查找器
+    FrameMatcher m_startMatcher;    ///< 数据包起始标记查找器
+    FrameMatcher m_endMatcher;      ///< 数据包结束标记查找器
+    FrameMatcher m_binarySyncMatcher;   ///< 二进制帧同步字查找器
+    quint16 m_txSequence;           ///< 下一个发送的二进制帧序号
+    quint16 m_rxExpectedSequence;   ///< 期望收到的下一个二进制帧序号
+    bool m_rxSequenceValid;         ///< 是否已收到过二进制帧
     
     /**
      * @brief 处理接收缓冲区数据
@@ -260,6 +623,164 @@ private:
      */
     void processBuffer();
     
+    /**
+     * @brief GapFraming下把接收缓冲区中的数据作为一帧发出
+     */
+    void flushGapFrame();
+    
+    /**
+     * @brief 当前分帧方式的空闲超时(ms)，0表示不需要
+     */
+    int idleTimeout() const;
+    
+    /**
+     * @brief 帧队列由空变为非空时发出一次framesPending
+     */
+    void notifyFramesPending();
+    
+    /**
+     * @brief 解析接收缓冲区中的完整数据帧并逐个交付
+     */
+    void parseFrames();
+    
+    /**
+     * @brief 解析二进制帧
+     * 校验帧头后直接按长度跳到帧尾，不扫描负载；帧头或CRC错误时
+     * 跳过当前同步字重新查找，保证一次损坏只影响受损的帧
+     */
+    void parseBinaryFrames();
+    
+    /**
+     * @brief 交付一个解析完成的数据帧
+     * 帧队列模式下入队，否则直接发出frameReceived/dataReceived
+     * @param packet 帧内容
+     * @param encoding 编码校验结果
+     * @param channel 通道号
+     * @param sequence 序号
+     */
+    void deliverFrame(const QByteArray& packet, Utf8Validator::Result encoding,
+                      quint8 channel = 0, quint16 sequence = 0);
+    
+    QVector<Frame> m_frameBatch;            ///< 本次读取解析出、待批量发出的帧
+    int m_frameBatchCount;                  ///< 本次读取解析出的帧数
+    SpscQueue<Frame>* m_frameQueue;         ///< I/O线程到GUI线程的帧队列
+    std::atomic<bool> m_framesNotified;     ///< 已发出framesPending且尚未被取走
+    std::atomic<bool> m_isOpen;             ///< 设备打开状态，可跨线程读取
+    QElapsedTimer m_clock;                  ///< 帧时间戳使用的单调时钟
+    QTimer* m_ioWatchdogTimer;              ///< I/O事件循环延迟看门狗
+    QElapsedTimer m_ioWatchdogClock;        ///< 看门狗计时
+    static const int IO_WATCHDOG_INTERVAL = 20;  ///< 看门狗周期(ms)
+    
+    // 接收背压
+    std::atomic<bool> m_readPaused;         ///< 帧队列达到高水位，暂停从串口读取
+    std::atomic<bool> m_resumeScheduled;    ///< 已安排恢复读取
+    bool m_discardingFrame;                 ///< 正在丢弃一个超长帧的剩余部分
+    static const int PAUSED_READ_BUFFER_SIZE = 64 * 1024;  ///< 暂停期间QSerialPort内部缓冲上限
+    
+    /**
+     * @brief 暂停读取
+     * 
+     * 不再读取QSerialPort，并限制其内部缓冲，数据随之积压在内核tty缓冲中；
+     * 启用硬件流控时内核在缓冲将满时自动撤销RTS，由对端暂停发送，
+     * 软件流控时同样由内核发出XOFF。
+     */
+    void pauseReading();
+    
+    /**
+     * @brief 丢弃一个帧并计数
+     * @param bytes 丢弃的字节数
+     * @param frames 丢弃的帧数
+     */
+    void recordDrop(qint64 bytes, qint64 frames);
+    
+    /**
+     * @brief 在途消息记录
+     */
+    struct PendingWrite {
+        quint32 id;                         ///< 消息编号
+        qint64 size;                        ///< 分帧后的字节数
+        qint64 endOffset;                   ///< 最后一个字节在发送字节流中的偏移
+    };
+    
+    /**
+     * @brief 在设备线程中为消息分帧并加入发送暂存区
+     * @param id 消息编号
+     * @param data 消息内容
+     * @param channel 二进制帧通道号
+     */
+    void enqueueWrite(quint32 id, const QByteArray& data, quint8 channel);
+    
+    /**
+     * @brief 将暂存区数据合并成块交给串口
+     * 串口尚未写出的数据少于一个块时才继续交付，使相邻的小消息合并写出
+     */
+    void flushWriteQueue();
+    
+    /**
+     * @brief 以失败结束所有在途消息
+     */
+    void failPendingWrites();
+    
+    // 异步打开
+    DeviceState m_state;                    ///< 当前连接状态
+    QTimer* m_openTimer;                    ///< 打开/探测的重试定时器
+    QElapsedTimer m_openClock;              ///< 本次打开的计时
+    qint64 m_openPhaseStartNs;              ///< 当前阶段开始时刻
+    int m_openRetryDelay;                   ///< 下次重试的等待时间(ms)
+    int m_openTimeout;                      ///< 本次打开的总超时(ms)
+    OpenTiming m_openTiming;                ///< 本次打开的阶段耗时
+    static const int OPEN_TIMEOUT = 3000;       ///< 异步打开的总超时(ms)
+    static const int OPEN_RETRY_MIN = 5;        ///< 首次重试等待(ms)
+    static const int OPEN_RETRY_MAX = 200;      ///< 重试等待上限(ms)
+    
+    /**
+     * @brief 把配置写入m_config和传输层
+     * 端口关闭时串口参数只被记录，在下次open()时一次性生效
+     */
+    void loadConfig(const SerialConfig& config);
+    
+    /**
+     * @brief 按端口名创建或复用传输层，并写入当前配置的线路参数
+     */
+    void prepareTransport(const QString& portName);
+    
+    /**
+     * @brief 关闭已打开的设备并开始异步打开
+     * @param config 完整配置
+     * @param timeout 总超时(ms)
+     */
+    void startOpen(const SerialConfig& config, int timeout);
+    
+    /**
+     * @brief 切换连接状态并发出stateChanged
+     */
+    void setDeviceState(DeviceState state);
+    
+    /**
+     * @brief 安排下一次重试
+     * @return 剩余时间不足以重试时返回false
+     */
+    bool scheduleOpenRetry();
+    
+    /**
+     * @brief 异步打开失败，关闭端口并报告错误
+     * @param message 错误信息
+     */
+    void failOpen(const QString& message);
+    
+    ReceiveBuffer m_writeBuffer;            ///< 尚未交给串口的发送暂存区
+    QList<PendingWrite> m_pendingWrites;    ///< 在途消息，按发送顺序排列
+    qint64 m_writeQueuedTotal;              ///< 累计进入暂存区的字节数
+    qint64 m_writeDoneTotal;                ///< 累计已写出的字节数
+    bool m_writeFlushScheduled;             ///< 已安排一次合并写出
+    std::atomic<bool> m_writeQueueFull;     ///< 曾因高水位拒绝消息
+    std::atomic<qint64> m_pendingWriteBytes;    ///< 已接受但未写出的字节数
+    std::atomic<qint64> m_writeHighWaterMark;   ///< 发送队列高水位
+    std::atomic<quint32> m_nextWriteId;     ///< 下一个消息编号
+    QTimer* m_writeTimer;                   ///< 发送无进展超时定时器
+    static const int WRITE_CHUNK_SIZE = 4096;   ///< 合并写出的块大小
+    static const int WRITE_TIMEOUT = 3000;      ///< 发送无进展超时(ms)
+    
     // CH34x设备识别常量
     static const quint16 CH341_VID = 0x1a86;      ///< WCH厂商ID
     static const quint16 CH341_PID_1 = 0x7523;    ///< CH340芯片产品ID
@@ -268,10 +789,90 @@ private:
     static const quint16 CH341_PID_4 = 0xe523;    ///< CH330芯片产品ID
     
     SerialConfig m_config;                ///< 当前配置
-    Statistics m_statistics;              ///< 统计信息
+    /**
+     * @brief 热路径上使用的统计计数器
+     * 全部为relaxed原子操作，时间戳取自单调时钟m_clock
+     */
+    struct Counters {
+        std::atomic<qint64> bytesReceived;
+        std::atomic<qint64> bytesSent;
+        std::atomic<qint64> packetsReceived;
+        std::atomic<qint64> packetsSent;
+        std::atomic<qint64> errors;
+        std::atomic<qint64> reconnects;
+        std::atomic<qint64> recoveries;
+        std::atomic<qint64> lastRecoveryUs;
+        std::atomic<qint64> maxRecoveryUs;
+        std::atomic<qint64> frameQueueOverflows;
+        std::atomic<qint64> maxIoLatencyUs;
+        std::atomic<qint64> maxHandoffLatencyNs;
+        std::atomic<qint64> framingErrors;
+        std::atomic<qint64> crcErrors;
+        std::atomic<qint64> sequenceErrors;
+        std::atomic<qint64> droppedFrames;
+        std::atomic<qint64> droppedBytes;
+        std::atomic<qint64> readPauses;
+        std::atomic<qint64> receiveBufferBytes;
+        std::atomic<qint64> receiveBufferCapacity;
+        std::atomic<qint64> receiveBufferPeak;
+        std::atomic<qint64> writeBufferCapacity;
+        std::atomic<qint64> writeBufferPeak;
+        std::atomic<qint64> lastReceiveNs;      ///< 0表示尚未接收
+        std::atomic<qint64> lastSendNs;         ///< 0表示尚未发送
+        std::atomic<qint64> frameSizeHistogram[FRAME_SIZE_BUCKETS];
+        std::atomic<qint64> readGapHistogram[READ_GAP_BUCKETS];
+        std::atomic<qint64> maxIntraFrameGapUs;
+        std::atomic<qint64> reads;
+        std::atomic<qint64> readSizeHistogram[READ_SIZE_BUCKETS];
+        std::atomic<qint64> wakeLatencyHistogram[WAKE_LATENCY_BUCKETS];
+    };
+    
+    Counters m_counters;                  ///< 统计计数器
+    QTimer* m_statsTimer;                 ///< 统计快照发布定时器
+    mutable QMutex m_statsMutex;          ///< 保护下面的起始时间和速率
+    QDateTime m_statsStartTime;           ///< 统计开始的日历时间
+    qint64 m_statsStartNs;                ///< 统计开始时的单调时钟读数
+    qint64 m_rateLastNs;                  ///< 上次计算速率的时刻
+    qint64 m_rateLastBytesRx;             ///< 上次计算速率时的计数
+    qint64 m_rateLastBytesTx;
+    qint64 m_rateLastFramesRx;
+    double m_receiveByteRate;             ///< 最近一个周期的速率
+    double m_sendByteRate;
+    double m_receiveFrameRate;
+    qint64 m_rateLastCpuNs;               ///< 上次计算时设备线程的CPU时间，-1表示需要重新取样
+    double m_ioCpuLoad;                   ///< 最近一个周期的设备线程CPU占用
+    static const int DEFAULT_STATS_INTERVAL = 1000;  ///< 默认快照发布周期(ms)
     QTimer* m_reconnectTimer;            ///< 重连定时器
-    QTimer* m_packageTimer;              ///< 数据包超时定时器
+    QTimer* m_packageTimer;              ///< 空闲截止定时器，数据包超时与GapFraming共用；单次触发，只在空闲时设置
+    qint64 m_lastReadNs;                 ///< 最后一次读到数据的时刻，取自m_clock
     int m_reconnectAttempts;             ///< 当前重连次数
+    bool m_reconnecting;                 ///< 断开后正在等待重连
+    qint64 m_linkLostNs;                 ///< 断开时刻，取自m_clock
+    qint64 m_recoveredNs;                ///< 最近一次重连成功的时刻，取自m_clock，-1表示没有
+    int m_recoveredAttempts;             ///< 最近一次重连成功时已尝试的次数
+    static const int RECONNECT_MIN_DELAY = 100;     ///< 首次重连等待(ms)
+    static const int RECONNECT_STABLE_TIME = 10000; ///< 重连后稳定这么久(ms)再断开才从头退避
+    static const int RECONNECT_OPEN_TIMEOUT = 500;  ///< 每次重连的打开超时(ms)，覆盖设备节点权限尚未就绪的窗口
+    
+    /**
+     * @brief 设备断开，开始重连
+     */
+    void startReconnect();
+    
+    /**
+     * @brief 当前传输层断开后能否重新打开，只有真实串口和Unix域套接字可以
+     */
+    bool canReconnect() const;
+    
+    /**
+     * @brief 取消重连
+     */
+    void stopReconnect();
+    
+    /**
+     * @brief 安排下一次重连，次数用尽时报告失败
+     */
+    void scheduleReconnect();
     
     /**
      * @brief 更新统计信息
@@ -282,6 +883,54 @@ private:
      */
     void updateStatistics(qint64 bytesRx = 0, qint64 bytesTx = 0,
                          qint64 packetsRx = 0, qint64 packetsTx = 0);
+    
+    /**
+     * @brief 记录一个帧长到直方图
+     * @param size 帧长（字节）
+     */
+    void recordFrameSize(int size);
+    
+    /**
+     * @brief 记录一次读取间隔
+     * @param gapNs 与上次读到数据的间隔(ns)
+     * @param withinFrame 间隔位于同一帧内
+     */
+    void recordReadGap(qint64 gapNs, bool withinFrame);
+    
+    /**
+     * @brief 记录一次读取的字节数
+     */
+    void recordReadSize(int size);
+    
+    /**
+     * @brief 设备就绪时按配置启用低延迟设置
+     */
+    void applyLowLatency();
+    
+    /**
+     * @brief 撤销低延迟设置，恢复线程原来的CPU亲和性和调度策略
+     */
+    void releaseLowLatency();
+    
+    std::atomic<bool> m_lowLatencyActive;    ///< 传输层低延迟设置已生效，可跨线程读取
+    bool m_threadTuned;                  ///< 已修改设备线程的亲和性或调度策略
+    QVector<int> m_savedCpus;            ///< 修改前线程可运行的CPU
+    int m_savedSchedPolicy;              ///< 修改前线程的调度策略
+    int m_savedSchedPriority;            ///< 修改前线程的调度优先级
+    
+    CaptureWriter m_capture;             ///< 原始收发数据捕获
+    QTimer* m_captureFlushTimer;         ///< 定期把捕获缓冲写入文件
+    static const int CAPTURE_FLUSH_INTERVAL = 1000;  ///< 捕获缓冲写入文件的周期(ms)
+    
+    /**
+     * @brief 计算最近一个周期的速率并发布统计快照
+     */
+    void publishStatistics();
+    
+    /**
+     * @brief 原子地更新最大值
+     */
+    static void updateMax(std::atomic<qint64>& target, qint64 value);
                          
     /**
      * @brief 尝试重新连接
@@ -289,4 +938,8 @@ private:
     void tryReconnect();
 };
 
+Q_DECLARE_METATYPE(CH34xQt::Statistics)
+Q_DECLARE_METATYPE(CH34xQt::Frame)
+Q_DECLARE_METATYPE(CH34xQt::OpenTiming)
+
 #endif // CH34X_QT_H 
@@ -1,81 +1,173 @@
 #include "chatbubblewidget.h"
+#include <QPainter>
+#include <QDateTime>
+#include <QtMath>
 #include <QScrollBar>
-#include <QPainterPath>
-
-ChatBubbleItem::ChatBubbleItem(const QString& message, const QDateTime& time, bool isFromMe, QWidget* parent)
-    : QWidget(parent)
-    , m_message(message)
-    , m_time(time)
-    , m_isFromMe(isFromMe)
-    , m_bubbleColor(isFromMe ? QColor("#95de64") : QColor("#69c0ff"))
-    , m_textColor(isFromMe ? QColor("#135200") : QColor("#003a8c"))
+
+ChatBubbleDelegate::ChatBubbleDelegate(QObject* parent)
+    : QStyledItemDelegate(parent)
+    , m_cache(CACHE_SIZE)
 {
-    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Minimum);
-    setMinimumHeight(50);
 }
 
-void ChatBubbleItem::paintEvent(QPaintEvent* event)
+void ChatBubbleDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option,
+                               const QModelIndex& index) const
 {
-    Q_UNUSED(event);
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-
-    // 计算文本区域
-    QFontMetrics fm(font());
-    QRect textRect = fm.boundingRect(0, 0, width() * 0.7, INT_MAX, 
-                                   Qt::TextWordWrap, m_message);
-    
-    // 计算气泡位置
-    int bubblePadding = 12;
-    int bubbleMargin = 20;
-    int timeHeight = 20;
-    QRect bubbleRect = textRect.adjusted(-bubblePadding, -bubblePadding,
-                                       bubblePadding, bubblePadding);
-    
-    if(m_isFromMe) {
-        bubbleRect.moveRight(width() - bubbleMargin);
+    const ChatMessageModel* model = qobject_cast<const ChatMessageModel*>(index.model());
+    if(!model) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    const ChatMessageModel::Message& message = model->message(index.row());
+    const BubbleLayout* layout = layoutFor(option, message);
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setFont(option.font);
+    if(message.kind == ChatMessageModel::System) {
+        paintSystem(painter, option.rect, *layout);
     } else {
-        bubbleRect.moveLeft(bubbleMargin);
+        paintBubble(painter, option.rect, *layout, message.kind == ChatMessageModel::Sent);
     }
-    bubbleRect.moveTop(timeHeight);
+    painter->restore();
+}
 
-    // 绘制时间
-    painter.setPen(QColor("#8c8c8c"));
-    QString timeStr = m_time.toString("hh:mm:ss");
-    QRect timeRect(0, 0, width(), timeHeight);
-    painter.drawText(timeRect, m_isFromMe ? Qt::AlignRight : Qt::AlignLeft, 
-                    QString("[%1]").arg(timeStr));
+QSize ChatBubbleDelegate::sizeHint(const QStyleOptionViewItem& option,
+                                   const QModelIndex& index) const
+{
+    const ChatMessageModel* model = qobject_cast<const ChatMessageModel*>(index.model());
+    if(!model) {
+        return QStyledItemDelegate::sizeHint(option, index);
+    }
+    return QSize(option.rect.width(), layoutFor(option, model->message(index.row()))->height);
+}
 
-    // 绘制气泡
-    QPainterPath path;
-    int radius = 16;
-    int triangleSize = 8;
-    
-    if(m_isFromMe) {
-        // 右侧气泡
-        path.addRoundedRect(bubbleRect, radius, radius);
-        QPolygonF triangle;
-        triangle << bubbleRect.topRight() + QPoint(triangleSize, triangleSize)
-                << bubbleRect.topRight() + QPoint(-triangleSize, triangleSize * 2)
-                << bubbleRect.topRight() + QPoint(-triangleSize, 0);
-        path.addPolygon(triangle);
+/**
+ * @brief 排版一条消息
+ *
+ * @details
+ * 1. 缓存中的结果宽度和字体都相同时直接返回
+ * 2. 收发消息：文本按70%宽度折行，气泡大小为最长一行加内边距，
+ *    行高为时间行 + 气泡高度，不低于MIN_HEIGHT；时间文本预先排版
+ * 3. 系统提示："[时间] 内容"按整行宽度减内边距居中折行，标签居中
+ * 4. 气泡外形以其左上角为原点生成，绘制时平移到所在位置
+ */
+const ChatBubbleDelegate::BubbleLayout* ChatBubbleDelegate::layoutFor(
+        const QStyleOptionViewItem& option, const ChatMessageModel::Message& message) const
+{
+    const int width = option.rect.width();
+    BubbleLayout* layout = m_cache.object(message.id);
+    if(layout && layout->width == width && layout->font == option.font) {
+        return layout;
+    }
+
+    layout = new BubbleLayout;
+    layout->width = width;
+    layout->font = option.font;
+    layout->text.setFont(option.font);
+    layout->text.setCacheEnabled(true);
+
+    const QString time = QDateTime::fromMSecsSinceEpoch(message.time).toString("hh:mm:ss");
+    if(message.kind == ChatMessageModel::System) {
+        QTextOption textOption(Qt::AlignHCenter);
+        textOption.setWrapMode(QTextOption::WordWrap);
+        layout->text.setTextOption(textOption);
+        layout->text.setText(QString("[%1] %2").arg(time, message.text));
+
+        const QSizeF textSize = layoutText(layout->text, qMax(1, width - 2 * SYSTEM_PADDING_X));
+        layout->boxSize = QSize(qCeil(textSize.width()) + 2 * SYSTEM_PADDING_X,
+                                qCeil(textSize.height()) + 2 * SYSTEM_PADDING_Y);
+        layout->path.addRoundedRect(QRectF(QPointF(0, 0), layout->boxSize),
+                                    SYSTEM_RADIUS, SYSTEM_RADIUS);
+        layout->height = layout->boxSize.height();
     } else {
-        // 左侧气泡
-        path.addRoundedRect(bubbleRect, radius, radius);
+        QTextOption textOption(Qt::AlignLeft);
+        textOption.setWrapMode(QTextOption::WordWrap);
+        layout->text.setTextOption(textOption);
+        layout->text.setText(message.text);
+
+        const QSizeF textSize = layoutText(layout->text, qMax(1, int(width * 0.7)));
+        layout->boxSize = QSize(qCeil(textSize.width()) + 2 * BUBBLE_PADDING,
+                                qCeil(textSize.height()) + 2 * BUBBLE_PADDING);
+
+        const QRect bubbleRect(QPoint(0, 0), layout->boxSize);
+        layout->path.addRoundedRect(bubbleRect, BUBBLE_RADIUS, BUBBLE_RADIUS);
         QPolygonF triangle;
-        triangle << bubbleRect.topLeft() + QPoint(-triangleSize, triangleSize)
-                << bubbleRect.topLeft() + QPoint(triangleSize, triangleSize * 2)
-                << bubbleRect.topLeft() + QPoint(triangleSize, 0);
-        path.addPolygon(triangle);
+        if(message.kind == ChatMessageModel::Sent) {
+            // 右侧气泡
+            triangle << bubbleRect.topRight() + QPoint(TRIANGLE_SIZE, TRIANGLE_SIZE)
+                     << bubbleRect.topRight() + QPoint(-TRIANGLE_SIZE, TRIANGLE_SIZE * 2)
+                     << bubbleRect.topRight() + QPoint(-TRIANGLE_SIZE, 0);
+        } else {
+            // 左侧气泡
+            triangle << bubbleRect.topLeft() + QPoint(-TRIANGLE_SIZE, TRIANGLE_SIZE)
+                     << bubbleRect.topLeft() + QPoint(TRIANGLE_SIZE, TRIANGLE_SIZE * 2)
+                     << bubbleRect.topLeft() + QPoint(TRIANGLE_SIZE, 0);
+        }
+        layout->path.addPolygon(triangle);
+
+        layout->time.setText(QString("[%1]").arg(time));
+        layout->time.setTextFormat(Qt::PlainText);
+        layout->time.prepare(QTransform(), option.font);
+        layout->height = qMax(int(MIN_HEIGHT), TIME_HEIGHT + layout->boxSize.height());
+    }
+
+    m_cache.insert(message.id, layout);
+    return layout;
+}
+
+QSizeF ChatBubbleDelegate::layoutText(QTextLayout& layout, qreal lineWidth)
+{
+    qreal height = 0;
+    qreal naturalWidth = 0;
+    layout.beginLayout();
+    for(QTextLine line = layout.createLine(); line.isValid(); line = layout.createLine()) {
+        line.setLineWidth(lineWidth);
+        line.setPosition(QPointF(0, height));
+        height += line.height();
+        naturalWidth = qMax(naturalWidth, line.naturalTextWidth());
     }
+    layout.endLayout();
+    return QSizeF(naturalWidth, height);
+}
 
-    painter.setPen(Qt::NoPen);
-    painter.setBrush(m_bubbleColor);
-    painter.drawPath(path);
+void ChatBubbleDelegate::paintBubble(QPainter* painter, const QRect& rect,
+                                     const BubbleLayout& layout, bool isFromMe) const
+{
+    const QColor bubbleColor = isFromMe ? QColor("#95de64") : QColor("#69c0ff");
+    const QColor textColor = isFromMe ? QColor("#135200") : QColor("#003a8c");
+
+    // 绘制时间
+    painter->setPen(QColor("#8c8c8c"));
+    const qreal timeX = isFromMe ? rect.right() + 1 - layout.time.size().width() : rect.left();
+    painter->drawStaticText(QPointF(timeX, rect.top()), layout.time);
+
+    // 绘制气泡
+    const int bubbleX = isFromMe ? rect.right() + 1 - BUBBLE_MARGIN - layout.boxSize.width()
+                                 : rect.left() + BUBBLE_MARGIN;
+    painter->translate(bubbleX, rect.top() + TIME_HEIGHT);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(bubbleColor);
+    painter->drawPath(layout.path);
 
     // 绘制文本
-    painter.setPen(m_textColor);
-    painter.drawText(bubbleRect, Qt::AlignLeft | Qt::TextWordWrap, m_message);
+    painter->setPen(textColor);
+    layout.text.draw(painter, QPointF(BUBBLE_PADDING, BUBBLE_PADDING));
+}
+
+void ChatBubbleDelegate::paintSystem(QPainter* painter, const QRect& rect,
+                                     const BubbleLayout& layout) const
+{
+    // 标签居中，文本按整行可用宽度居中排版
+    const int labelX = rect.left() + (rect.width() - layout.boxSize.width()) / 2;
+    painter->translate(labelX, rect.top());
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(QColor(0, 0, 0, 25));
+    painter->drawPath(layout.path);
+
+    painter->setPen(QColor("#666666"));
+    const qreal textX = rect.left() + SYSTEM_PADDING_X - labelX;
+    layout.text.draw(painter, QPointF(textX, SYSTEM_PADDING_Y));
 }
 
 ChatBubbleWidget::ChatBubbleWidget(QWidget* parent) : QWidget(parent)
@@ -84,23 +176,18 @@ ChatBubbleWidget::ChatBubbleWidget(QWidget* parent) : QWidget(parent)
     m_layout->setSpacing(0);
     m_layout->setContentsMargins(0, 0, 0, 0);
 
-    // 创建一个容器来放置气泡
-    m_container = new QWidget;
-    m_containerLayout = new QVBoxLayout(m_container);
-    m_containerLayout->setSpacing(10);
-    m_containerLayout->setContentsMargins(10, 10, 10, 10);
-    m_containerLayout->addStretch();
-
-    // 创建滚动区域
-    QScrollArea* scrollArea = new QScrollArea;
-    scrollArea->setWidget(m_container);
-    scrollArea->setWidgetResizable(true);
-    scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    scrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-    
-    // 设置滚动区域样式，隐藏滚动条
-    scrollArea->setStyleSheet(R"(
-        QScrollArea {
+    m_model = new ChatMessageModel(this);
+
+    // 创建视图，消息只在可见时绘制
+    m_view = new ChatListView;
+    m_view->setItemDelegate(new ChatBubbleDelegate(m_view));
+    m_view->setModel(m_model);
+    m_view->setFrameShape(QFrame::NoFrame);
+    m_view->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+
+    // 设置视图样式，隐藏滚动条
+    m_view->setStyleSheet(R"(
+        ChatListView {
             border: none;
             background: white;
         }
@@ -119,44 +206,82 @@ ChatBubbleWidget::ChatBubbleWidget(QWidget* parent) : QWidget(parent)
         }
     )");
 
-    m_layout->addWidget(scrollArea);
-    m_scrollBar = scrollArea->verticalScrollBar();
+    m_layout->addWidget(m_view);
+
+    connect(m_view->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &ChatBubbleWidget::handleScroll);
 }
 
 void ChatBubbleWidget::addMessage(const QString& message, bool isFromMe)
 {
-    ChatBubbleItem* bubble = new ChatBubbleItem(message, QDateTime::currentDateTime(), 
-                                               isFromMe, m_container);
-    m_containerLayout->insertWidget(m_containerLayout->count() - 1, bubble);
-    
+    m_model->append(message, isFromMe ? ChatMessageModel::Sent : ChatMessageModel::Received);
+
     if(m_autoScroll) {
-        m_scrollBar->setValue(m_scrollBar->maximum());
+        scrollToLatest();
     }
 }
 
 void ChatBubbleWidget::addSystemMessage(const QString& message)
 {
-    QLabel* systemMsg = new QLabel(m_container);
-    systemMsg->setAlignment(Qt::AlignCenter);
-    systemMsg->setText(QString("<div style='background: rgba(0,0,0,0.1); padding: 6px 12px; "
-                              "border-radius: 12px; color: #666666;'>[%1] %2</div>")
-                      .arg(QTime::currentTime().toString("hh:mm:ss"))
-                      .arg(message));
-    m_containerLayout->insertWidget(m_containerLayout->count() - 1, systemMsg);
-    
+    m_model->append(message, ChatMessageModel::System);
+
+    if(m_autoScroll) {
+        scrollToLatest();
+    }
+}
+
+void ChatBubbleWidget::addMessages(const QVector<ChatMessageModel::Message>& messages)
+{
+    if(messages.isEmpty()) {
+        return;
+    }
+    m_model->append(messages);
+
     if(m_autoScroll) {
-        m_scrollBar->setValue(m_scrollBar->maximum());
+        scrollToLatest();
     }
 }
 
 void ChatBubbleWidget::clear()
 {
-    QLayoutItem* item;
-    while((item = m_containerLayout->takeAt(0)) != nullptr) {
-        if(item->widget()) {
-            delete item->widget();
+    m_model->clear();
+}
+
+/**
+ * @brief 按滚动位置读回消息
+ *
+ * @details
+ * 1. 距顶部不足一页时在前面插入较早的消息，视图保持原来的行不动，
+ *    插入后仍不足一页则继续读回，直到到达最早的消息
+ * 2. 距底部不足一页时在后面追加较新的消息
+ * 3. 读回后超出上限的消息从窗口另一端移除，内存占用不随浏览的范围增长
+ */
+void ChatBubbleWidget::handleScroll(int value)
+{
+    Q_UNUSED(value);
+    if(m_paging) {
+        return;
+    }
+
+    m_paging = true;
+    QScrollBar* scrollBar = m_view->verticalScrollBar();
+    while(scrollBar->value() < scrollBar->pageStep()) {
+        if(!m_model->fetchOlder()) {
+            break;
+        }
+    }
+    while(scrollBar->value() > scrollBar->maximum() - scrollBar->pageStep()) {
+        if(!m_model->fetchNewer()) {
+            break;
         }
-        delete item;
     }
-    m_containerLayout->addStretch();
-} 
\ No newline at end of file
+    m_paging = false;
+}
+
+void ChatBubbleWidget::scrollToLatest()
+{
+    m_paging = true;
+    m_model->showLatest();
+    m_view->scrollToBottom();
+    m_paging = false;
+}
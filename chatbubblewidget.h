@@ -3,47 +3,130 @@
 
 #include <QWidget>
 #include <QVBoxLayout>
-#include <QLabel>
-#include <QPainter>
-#include <QDateTime>
-#include <QScrollBar>
-#include <QScrollArea>
+#include <QStyledItemDelegate>
+#include <QTextLayout>
+#include <QStaticText>
+#include <QPainterPath>
+#include <QCache>
+#include "chatmessagemodel.h"
+#include "chatlistview.h"
 
-class ChatBubbleItem : public QWidget
+/**
+ * @brief 绘制聊天气泡的委托
+ *
+ * 收发消息画成带时间的左右气泡，系统提示画成居中的灰色圆角标签。
+ * 每条消息的折行结果、时间文本和气泡外形按消息编号缓存，
+ * 只在宽度或字体变化时重新计算：sizeHint()测量时生成的布局直接用于绘制，
+ * 滚动和重绘不再做文本排版。缓存最多保存CACHE_SIZE条消息，
+ * 超出后淘汰最久未用的，淘汰的消息再次可见时重新排版一次。
+ * 模型不是ChatMessageModel时按QStyledItemDelegate的默认方式显示。
+ */
+class ChatBubbleDelegate : public QStyledItemDelegate
 {
     Q_OBJECT
 public:
-    explicit ChatBubbleItem(const QString& message, const QDateTime& time, bool isFromMe, QWidget* parent = nullptr);
+    explicit ChatBubbleDelegate(QObject* parent = nullptr);
 
-protected:
-    void paintEvent(QPaintEvent* event) override;
+    void paint(QPainter* painter, const QStyleOptionViewItem& option,
+               const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option,
+                   const QModelIndex& index) const override;
 
 private:
-    QString m_message;
-    QDateTime m_time;
-    bool m_isFromMe;
-    QColor m_bubbleColor;
-    QColor m_textColor;
+    /**
+     * @brief 一条消息排版后的结果
+     */
+    struct BubbleLayout {
+        int width;              ///< 排版时的可用宽度
+        QFont font;             ///< 排版时的字体
+        QTextLayout text;       ///< 已折行的文本，保留字形供绘制
+        QStaticText time;       ///< "[hh:mm:ss]"，系统提示不使用
+        QPainterPath path;      ///< 气泡或标签外形，原点为其左上角
+        QSize boxSize;          ///< 气泡或标签大小
+        int height;             ///< 行高
+    };
+
+    /**
+     * @brief 取得消息的排版结果，宽度或字体不符时重新排版
+     */
+    const BubbleLayout* layoutFor(const QStyleOptionViewItem& option,
+                                  const ChatMessageModel::Message& message) const;
+
+    /**
+     * @brief 按可用宽度折行，返回最长一行的宽度和总高度
+     */
+    static QSizeF layoutText(QTextLayout& layout, qreal lineWidth);
+
+    void paintBubble(QPainter* painter, const QRect& rect, const BubbleLayout& layout,
+                     bool isFromMe) const;
+    void paintSystem(QPainter* painter, const QRect& rect, const BubbleLayout& layout) const;
+
+    mutable QCache<quint64, BubbleLayout> m_cache;  ///< 按消息编号缓存的排版结果
+
+    static const int CACHE_SIZE = 4096;     ///< 缓存的消息数
+    static const int BUBBLE_PADDING = 12;   ///< 气泡内边距
+    static const int BUBBLE_MARGIN = 20;    ///< 气泡到两侧的距离
+    static const int TIME_HEIGHT = 20;      ///< 时间行高度
+    static const int BUBBLE_RADIUS = 16;    ///< 气泡圆角
+    static const int TRIANGLE_SIZE = 8;     ///< 气泡尖角大小
+    static const int MIN_HEIGHT = 50;       ///< 消息最小高度
+    static const int SYSTEM_PADDING_X = 12; ///< 系统提示水平内边距
+    static const int SYSTEM_PADDING_Y = 6;  ///< 系统提示垂直内边距
+    static const int SYSTEM_RADIUS = 12;    ///< 系统提示圆角
 };
 
+/**
+ * @brief 聊天显示区
+ *
+ * 消息保存在ChatMessageModel中，由ChatListView按可见行交给ChatBubbleDelegate绘制，
+ * 不为每条消息创建控件，消息数增长时追加和滚动的开销不变。
+ * 模型设置了上限和日志文件时，滚动到距顶部或底部不足一页时从日志读回相邻的一页；
+ * 自动滚动时新消息总是把窗口换回最新的消息。
+ */
 class ChatBubbleWidget : public QWidget
 {
     Q_OBJECT
 public:
     explicit ChatBubbleWidget(QWidget* parent = nullptr);
-    
+
     void addMessage(const QString& message, bool isFromMe);
     void addSystemMessage(const QString& message);
+
+    /**
+     * @brief 追加一批消息，只布局和滚动一次，消息保留各自的时间
+     */
+    void addMessages(const QVector<ChatMessageModel::Message>& messages);
     void clear();
     void setAutoScroll(bool enabled) { m_autoScroll = enabled; }
     bool autoScroll() const { return m_autoScroll; }
 
+    /**
+     * @brief 消息条数
+     */
+    int messageCount() const { return m_model->rowCount(); }
+
+    /**
+     * @brief 消息模型
+     */
+    ChatMessageModel* model() const { return m_model; }
+
+private slots:
+    /**
+     * @brief 接近窗口两端时从日志读回相邻的消息
+     */
+    void handleScroll(int value);
+
 private:
+    /**
+     * @brief 回到最新的消息并滚动到底部
+     */
+    void scrollToLatest();
+
     QVBoxLayout* m_layout;
-    QWidget* m_container;
-    QVBoxLayout* m_containerLayout;
-    QScrollBar* m_scrollBar;
+    ChatMessageModel* m_model;
+    ChatListView* m_view;
     bool m_autoScroll = true;
+    bool m_paging = false;      ///< 正在读回消息，读回引起的滚动不再触发读回
 };
 
-#endif // CHATBUBBLEWIDGET_H 
\ No newline at end of file
+#endif // CHATBUBBLEWIDGET_H
\ No newline at end of file
@@ -0,0 +1,562 @@
+#include "chatlistview.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollBar>
+#include <QTimer>
+#include <algorithm>
+#include <climits>
+
+ChatListView::ChatListView(QWidget* parent)
+    : QAbstractItemView(parent)
+    , m_layoutWidth(0)
+    , m_relayoutRow(-1)
+{
+    setSelectionMode(QAbstractItemView::NoSelection);
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+
+    m_relayoutTimer = new QTimer(this);
+    m_relayoutTimer->setInterval(0);
+    connect(m_relayoutTimer, &QTimer::timeout,
+            this, &ChatListView::relayoutBatch);
+}
+
+void ChatListView::setModel(QAbstractItemModel* model)
+{
+    QAbstractItemView::setModel(model);
+    layoutAll();
+}
+
+void ChatListView::reset()
+{
+    QAbstractItemView::reset();
+    layoutAll();
+}
+
+bool ChatListView::isAtBottom() const
+{
+    return verticalScrollBar()->value() >= verticalScrollBar()->maximum();
+}
+
+QRect ChatListView::visualRect(const QModelIndex& index) const
+{
+    if(!index.isValid() || index.row() >= m_heights.size()) {
+        return QRect();
+    }
+
+    const qint64 top = MARGIN + rowTop(index.row()) - verticalOffset();
+    return QRect(MARGIN, int(top), itemWidth(), m_heights.at(index.row()) - SPACING);
+}
+
+void ChatListView::scrollTo(const QModelIndex& index, ScrollHint hint)
+{
+    if(!index.isValid() || index.row() >= m_heights.size()) {
+        return;
+    }
+
+    const qint64 top = MARGIN + rowTop(index.row());
+    const qint64 bottom = top + m_heights.at(index.row()) - SPACING;
+    const int viewHeight = viewport()->height();
+    const qint64 offset = verticalOffset();
+    qint64 value = offset;
+
+    switch(hint) {
+        case PositionAtTop:
+            value = top;
+            break;
+        case PositionAtBottom:
+            value = bottom - viewHeight;
+            break;
+        case PositionAtCenter:
+            value = (top + bottom - viewHeight) / 2;
+            break;
+        case EnsureVisible:
+        default:
+            if(top < offset) {
+                value = top;
+            } else if(bottom > offset + viewHeight) {
+                value = bottom - viewHeight;
+            }
+            break;
+    }
+    verticalScrollBar()->setValue(int(qBound<qint64>(0, value, INT_MAX)));
+}
+
+QModelIndex ChatListView::indexAt(const QPoint& point) const
+{
+    if(!model() || m_heights.isEmpty()) {
+        return QModelIndex();
+    }
+
+    const qint64 y = qint64(point.y()) + verticalOffset() - MARGIN;
+    if(y < 0 || y >= rowTop(m_heights.size())
+       || point.x() < MARGIN || point.x() >= MARGIN + itemWidth()) {
+        return QModelIndex();
+    }
+
+    // 落在行间距上的点不属于任何行
+    const int row = rowAt(y);
+    if(y >= rowTop(row) + m_heights.at(row) - SPACING) {
+        return QModelIndex();
+    }
+    return model()->index(row, 0, rootIndex());
+}
+
+QModelIndex ChatListView::moveCursor(CursorAction cursorAction, Qt::KeyboardModifiers modifiers)
+{
+    Q_UNUSED(modifiers);
+    if(!model() || m_heights.isEmpty()) {
+        return QModelIndex();
+    }
+
+    const int last = m_heights.size() - 1;
+    const QModelIndex current = currentIndex();
+    int row = current.isValid() ? current.row() : rowAt(qMax(0, verticalOffset() - MARGIN));
+    switch(cursorAction) {
+        case MoveUp:
+        case MovePrevious:
+            row = qMax(0, row - 1);
+            break;
+        case MoveDown:
+        case MoveNext:
+            row = qMin(last, row + 1);
+            break;
+        case MovePageUp:
+            row = rowAt(qMax<qint64>(0, rowTop(row) - viewport()->height()));
+            break;
+        case MovePageDown:
+            row = rowAt(rowTop(row) + viewport()->height());
+            break;
+        case MoveHome:
+            row = 0;
+            break;
+        case MoveEnd:
+            row = last;
+            break;
+        default:
+            break;
+    }
+    return model()->index(row, 0, rootIndex());
+}
+
+int ChatListView::horizontalOffset() const
+{
+    return 0;
+}
+
+int ChatListView::verticalOffset() const
+{
+    return verticalScrollBar()->value();
+}
+
+bool ChatListView::isIndexHidden(const QModelIndex& index) const
+{
+    Q_UNUSED(index);
+    return false;
+}
+
+void ChatListView::setSelection(const QRect& rect, QItemSelectionModel::SelectionFlags command)
+{
+    if(!model() || !selectionModel() || m_heights.isEmpty()) {
+        return;
+    }
+
+    const qint64 offset = verticalOffset() - MARGIN;
+    const int first = rowAt(qMax<qint64>(0, rect.top() + offset));
+    const int last = rowAt(qMax<qint64>(0, rect.bottom() + offset));
+    const QItemSelection selection(model()->index(first, 0, rootIndex()),
+                                   model()->index(last, 0, rootIndex()));
+    selectionModel()->select(selection, command);
+}
+
+QRegion ChatListView::visualRegionForSelection(const QItemSelection& selection) const
+{
+    QRegion region;
+    if(m_heights.isEmpty()) {
+        return region;
+    }
+
+    // 只计算可见的行，选中很多行时不逐行遍历
+    const qint64 offset = verticalOffset() - MARGIN;
+    const int firstVisible = rowAt(qMax<qint64>(0, offset));
+    const int lastVisible = rowAt(qMax<qint64>(0, offset + viewport()->height()));
+    for(const QItemSelectionRange& range : selection) {
+        const int first = qMax(range.top(), firstVisible);
+        const int last = qMin(range.bottom(), lastVisible);
+        for(int row = first; row <= last; ++row) {
+            region += visualRect(model()->index(row, 0, rootIndex()));
+        }
+    }
+    return region;
+}
+
+/**
+ * @brief 绘制可见的行
+ *
+ * @details
+ * 1. 由重绘区域顶部在树状数组上定位第一行
+ * 2. 逐行交给委托绘制，直到超出重绘区域底部
+ */
+void ChatListView::paintEvent(QPaintEvent* event)
+{
+    if(!model() || m_heights.isEmpty()) {
+        return;
+    }
+
+    QPainter painter(viewport());
+    QStyleOptionViewItem option = viewOptions();
+    const QRect area = event->rect();
+    const qint64 offset = verticalOffset();
+    const int width = itemWidth();
+    const int count = m_heights.size();
+
+    int row = rowAt(qMax<qint64>(0, offset + area.top() - MARGIN));
+    qint64 top = MARGIN + rowTop(row) - offset;
+    for(; row < count && top <= area.bottom(); ++row) {
+        const int height = m_heights.at(row);
+        option.rect = QRect(MARGIN, int(top), width, height - SPACING);
+        itemDelegate()->paint(&painter, option, model()->index(row, 0, rootIndex()));
+        top += height;
+    }
+}
+
+void ChatListView::resizeEvent(QResizeEvent* event)
+{
+    // 在滚动范围按新高度调整之前记下位置
+    const ScrollAnchor anchor = scrollAnchor();
+    QAbstractItemView::resizeEvent(event);
+    if(itemWidth() == m_layoutWidth || m_heights.isEmpty()) {
+        m_layoutWidth = itemWidth();
+        if(anchor.atBottom) {
+            restoreScroll(anchor);
+        }
+        return;
+    }
+
+    m_layoutWidth = itemWidth();
+    relayout(anchor);
+}
+
+void ChatListView::changeEvent(QEvent* event)
+{
+    QAbstractItemView::changeEvent(event);
+    if((event->type() == QEvent::FontChange || event->type() == QEvent::StyleChange)
+       && !m_heights.isEmpty()) {
+        relayout(scrollAnchor());
+    }
+}
+
+void ChatListView::updateGeometries()
+{
+    const int viewHeight = viewport()->height();
+    const qint64 maximum = qMax<qint64>(0, contentHeight() - viewHeight);
+    verticalScrollBar()->setRange(0, int(qMin<qint64>(INT_MAX, maximum)));
+    verticalScrollBar()->setPageStep(viewHeight);
+    verticalScrollBar()->setSingleStep(SCROLL_STEP);
+    horizontalScrollBar()->setRange(0, 0);
+    QAbstractItemView::updateGeometries();
+}
+
+/**
+ * @brief 测量插入的行
+ *
+ * @details
+ * 1. 追加在末尾时逐行追加到树状数组，已有行的位置不变，不需要恢复滚动位置
+ * 2. 插入在中间时重建树状数组，并按记下的行恢复滚动位置
+ * 3. 插入的行落在视口内时才重绘
+ */
+void ChatListView::rowsInserted(const QModelIndex& parent, int start, int end)
+{
+    if(parent == rootIndex() && start <= m_heights.size()) {
+        const QStyleOptionViewItem option = measureOption();
+        const int count = end - start + 1;
+
+        if(start == m_heights.size()) {
+            m_heights.reserve(m_heights.size() + count);
+            m_tree.reserve(m_tree.size() + count);
+            for(int row = start; row <= end; ++row) {
+                appendHeight(measureRow(option, row));
+            }
+            updateGeometries();
+        } else {
+            ScrollAnchor anchor = scrollAnchor();
+            QVector<int> heights;
+            heights.reserve(count);
+            for(int row = start; row <= end; ++row) {
+                heights.append(measureRow(option, row));
+            }
+            m_heights.insert(start, count, 0);
+            std::copy(heights.cbegin(), heights.cend(), m_heights.begin() + start);
+            rebuildTree();
+
+            if(anchor.row >= start) {
+                anchor.row += count;
+            }
+            if(m_relayoutRow > start) {
+                m_relayoutRow += count;
+            }
+            updateGeometries();
+            restoreScroll(anchor);
+        }
+
+        if(MARGIN + rowTop(start) < qint64(verticalOffset()) + viewport()->height()) {
+            viewport()->update();
+        }
+    }
+    QAbstractItemView::rowsInserted(parent, start, end);
+}
+
+void ChatListView::rowsAboutToBeRemoved(const QModelIndex& parent, int start, int end)
+{
+    if(parent == rootIndex() && start < m_heights.size()) {
+        ScrollAnchor anchor = scrollAnchor();
+        const int last = qMin(end, m_heights.size() - 1);
+        const int count = last - start + 1;
+
+        m_heights.remove(start, count);
+        rebuildTree();
+
+        if(anchor.row > last) {
+            anchor.row -= count;
+        } else if(anchor.row >= start) {
+            anchor.row = start;
+            anchor.offset = 0;
+        }
+        if(m_relayoutRow > start) {
+            m_relayoutRow = qMax(start, m_relayoutRow - count);
+        }
+        if(m_relayoutRow >= m_heights.size()) {
+            m_relayoutRow = -1;
+            m_relayoutTimer->stop();
+        }
+        updateGeometries();
+        restoreScroll(anchor);
+        viewport()->update();
+    }
+    QAbstractItemView::rowsAboutToBeRemoved(parent, start, end);
+}
+
+void ChatListView::dataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                               const QVector<int>& roles)
+{
+    if(topLeft.isValid() && bottomRight.isValid() && topLeft.parent() == rootIndex()) {
+        const ScrollAnchor anchor = scrollAnchor();
+        const QStyleOptionViewItem option = measureOption();
+        const int last = qMin(bottomRight.row(), m_heights.size() - 1);
+        for(int row = topLeft.row(); row <= last; ++row) {
+            setHeight(row, measureRow(option, row));
+        }
+        updateGeometries();
+        restoreScroll(anchor);
+        viewport()->update();
+    }
+    QAbstractItemView::dataChanged(topLeft, bottomRight, roles);
+}
+
+void ChatListView::relayoutBatch()
+{
+    if(m_relayoutRow < 0 || m_relayoutRow >= m_heights.size()) {
+        m_relayoutRow = -1;
+        m_relayoutTimer->stop();
+        return;
+    }
+
+    const ScrollAnchor anchor = scrollAnchor();
+    const QStyleOptionViewItem option = measureOption();
+    const int last = qMin(m_relayoutRow + RELAYOUT_BATCH, m_heights.size());
+    for(int row = m_relayoutRow; row < last; ++row) {
+        setHeight(row, measureRow(option, row));
+    }
+    m_relayoutRow = last < m_heights.size() ? last : -1;
+    if(m_relayoutRow < 0) {
+        m_relayoutTimer->stop();
+    }
+
+    // 可见的行已在resizeEvent中测量过，这里只需更新滚动范围
+    updateGeometries();
+    restoreScroll(anchor);
+}
+
+/**
+ * @brief 按新的宽度或字体重新测量行高
+ *
+ * @details
+ * 1. 立即测量从记下的行起填满视口的行，停在底部时从最后一行往上测量
+ * 2. 其余的行交给定时器分批测量，每批后按记下的行恢复滚动位置
+ */
+void ChatListView::relayout(const ScrollAnchor& anchor)
+{
+    const QStyleOptionViewItem option = measureOption();
+    const int count = m_heights.size();
+
+    if(anchor.atBottom) {
+        qint64 filled = 0;
+        for(int row = count - 1; row >= 0 && filled < viewport()->height(); --row) {
+            setHeight(row, measureRow(option, row));
+            filled += m_heights.at(row);
+        }
+    } else if(anchor.row >= 0) {
+        qint64 filled = -anchor.offset;
+        for(int row = anchor.row; row < count && filled < viewport()->height(); ++row) {
+            setHeight(row, measureRow(option, row));
+            filled += m_heights.at(row);
+        }
+    }
+
+    m_relayoutRow = 0;
+    m_relayoutTimer->start();
+    updateGeometries();
+    restoreScroll(anchor);
+    viewport()->update();
+}
+
+ChatListView::ScrollAnchor ChatListView::scrollAnchor() const
+{
+    ScrollAnchor anchor{-1, 0, isAtBottom()};
+    if(!m_heights.isEmpty()) {
+        const qint64 y = qMax<qint64>(0, qint64(verticalOffset()) - MARGIN);
+        anchor.row = rowAt(y);
+        anchor.offset = verticalOffset() - (MARGIN + rowTop(anchor.row));
+    }
+    return anchor;
+}
+
+void ChatListView::restoreScroll(const ScrollAnchor& anchor)
+{
+    QScrollBar* bar = verticalScrollBar();
+    if(anchor.atBottom) {
+        bar->setValue(bar->maximum());
+    } else if(anchor.row >= 0 && !m_heights.isEmpty()) {
+        const int row = qMin(anchor.row, m_heights.size() - 1);
+        const qint64 value = MARGIN + rowTop(row) + anchor.offset;
+        bar->setValue(int(qBound<qint64>(0, value, INT_MAX)));
+    }
+}
+
+QStyleOptionViewItem ChatListView::measureOption() const
+{
+    QStyleOptionViewItem option = viewOptions();
+    option.rect = QRect(0, 0, itemWidth(), 0);
+    return option;
+}
+
+int ChatListView::measureRow(const QStyleOptionViewItem& option, int row) const
+{
+    const QSize size = itemDelegate()->sizeHint(option, model()->index(row, 0, rootIndex()));
+    return qMax(1, size.height()) + SPACING;
+}
+
+void ChatListView::layoutAll()
+{
+    m_relayoutTimer->stop();
+    m_relayoutRow = -1;
+    m_layoutWidth = itemWidth();
+    m_heights.clear();
+    m_tree.clear();
+
+    const int count = model() ? model()->rowCount(rootIndex()) : 0;
+    if(count > 0) {
+        const QStyleOptionViewItem option = measureOption();
+        m_heights.reserve(count);
+        for(int row = 0; row < count; ++row) {
+            m_heights.append(measureRow(option, row));
+        }
+    }
+    rebuildTree();
+    updateGeometries();
+    viewport()->update();
+}
+
+int ChatListView::itemWidth() const
+{
+    return qMax(1, viewport()->width() - 2 * MARGIN);
+}
+
+qint64 ChatListView::rowTop(int row) const
+{
+    qint64 sum = 0;
+    for(int i = row; i > 0; i -= i & -i) {
+        sum += m_tree.at(i);
+    }
+    return sum;
+}
+
+/**
+ * @brief 由纵坐标定位行
+ *
+ * @details
+ * 在树状数组上从最高位往下逐位试探，找到前缀和不超过y的最多行数，即y所在的行；
+ * 超出末尾时返回最后一行
+ */
+int ChatListView::rowAt(qint64 y) const
+{
+    const int count = m_heights.size();
+    if(count == 0) {
+        return -1;
+    }
+
+    int step = 1;
+    while(step * 2 <= count) {
+        step *= 2;
+    }
+
+    int pos = 0;
+    qint64 remaining = y;
+    for(; step > 0; step /= 2) {
+        if(pos + step <= count && m_tree.at(pos + step) <= remaining) {
+            pos += step;
+            remaining -= m_tree.at(pos);
+        }
+    }
+    return qMin(pos, count - 1);
+}
+
+qint64 ChatListView::contentHeight() const
+{
+    if(m_heights.isEmpty()) {
+        return 0;
+    }
+    return 2 * MARGIN + rowTop(m_heights.size()) - SPACING;
+}
+
+/**
+ * @brief 在末尾追加一行的高度
+ *
+ * @details
+ * 树状数组第i项是(i - lowbit(i), i]这段行高之和，新项由已有前缀和相减得到，为O(log N)
+ */
+void ChatListView::appendHeight(int height)
+{
+    if(m_tree.isEmpty()) {
+        m_tree.append(0);
+    }
+    m_heights.append(height);
+    const int i = m_heights.size();
+    m_tree.append(height + rowTop(i - 1) - rowTop(i - (i & -i)));
+}
+
+void ChatListView::setHeight(int row, int height)
+{
+    const int delta = height - m_heights.at(row);
+    if(delta == 0) {
+        return;
+    }
+    m_heights[row] = height;
+    const int count = m_heights.size();
+    for(int i = row + 1; i <= count; i += i & -i) {
+        m_tree[i] += delta;
+    }
+}
+
+void ChatListView::rebuildTree()
+{
+    const int count = m_heights.size();
+    m_tree.fill(0, count + 1);
+    for(int i = 1; i <= count; ++i) {
+        m_tree[i] += m_heights.at(i - 1);
+        const int parent = i + (i & -i);
+        if(parent <= count) {
+            m_tree[parent] += m_tree.at(i);
+        }
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef CHATLISTVIEW_H
+#define CHATLISTVIEW_H
+
+#include <QAbstractItemView>
+#include <QVector>
+
+class QTimer;
+
+/**
+ * @brief 只绘制可见行的消息视图
+ *
+ * QListView每次插入行后都要重新布局全部行，消息越多追加越慢。这里每行只保存一个高度，
+ * 行的纵向位置由行高的树状数组（Fenwick树）求前缀和得到：
+ * - 在末尾追加一行只测量这一行，更新树状数组为O(log N)，与已有行数无关
+ * - 绘制和定位时由纵坐标在树状数组上二分找到行，只绘制可见的行，不为行创建控件
+ * - 宽度或字体变化后立即重新测量可见的行，其余行由定时器每次RELAYOUT_BATCH行分批重新测量，
+ *   期间视口顶部的行保持不动（停在底部时保持在底部）
+ * - 在中间插入或删除行时重建树状数组，为O(N)但不重新测量其他行
+ *
+ * 行高由委托的sizeHint()给出，传给委托的option.rect宽度即行的可用宽度。
+ */
+class ChatListView : public QAbstractItemView
+{
+    Q_OBJECT
+public:
+    explicit ChatListView(QWidget* parent = nullptr);
+
+    void setModel(QAbstractItemModel* model) override;
+    QRect visualRect(const QModelIndex& index) const override;
+    void scrollTo(const QModelIndex& index, ScrollHint hint = EnsureVisible) override;
+    QModelIndex indexAt(const QPoint& point) const override;
+    void reset() override;
+
+    /**
+     * @brief 是否已滚动到底部
+     */
+    bool isAtBottom() const;
+
+protected:
+    QModelIndex moveCursor(CursorAction cursorAction, Qt::KeyboardModifiers modifiers) override;
+    int horizontalOffset() const override;
+    int verticalOffset() const override;
+    bool isIndexHidden(const QModelIndex& index) const override;
+    void setSelection(const QRect& rect, QItemSelectionModel::SelectionFlags command) override;
+    QRegion visualRegionForSelection(const QItemSelection& selection) const override;
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void changeEvent(QEvent* event) override;
+    void updateGeometries() override;
+
+protected slots:
+    void rowsInserted(const QModelIndex& parent, int start, int end) override;
+    void rowsAboutToBeRemoved(const QModelIndex& parent, int start, int end) override;
+    void dataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                     const QVector<int>& roles = QVector<int>()) override;
+
+private slots:
+    /**
+     * @brief 按当前宽度重新测量下一批行
+     */
+    void relayoutBatch();
+
+private:
+    /**
+     * @brief 滚动位置，以视口顶部的行和行内偏移表示，行高变化后据此恢复
+     */
+    struct ScrollAnchor {
+        int row;            ///< 视口顶部的行，-1表示没有行
+        qint64 offset;      ///< 视口顶部相对该行顶部的偏移
+        bool atBottom;      ///< 是否停在底部
+    };
+
+    ScrollAnchor scrollAnchor() const;
+    void restoreScroll(const ScrollAnchor& anchor);
+
+    /**
+     * @brief 宽度或字体变化后重新测量，可见的行立即测量，其余分批测量
+     */
+    void relayout(const ScrollAnchor& anchor);
+
+    /**
+     * @brief 测量行高时传给委托的选项，rect宽度为行宽
+     */
+    QStyleOptionViewItem measureOption() const;
+
+    /**
+     * @brief 测量一行，结果含行间距
+     */
+    int measureRow(const QStyleOptionViewItem& option, int row) const;
+
+    /**
+     * @brief 按当前宽度重新测量全部行
+     */
+    void layoutAll();
+
+    int itemWidth() const;
+    qint64 rowTop(int row) const;       ///< 行顶部在内容中的位置，不含上边距
+    int rowAt(qint64 y) const;          ///< 内容中位置y（不含上边距）所在的行
+    qint64 contentHeight() const;       ///< 内容总高度，含上下边距
+
+    void appendHeight(int height);
+    void setHeight(int row, int height);
+    void rebuildTree();
+
+    QVector<int> m_heights;         ///< 每行高度，含行间距
+    QVector<qint64> m_tree;         ///< 行高的树状数组，下标从1开始
+    int m_layoutWidth;              ///< 行高按此宽度测量
+    int m_relayoutRow;              ///< 下一个需要按新宽度重新测量的行，-1表示没有
+    QTimer* m_relayoutTimer;        ///< 分批重新测量
+
+    static const int MARGIN = 10;           ///< 内容四周的边距
+    static const int SPACING = 10;          ///< 行间距
+    static const int SCROLL_STEP = 20;      ///< 滚动一步的像素数
+    static const int RELAYOUT_BATCH = 2000; ///< 每批重新测量的行数
+};
+
+#endif // CHATLISTVIEW_H
@@ -0,0 +1,308 @@
+#include "chatmessagemodel.h"
+#include "historylog.h"
+#include <QDebug>
+
+ChatMessageModel::ChatMessageModel(QObject* parent)
+    : QAbstractListModel(parent)
+    , m_nextId(0)
+    , m_logBase(0)
+    , m_historyStart(0)
+    , m_log(nullptr)
+    , m_maxMessages(0)
+    , m_maxBytes(0)
+    , m_bytes(0)
+{
+}
+
+ChatMessageModel::~ChatMessageModel()
+{
+    delete m_log;
+}
+
+int ChatMessageModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_messages.size();
+}
+
+QVariant ChatMessageModel::data(const QModelIndex& index, int role) const
+{
+    if(!index.isValid() || index.row() >= m_messages.size()) {
+        return QVariant();
+    }
+
+    const Message& message = m_messages.at(index.row());
+    switch(role) {
+        case Qt::DisplayRole:
+            return message.text;
+        case TimeRole:
+            return QDateTime::fromMSecsSinceEpoch(message.time);
+        case KindRole:
+            return message.kind;
+        case IdRole:
+            return message.id;
+        default:
+            return QVariant();
+    }
+}
+
+bool ChatMessageModel::canFetchOlder() const
+{
+    return m_log && m_log->isOpen() && firstId() > oldestId();
+}
+
+bool ChatMessageModel::fetchOlder()
+{
+    if(!canFetchOlder()) {
+        return false;
+    }
+
+    const quint64 first = firstId();
+    const int count = int(qMin<quint64>(PAGE_SIZE, first - oldestId()));
+    QVector<Message> page = readLog(first - count, count);
+    if(page.isEmpty()) {
+        // 日志读取失败，不再读回更早的消息
+        m_historyStart = first;
+        return false;
+    }
+
+    beginInsertRows(QModelIndex(), 0, page.size() - 1);
+    for(const Message& message : page) {
+        m_bytes += messageBytes(message);
+    }
+    page += m_messages;
+    m_messages.swap(page);
+    endInsertRows();
+    trim(false);
+    return true;
+}
+
+bool ChatMessageModel::canFetchNewer() const
+{
+    return !isAtLatest() && m_log && m_log->isOpen();
+}
+
+bool ChatMessageModel::fetchNewer()
+{
+    if(!canFetchNewer()) {
+        return false;
+    }
+
+    const quint64 first = m_messages.last().id + 1;
+    if(first < oldestId()) {
+        // 窗口之后的消息已随日志轮换删除，无法接在窗口后面
+        resetWindow(oldestId());
+        return !m_messages.isEmpty();
+    }
+    const int count = int(qMin<quint64>(PAGE_SIZE, m_nextId - first));
+    const QVector<Message> page = readLog(first, count);
+    if(page.isEmpty()) {
+        return false;
+    }
+
+    const int row = m_messages.size();
+    beginInsertRows(QModelIndex(), row, row + page.size() - 1);
+    for(const Message& message : page) {
+        m_bytes += messageBytes(message);
+        m_messages.append(message);
+    }
+    endInsertRows();
+    trim(true);
+    return true;
+}
+
+bool ChatMessageModel::isAtLatest() const
+{
+    return m_messages.isEmpty() || m_messages.last().id + 1 == m_nextId;
+}
+
+void ChatMessageModel::showLatest()
+{
+    if(isAtLatest()) {
+        return;
+    }
+
+    const int count = int(qMin<quint64>(PAGE_SIZE, m_nextId - oldestId()));
+    resetWindow(m_nextId - count);
+}
+
+void ChatMessageModel::resetWindow(quint64 first)
+{
+    const int count = int(qMin<quint64>(PAGE_SIZE, m_nextId - first));
+    beginResetModel();
+    m_messages = readLog(first, count);
+    m_bytes = 0;
+    for(const Message& message : m_messages) {
+        m_bytes += messageBytes(message);
+    }
+    endResetModel();
+}
+
+void ChatMessageModel::append(const QString& text, Kind kind)
+{
+    append(QVector<Message>{Message{0, text, QDateTime::currentMSecsSinceEpoch(), kind}});
+}
+
+/**
+ * @brief 追加消息
+ *
+ * @details
+ * 1. 分配编号并写入日志
+ * 2. 窗口不含最新消息时只写入日志，由showLatest()或fetchNewer()显示；
+ *    日志已不可用时先清空窗口，保证窗口中的编号连续
+ * 3. 追加到窗口末尾后按上限从前面移除
+ */
+void ChatMessageModel::append(const QVector<Message>& messages)
+{
+    if(messages.isEmpty()) {
+        return;
+    }
+
+    bool atLatest = isAtLatest();
+    if(!atLatest && !(m_log && m_log->isOpen())) {
+        beginResetModel();
+        m_messages.clear();
+        m_bytes = 0;
+        endResetModel();
+        atLatest = true;
+    }
+
+    const int row = m_messages.size();
+    if(atLatest) {
+        beginInsertRows(QModelIndex(), row, row + messages.size() - 1);
+        m_messages.reserve(row + messages.size());
+    }
+    for(const Message& message : messages) {
+        Message added = message;
+        added.id = m_nextId++;
+        if(m_log) {
+            m_log->append(added);
+        }
+        if(atLatest) {
+            m_bytes += messageBytes(added);
+            m_messages.append(added);
+        }
+    }
+    if(atLatest) {
+        endInsertRows();
+        trim(true);
+    }
+}
+
+void ChatMessageModel::clear()
+{
+    beginResetModel();
+    m_messages.clear();
+    m_bytes = 0;
+    m_historyStart = m_nextId;
+    endResetModel();
+}
+
+void ChatMessageModel::setHistoryLimit(int maxMessages, qint64 maxBytes)
+{
+    m_maxMessages = qMax(0, maxMessages);
+    m_maxBytes = qMax<qint64>(0, maxBytes);
+    trim(isAtLatest());
+}
+
+bool ChatMessageModel::setHistoryFile(const QString& path, qint64 maxBytes)
+{
+    // 新日志不含之前的消息，窗口先回到最新
+    showLatest();
+    delete m_log;
+    m_log = nullptr;
+    m_historyError.clear();
+    m_logBase = m_nextId;
+    m_historyStart = qMax(m_historyStart, m_nextId);
+
+    if(path.isEmpty()) {
+        return true;
+    }
+
+    m_log = new HistoryLog;
+    if(!m_log->open(path, maxBytes)) {
+        m_historyError = m_log->errorString();
+        qWarning() << "History log disabled:" << path << m_historyError;
+        delete m_log;
+        m_log = nullptr;
+        return false;
+    }
+    return true;
+}
+
+QString ChatMessageModel::historyError() const
+{
+    return m_log ? m_log->errorString() : m_historyError;
+}
+
+quint64 ChatMessageModel::firstId() const
+{
+    return m_messages.isEmpty() ? m_nextId : m_messages.first().id;
+}
+
+quint64 ChatMessageModel::oldestId() const
+{
+    if(!m_log) {
+        return m_historyStart;
+    }
+    return qMax(m_historyStart, m_logBase + quint64(m_log->first()));
+}
+
+QVector<ChatMessageModel::Message> ChatMessageModel::readLog(quint64 first, int count) const
+{
+    if(!m_log || count <= 0 || first < m_logBase) {
+        return QVector<Message>();
+    }
+
+    // 只接受完整的一页，窗口中的编号必须连续
+    QVector<Message> page = m_log->read(qint64(first - m_logBase), count);
+    if(page.size() != count) {
+        return QVector<Message>();
+    }
+    for(Message& message : page) {
+        message.id += m_logBase;
+    }
+    return page;
+}
+
+/**
+ * @brief 按上限移除消息
+ *
+ * @details
+ * 1. 条数超出的部分，与字节数超出时需要从该端移除的条数，取较大者
+ * 2. 多移除当前条数的八分之一，移动数组的开销分摊到之后的多次追加或翻页
+ * 3. 至少保留一条消息
+ */
+void ChatMessageModel::trim(bool fromFront)
+{
+    const int size = m_messages.size();
+    int excess = m_maxMessages > 0 ? size - m_maxMessages : 0;
+    if(m_maxBytes > 0 && m_bytes > m_maxBytes) {
+        qint64 bytes = m_bytes;
+        int count = 0;
+        while(count < size && bytes > m_maxBytes) {
+            bytes -= messageBytes(m_messages.at(fromFront ? count : size - 1 - count));
+            count++;
+        }
+        excess = qMax(excess, count);
+    }
+    if(excess <= 0) {
+        return;
+    }
+
+    const int count = qMin(size - 1, excess + size / 8);
+    if(count <= 0) {
+        return;
+    }
+    const int first = fromFront ? 0 : size - count;
+    beginRemoveRows(QModelIndex(), first, first + count - 1);
+    for(int row = first; row < first + count; ++row) {
+        m_bytes -= messageBytes(m_messages.at(row));
+    }
+    m_messages.remove(first, count);
+    endRemoveRows();
+}
+
+qint64 ChatMessageModel::messageBytes(const Message& message)
+{
+    return qint64(sizeof(Message)) + qint64(message.text.size()) * qint64(sizeof(QChar));
+}
@@ -0,0 +1,184 @@
+#ifndef CHATMESSAGEMODEL_H
+#define CHATMESSAGEMODEL_H
+
+#include <QAbstractListModel>
+#include <QDateTime>
+#include <QVector>
+
+class HistoryLog;
+
+/**
+ * @brief 聊天记录模型
+ *
+ * 每条消息只保存文本、时间和类型，不创建任何控件；显示由ChatListView和
+ * ChatBubbleDelegate按可见行完成。消息追加在末尾，单条追加的开销与已有消息数无关。
+ *
+ * 内存中只保留一段连续的消息（窗口），上限由setHistoryLimit()按条数和字节数设置，
+ * 超出时从窗口的另一端移除。设置了日志文件时每条消息都写入HistoryLog，
+ * 移出窗口的消息可以按页重新读回：
+ * - 窗口前面还有消息时canFetchOlder()为true，fetchOlder()在前面插入一页较早的消息
+ * - 窗口不含最新消息时canFetchNewer()为true，fetchNewer()在后面追加一页较新的消息
+ * - 窗口不含最新消息时到达的消息只写入日志，showLatest()把窗口换成最新的一页
+ * 没有日志文件时移出窗口的消息被丢弃；日志设置了上限时最早的消息随轮换删除，不再能读回。
+ * 读回只由ChatBubbleWidget按滚动位置触发；不重载canFetchMore()/fetchMore()，
+ * 视图在最后一行可见时自动调用它们，会在停在底部时不断插入较早的消息。
+ */
+class ChatMessageModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 消息类型
+     */
+    enum Kind {
+        Received,       ///< 收到的消息
+        Sent,           ///< 本端发出的消息
+        System          ///< 系统提示
+    };
+
+    /**
+     * @brief 数据角色，文本使用Qt::DisplayRole
+     */
+    enum Roles {
+        TimeRole = Qt::UserRole + 1,    ///< 消息时间(QDateTime)
+        KindRole,                       ///< 消息类型(Kind)
+        IdRole                          ///< 消息编号(quint64)
+    };
+
+    /**
+     * @brief 一条消息
+     */
+    struct Message {
+        quint64 id;         ///< 编号，追加时按顺序分配，行号变化后不变，供委托缓存布局
+        QString text;       ///< 文本
+        qint64 time;        ///< 时间(Unix毫秒)
+        Kind kind;          ///< 类型
+    };
+
+    explicit ChatMessageModel(QObject* parent = nullptr);
+    ~ChatMessageModel();
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    /**
+     * @brief 窗口前面是否还有可以从日志读回的消息
+     */
+    bool canFetchOlder() const;
+
+    /**
+     * @brief 在窗口前面插入一页较早的消息，超出上限时从窗口末尾移除
+     * @return 是否读回了消息
+     */
+    bool fetchOlder();
+
+    /**
+     * @brief 窗口后面是否还有较新的消息
+     */
+    bool canFetchNewer() const;
+
+    /**
+     * @brief 在窗口末尾追加一页较新的消息，超出上限时从窗口前面移除
+     * 紧接窗口的消息已随日志轮换删除时，窗口换成仍可读取的最早一页
+     * @return 是否读回了消息
+     */
+    bool fetchNewer();
+
+    /**
+     * @brief 窗口是否包含最新的消息
+     */
+    bool isAtLatest() const;
+
+    /**
+     * @brief 把窗口换成最新的一页消息
+     */
+    void showLatest();
+
+    /**
+     * @brief 直接访问一条消息，供委托绘制时使用，避免经QVariant转换
+     */
+    const Message& message(int row) const { return m_messages.at(row); }
+
+    /**
+     * @brief 在末尾追加一条消息，时间取当前时刻
+     */
+    void append(const QString& text, Kind kind);
+
+    /**
+     * @brief 在末尾追加一批消息，只发出一次rowsInserted，编号由模型重新分配
+     */
+    void append(const QVector<Message>& messages);
+
+    /**
+     * @brief 清空窗口，之前的消息也不再能从日志读回
+     */
+    void clear();
+
+    /**
+     * @brief 设置内存中保留的消息上限
+     * @param maxMessages 最多保留的条数，0表示不限
+     * @param maxBytes 最多占用的字节数（按文本长度估算），0表示不限
+     */
+    void setHistoryLimit(int maxMessages, qint64 maxBytes);
+
+    /**
+     * @brief 设置日志文件，之后的消息都写入日志，为空时不写日志
+     * @param maxBytes 日志文件合计的字节数上限，超出时最早的消息不再能读回，0表示不限
+     * @return 是否成功（文件已被其他进程使用时也失败），失败时不写日志
+     */
+    bool setHistoryFile(const QString& path, qint64 maxBytes = 0);
+
+    /**
+     * @brief 日志文件打开或写入失败的原因
+     */
+    QString historyError() const;
+
+    /**
+     * @brief 窗口中消息占用的字节数（估算）
+     */
+    qint64 memoryBytes() const { return m_bytes; }
+
+    static const int PAGE_SIZE = 200;   ///< 从日志读回的每页消息数
+
+private:
+    /**
+     * @brief 窗口第一条消息的编号，窗口为空时为下一条消息的编号
+     */
+    quint64 firstId() const;
+
+    /**
+     * @brief 最早可以读回的消息编号，日志轮换删除的消息不再能读回
+     */
+    quint64 oldestId() const;
+
+    /**
+     * @brief 从日志读取编号从first开始的最多count条消息
+     */
+    QVector<Message> readLog(quint64 first, int count) const;
+
+    /**
+     * @brief 把窗口换成编号从first开始的一页消息
+     */
+    void resetWindow(quint64 first);
+
+    /**
+     * @brief 窗口超出上限时从前面或末尾移除消息
+     */
+    void trim(bool fromFront);
+
+    static qint64 messageBytes(const Message& message);
+
+    QVector<Message> m_messages;    ///< 窗口中的消息，编号连续
+    quint64 m_nextId;               ///< 下一条消息的编号
+    quint64 m_logBase;              ///< 日志中第一条消息的编号
+    quint64 m_historyStart;         ///< 早于它的消息不再读回，clear()或读回失败时前移
+    HistoryLog* m_log;              ///< 日志，没有日志文件时为nullptr
+    QString m_historyError;         ///< 日志文件打开失败的原因
+    int m_maxMessages;              ///< 窗口最多保留的条数，0表示不限
+    qint64 m_maxBytes;              ///< 窗口最多占用的字节数，0表示不限
+    qint64 m_bytes;                 ///< 窗口中消息占用的字节数
+};
+
+Q_DECLARE_TYPEINFO(ChatMessageModel::Message, Q_MOVABLE_TYPE);
+
+#endif // CHATMESSAGEMODEL_H
@@ -0,0 +1,68 @@
+#include "conversationmodel.h"
+
+ConversationModel::ConversationModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int ConversationModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_conversations.size();
+}
+
+QVariant ConversationModel::data(const QModelIndex& index, int role) const
+{
+    if(!index.isValid() || index.row() >= m_conversations.size()) {
+        return QVariant();
+    }
+
+    const Conversation& conversation = m_conversations.at(index.row());
+    switch(role) {
+        case Qt::DisplayRole:
+            return conversation.peer;
+        case LastMessageRole:
+            return conversation.lastMessage;
+        case TimeRole:
+            return QDateTime::fromMSecsSinceEpoch(conversation.time);
+        case FromMeRole:
+            return conversation.fromMe;
+        case UnreadRole:
+            return conversation.unread;
+        default:
+            return QVariant();
+    }
+}
+
+void ConversationModel::update(const QString& peer, const QString& message, bool isFromMe,
+                               qint64 time, int unread)
+{
+    const int row = m_rows.value(peer, -1);
+    if(row < 0) {
+        const int newRow = m_conversations.size();
+        beginInsertRows(QModelIndex(), newRow, newRow);
+        m_conversations.append(Conversation{peer, message, time, isFromMe, isFromMe ? 0 : unread});
+        m_rows.insert(peer, newRow);
+        endInsertRows();
+        return;
+    }
+
+    Conversation& conversation = m_conversations[row];
+    conversation.lastMessage = message;
+    conversation.time = time;
+    conversation.fromMe = isFromMe;
+    conversation.unread = isFromMe ? 0 : conversation.unread + unread;
+    const QModelIndex changed = index(row);
+    emit dataChanged(changed, changed);
+}
+
+void ConversationModel::markRead(const QString& peer)
+{
+    const int row = m_rows.value(peer, -1);
+    if(row < 0 || m_conversations.at(row).unread == 0) {
+        return;
+    }
+
+    m_conversations[row].unread = 0;
+    const QModelIndex changed = index(row);
+    emit dataChanged(changed, changed, {UnreadRole});
+}
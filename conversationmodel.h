@@ -0,0 +1,73 @@
+#ifndef CONVERSATIONMODEL_H
+#define CONVERSATIONMODEL_H
+
+#include <QAbstractListModel>
+#include <QDateTime>
+#include <QHash>
+#include <QVector>
+
+/**
+ * @brief 会话列表模型
+ *
+ * 每个端口（对端）一行，只保存最后一条消息、时间和未读数，不保存聊天记录。
+ * 行按首次出现的顺序排列且不移动，对端到行号的映射保存在QHash中，
+ * 新消息按哈希查找后原地更新一行并发出一次dataChanged，
+ * 开销只与对端数量有关，与会话持续多久、收到多少消息无关。
+ */
+class ConversationModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 数据角色，对端名称使用Qt::DisplayRole
+     */
+    enum Roles {
+        LastMessageRole = Qt::UserRole + 1,     ///< 最后一条消息(QString)
+        TimeRole,                               ///< 最后一条消息的时间(QDateTime)
+        FromMeRole,                             ///< 最后一条消息是否由本端发出(bool)
+        UnreadRole                              ///< 未读数(int)
+    };
+
+    explicit ConversationModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    /**
+     * @brief 更新对端的最后一条消息，对端不存在时在末尾添加一行
+     * @param peer 对端名称
+     * @param message 最后一条消息
+     * @param isFromMe 最后一条消息是否由本端发出
+     * @param time 最后一条消息的时间(Unix毫秒)
+     * @param unread 新增的未读数，本端发出消息时未读数清零
+     */
+    void update(const QString& peer, const QString& message, bool isFromMe,
+                qint64 time, int unread);
+
+    /**
+     * @brief 清除对端的未读数
+     */
+    void markRead(const QString& peer);
+
+    /**
+     * @brief 对端所在的行，不存在时返回-1
+     */
+    int rowOf(const QString& peer) const { return m_rows.value(peer, -1); }
+
+private:
+    /**
+     * @brief 一个会话
+     */
+    struct Conversation {
+        QString peer;           ///< 对端名称
+        QString lastMessage;    ///< 最后一条消息
+        qint64 time;            ///< 最后一条消息的时间(Unix毫秒)
+        bool fromMe;            ///< 最后一条消息是否由本端发出
+        int unread;             ///< 未读数
+    };
+
+    QVector<Conversation> m_conversations;  ///< 全部会话，按首次出现的顺序
+    QHash<QString, int> m_rows;             ///< 对端到行号
+};
+
+#endif // CONVERSATIONMODEL_H
@@ -0,0 +1,171 @@
+#include "crc.h"
+#include <QtEndian>
+#include <cstring>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#  include <immintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#    define CRC_HAVE_SSE42
+#    define CRC_TARGET_SSE42
+#  elif defined(__GNUC__) || defined(__clang__)
+#    define CRC_HAVE_SSE42
+#    define CRC_TARGET_SSE42 __attribute__((target("sse4.2")))
+#  endif
+#endif
+
+namespace {
+
+/**
+ * @brief 查找表，首次使用时生成
+ */
+struct Tables {
+    quint8 crc8[256];
+    quint16 crc16[256];
+    quint32 crc32c[8][256];     ///< slicing-by-8
+
+    Tables()
+    {
+        for(int i = 0; i < 256; ++i) {
+            quint8 c8 = static_cast<quint8>(i);
+            for(int bit = 0; bit < 8; ++bit) {
+                c8 = static_cast<quint8>((c8 & 0x80) ? (c8 << 1) ^ 0x07 : (c8 << 1));
+            }
+            crc8[i] = c8;
+
+            quint16 c16 = static_cast<quint16>(i << 8);
+            for(int bit = 0; bit < 8; ++bit) {
+                c16 = static_cast<quint16>((c16 & 0x8000) ? (c16 << 1) ^ 0x1021 : (c16 << 1));
+            }
+            crc16[i] = c16;
+
+            quint32 c32 = static_cast<quint32>(i);
+            for(int bit = 0; bit < 8; ++bit) {
+                c32 = (c32 & 1) ? (c32 >> 1) ^ 0x82F63B78u : (c32 >> 1);
+            }
+            crc32c[0][i] = c32;
+        }
+        for(int i = 0; i < 256; ++i) {
+            for(int k = 1; k < 8; ++k) {
+                const quint32 prev = crc32c[k - 1][i];
+                crc32c[k][i] = (prev >> 8) ^ crc32c[0][prev & 0xFF];
+            }
+        }
+    }
+};
+
+const Tables& tables()
+{
+    static const Tables t;
+    return t;
+}
+
+quint32 crc32cUpdateTable(quint32 crc, const unsigned char* p, int size)
+{
+    const Tables& t = tables();
+    while(size >= 8) {
+        quint32 low;
+        quint32 high;
+        std::memcpy(&low, p, 4);
+        std::memcpy(&high, p + 4, 4);
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+        low = qFromLittleEndian(low);
+        high = qFromLittleEndian(high);
+#endif
+        low ^= crc;
+        crc = t.crc32c[7][low & 0xFF] ^ t.crc32c[6][(low >> 8) & 0xFF] ^
+              t.crc32c[5][(low >> 16) & 0xFF] ^ t.crc32c[4][low >> 24] ^
+              t.crc32c[3][high & 0xFF] ^ t.crc32c[2][(high >> 8) & 0xFF] ^
+              t.crc32c[1][(high >> 16) & 0xFF] ^ t.crc32c[0][high >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while(size-- > 0) {
+        crc = (crc >> 8) ^ t.crc32c[0][(crc ^ *p++) & 0xFF];
+    }
+    return crc;
+}
+
+#ifdef CRC_HAVE_SSE42
+CRC_TARGET_SSE42
+quint32 crc32cUpdateSse42(quint32 crc, const unsigned char* p, int size)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    std::uint64_t crc64 = crc;
+    while(size >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        size -= 8;
+    }
+    crc = static_cast<quint32>(crc64);
+#endif
+    while(size >= 4) {
+        quint32 word;
+        std::memcpy(&word, p, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+        p += 4;
+        size -= 4;
+    }
+    while(size-- > 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    return crc;
+}
+
+bool cpuHasSse42()
+{
+#if defined(__SSE4_2__)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+#endif // CRC_HAVE_SSE42
+
+} // namespace
+
+quint8 Crc::crc8(const char* data, int size)
+{
+    const Tables& t = tables();
+    quint8 crc = 0;
+    for(int i = 0; i < size; ++i) {
+        crc = t.crc8[crc ^ static_cast<quint8>(data[i])];
+    }
+    return crc;
+}
+
+quint16 Crc::crc16(const char* data, int size)
+{
+    const Tables& t = tables();
+    quint16 crc = 0xFFFF;
+    for(int i = 0; i < size; ++i) {
+        crc = static_cast<quint16>((crc << 8) ^ t.crc16[((crc >> 8) ^ static_cast<quint8>(data[i])) & 0xFF]);
+    }
+    return crc;
+}
+
+quint32 Crc::crc32c(const char* data, int size)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+#ifdef CRC_HAVE_SSE42
+    static const bool useSse42 = cpuHasSse42();
+    if(useSse42) {
+        return ~crc32cUpdateSse42(0xFFFFFFFFu, p, size);
+    }
+#endif
+    return ~crc32cUpdateTable(0xFFFFFFFFu, p, size);
+}
+
+quint32 Crc::crc32cTable(const char* data, int size)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    return ~crc32cUpdateTable(0xFFFFFFFFu, p, size);
+}
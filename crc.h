@@ -0,0 +1,27 @@
+#ifndef CRC_H
+#define CRC_H
+
+#include <QtGlobal>
+
+/**
+ * @brief 二进制帧使用的校验算法
+ *
+ * - CRC-8（多项式0x07）：保护帧头，用于快速排除误判的帧起始位置
+ * - CRC-16/CCITT-FALSE：短帧负载校验
+ * - CRC-32C（Castagnoli）：长帧负载校验，CPU支持SSE4.2时使用crc32指令，
+ *   否则使用slicing-by-8查表
+ */
+class Crc
+{
+public:
+    static quint8 crc8(const char* data, int size);
+    static quint16 crc16(const char* data, int size);
+    static quint32 crc32c(const char* data, int size);
+
+    /**
+     * @brief 强制使用查表实现的CRC-32C（基准测试对比用）
+     */
+    static quint32 crc32cTable(const char* data, int size);
+};
+
+#endif // CRC_H
@@ -0,0 +1,350 @@
+#include "fdtransport.h"
+
+#ifdef Q_OS_UNIX
+
+#include <QSocketNotifier>
+#include <QFile>
+#include <QDebug>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#if defined(Q_OS_MACOS)
+#  include <util.h>
+#else
+#  include <pty.h>
+#endif
+
+namespace {
+
+bool setNonBlocking(int fd)
+{
+    const int flags = ::fcntl(fd, F_GETFL);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------- FdTransport
+
+FdTransport::FdTransport(QObject *parent)
+    : SerialTransport(parent)
+    , m_readFd(-1)
+    , m_writeFd(-1)
+    , m_readNotifier(nullptr)
+    , m_writeNotifier(nullptr)
+    , m_readBufferSize(0)
+{
+}
+
+FdTransport::~FdTransport()
+{
+}
+
+bool FdTransport::isOpen() const
+{
+    return m_readFd >= 0;
+}
+
+void FdTransport::attach(int readFd, int writeFd)
+{
+    m_readFd = readFd;
+    m_writeFd = writeFd;
+    setNonBlocking(readFd);
+    setNonBlocking(writeFd);
+
+    m_readNotifier = new QSocketNotifier(readFd, QSocketNotifier::Read, this);
+    connect(m_readNotifier, &QSocketNotifier::activated,
+            this, &FdTransport::handleReadable);
+    m_writeNotifier = new QSocketNotifier(writeFd, QSocketNotifier::Write, this);
+    m_writeNotifier->setEnabled(false);
+    connect(m_writeNotifier, &QSocketNotifier::activated,
+            this, &FdTransport::handleWritable);
+}
+
+void FdTransport::detach()
+{
+    // 可能在通知器自身的信号中被调用，只能延迟释放
+    if(m_readNotifier) {
+        m_readNotifier->setEnabled(false);
+        m_readNotifier->deleteLater();
+        m_readNotifier = nullptr;
+    }
+    if(m_writeNotifier) {
+        m_writeNotifier->setEnabled(false);
+        m_writeNotifier->deleteLater();
+        m_writeNotifier = nullptr;
+    }
+    m_readBuffer.clear();
+    m_writeBuffer.clear();
+    m_readFd = -1;
+    m_writeFd = -1;
+}
+
+QByteArray FdTransport::readAll()
+{
+    QByteArray data;
+    data.swap(m_readBuffer);
+    if(m_readNotifier) {
+        m_readNotifier->setEnabled(true);
+    }
+    return data;
+}
+
+qint64 FdTransport::bytesAvailable() const
+{
+    return m_readBuffer.size();
+}
+
+qint64 FdTransport::write(const char* data, qint64 size)
+{
+    if(!isOpen()) {
+        return -1;
+    }
+    m_writeBuffer.append(data, static_cast<int>(size));
+    m_writeNotifier->setEnabled(true);
+    return size;
+}
+
+qint64 FdTransport::bytesToWrite() const
+{
+    return m_writeBuffer.size();
+}
+
+void FdTransport::setReadBufferSize(qint64 size)
+{
+    m_readBufferSize = size;
+    if(m_readNotifier && (size <= 0 || m_readBuffer.size() < size)) {
+        m_readNotifier->setEnabled(true);
+    }
+}
+
+bool FdTransport::clear(QSerialPort::Directions directions)
+{
+    if(directions & QSerialPort::Input) {
+        m_readBuffer.clear();
+        if(m_readFd >= 0 && ::isatty(m_readFd)) {
+            ::tcflush(m_readFd, TCIFLUSH);
+        }
+        if(m_readNotifier) {
+            m_readNotifier->setEnabled(true);
+        }
+    }
+    if(directions & QSerialPort::Output) {
+        m_writeBuffer.clear();
+        if(m_writeNotifier) {
+            m_writeNotifier->setEnabled(false);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 读取描述符上的数据
+ *
+ * @details
+ * 1. 循环读取直到EAGAIN或达到读缓冲上限，达到上限时停止监听
+ * 2. 读到EOF或出错时报告ResourceError
+ * 3. 有新数据时发出一次readyRead
+ */
+void FdTransport::handleReadable()
+{
+    bool received = false;
+    QSerialPort::SerialPortError error = QSerialPort::NoError;
+    QString message;
+
+    for(;;) {
+        int chunk = READ_CHUNK_SIZE;
+        if(m_readBufferSize > 0) {
+            const qint64 room = m_readBufferSize - m_readBuffer.size();
+            if(room <= 0) {
+                m_readNotifier->setEnabled(false);
+                break;
+            }
+            chunk = static_cast<int>(qMin<qint64>(chunk, room));
+        }
+
+        const int oldSize = m_readBuffer.size();
+        m_readBuffer.resize(oldSize + chunk);
+        const ssize_t n = ::read(m_readFd, m_readBuffer.data() + oldSize, static_cast<size_t>(chunk));
+        if(n > 0) {
+            m_readBuffer.resize(oldSize + static_cast<int>(n));
+            received = true;
+            if(n < chunk) {
+                break;
+            }
+            continue;
+        }
+        m_readBuffer.resize(oldSize);
+
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        error = QSerialPort::ResourceError;
+        message = n == 0 ? tr("对端已关闭") : qt_error_string(errno);
+        m_readNotifier->setEnabled(false);
+        break;
+    }
+
+    if(received) {
+        emit readyRead();
+    }
+    if(error != QSerialPort::NoError) {
+        setError(error, message);
+    }
+}
+
+void FdTransport::handleWritable()
+{
+    qint64 total = 0;
+    while(!m_writeBuffer.isEmpty()) {
+        const ssize_t n = ::write(m_writeFd, m_writeBuffer.data(),
+                                  static_cast<size_t>(m_writeBuffer.size()));
+        if(n > 0) {
+            m_writeBuffer.consume(static_cast<int>(n));
+            total += n;
+            continue;
+        }
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        m_writeNotifier->setEnabled(false);
+        setError(errno == EPIPE || errno == EIO ? QSerialPort::ResourceError : QSerialPort::WriteError,
+                 qt_error_string(errno));
+        return;
+    }
+
+    if(m_writeBuffer.isEmpty()) {
+        m_writeNotifier->setEnabled(false);
+    }
+    if(total > 0) {
+        emit bytesWritten(total);
+    }
+}
+
+// ---------------------------------------------------------------- PtyTransport
+
+PtyTransport::PtyTransport(QObject *parent)
+    : FdTransport(parent)
+    , m_slaveFd(-1)
+{
+}
+
+PtyTransport::~PtyTransport()
+{
+    close();
+}
+
+/**
+ * @brief 创建伪终端
+ *
+ * @details
+ * 1. openpty()创建主从设备，从设备设为raw模式，不回显、不转换换行
+ * 2. 按需创建指向从设备的符号链接
+ * 3. 主设备交给FdTransport读写
+ */
+bool PtyTransport::open()
+{
+    int master = -1;
+    int slave = -1;
+    if(::openpty(&master, &slave, nullptr, nullptr, nullptr) < 0) {
+        setError(QSerialPort::OpenError, qt_error_string(errno));
+        return false;
+    }
+
+    termios tio;
+    if(::tcgetattr(slave, &tio) == 0) {
+        ::cfmakeraw(&tio);
+        ::tcsetattr(slave, TCSANOW, &tio);
+    }
+    ::fcntl(master, F_SETFD, FD_CLOEXEC);
+    ::fcntl(slave, F_SETFD, FD_CLOEXEC);
+
+    const char* name = ::ttyname(slave);
+    m_slavePath = name ? QString::fromLocal8Bit(name) : QString();
+
+    const QString link = address();
+    if(!link.isEmpty()) {
+        QFile::remove(link);
+        if(!QFile::link(m_slavePath, link)) {
+            ::close(master);
+            ::close(slave);
+            setError(QSerialPort::PermissionError, tr("无法创建链接 %1").arg(link));
+            return false;
+        }
+        m_linkPath = link;
+    }
+
+    m_slaveFd = slave;
+    attach(master, master);
+    qInfo() << "pty transport:" << m_slavePath
+            << (m_linkPath.isEmpty() ? QString() : QStringLiteral("<- ") + m_linkPath);
+    return true;
+}
+
+void PtyTransport::close()
+{
+    if(!isOpen()) {
+        return;
+    }
+
+    const int master = m_readFd;
+    detach();
+    ::close(master);
+    ::close(m_slaveFd);
+    m_slaveFd = -1;
+
+    if(!m_linkPath.isEmpty()) {
+        QFile::remove(m_linkPath);
+        m_linkPath.clear();
+    }
+}
+
+// ---------------------------------------------------------------- StdioTransport
+
+StdioTransport::StdioTransport(QObject *parent)
+    : FdTransport(parent)
+    , m_stdinFlags(-1)
+    , m_stdoutFlags(-1)
+{
+}
+
+StdioTransport::~StdioTransport()
+{
+    close();
+}
+
+bool StdioTransport::open()
+{
+    m_stdinFlags = ::fcntl(STDIN_FILENO, F_GETFL);
+    m_stdoutFlags = ::fcntl(STDOUT_FILENO, F_GETFL);
+    if(m_stdinFlags < 0 || m_stdoutFlags < 0) {
+        setError(QSerialPort::DeviceNotFoundError, qt_error_string(errno));
+        return false;
+    }
+
+    // 标准输出被对端关闭时以EPIPE报告，而不是终止进程
+    ::signal(SIGPIPE, SIG_IGN);
+    attach(STDIN_FILENO, STDOUT_FILENO);
+    return true;
+}
+
+void StdioTransport::close()
+{
+    if(!isOpen()) {
+        return;
+    }
+
+    detach();
+    ::fcntl(STDIN_FILENO, F_SETFL, m_stdinFlags);
+    ::fcntl(STDOUT_FILENO, F_SETFL, m_stdoutFlags);
+}
+
+#endif // Q_OS_UNIX
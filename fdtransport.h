@@ -0,0 +1,115 @@
+#ifndef FDTRANSPORT_H
+#define FDTRANSPORT_H
+
+#include "serialtransport.h"
+#include "receivebuffer.h"
+
+#ifdef Q_OS_UNIX
+
+class QSocketNotifier;
+
+/**
+ * @brief 基于文件描述符的传输层
+ *
+ * 描述符设为非阻塞，由QSocketNotifier驱动读写：
+ * - 读缓冲达到上限时停止监听可读事件，数据留在内核中形成背压
+ * - write()只追加到发送缓冲区，可写时再写出并发出bytesWritten
+ * - 读到EOF或EIO视为连接断开，报告ResourceError
+ */
+class FdTransport : public SerialTransport
+{
+    Q_OBJECT
+public:
+    explicit FdTransport(QObject *parent = nullptr);
+    ~FdTransport();
+
+    bool isOpen() const override;
+
+    QByteArray readAll() override;
+    qint64 bytesAvailable() const override;
+    qint64 write(const char* data, qint64 size) override;
+    qint64 bytesToWrite() const override;
+    void setReadBufferSize(qint64 size) override;
+    bool clear(QSerialPort::Directions directions = QSerialPort::AllDirections) override;
+
+protected:
+    /**
+     * @brief 开始使用一对描述符（可以相同）
+     */
+    void attach(int readFd, int writeFd);
+
+    /**
+     * @brief 停止监听并丢弃缓冲数据，不关闭描述符
+     */
+    void detach();
+
+    int m_readFd;       ///< 读描述符，-1表示未打开
+    int m_writeFd;      ///< 写描述符
+
+private slots:
+    void handleReadable();
+    void handleWritable();
+
+private:
+    QSocketNotifier* m_readNotifier;    ///< 可读通知
+    QSocketNotifier* m_writeNotifier;   ///< 可写通知，发送缓冲区非空时启用
+    QByteArray m_readBuffer;            ///< 已读取未取走的数据
+    ReceiveBuffer m_writeBuffer;        ///< 尚未写出的数据
+    qint64 m_readBufferSize;            ///< 读缓冲上限，0表示不限
+
+    static const int READ_CHUNK_SIZE = 64 * 1024;   ///< 每次read()的最大长度
+};
+
+/**
+ * @brief 伪终端传输层
+ *
+ * 本端持有主设备，从设备设为raw模式并保持打开，保证没有其他程序打开
+ * 从设备时主设备也不会读到EIO。端口名为"pty:路径"时创建指向从设备的符号链接。
+ */
+class PtyTransport : public FdTransport
+{
+    Q_OBJECT
+public:
+    explicit PtyTransport(QObject *parent = nullptr);
+    ~PtyTransport();
+
+    Kind kind() const override { return PtyKind; }
+
+    bool open() override;
+    void close() override;
+
+    /**
+     * @brief 从设备路径，供对端程序打开
+     */
+    QString slavePath() const { return m_slavePath; }
+
+private:
+    int m_slaveFd;          ///< 从设备描述符
+    QString m_slavePath;    ///< 从设备路径
+    QString m_linkPath;     ///< 已创建的符号链接
+};
+
+/**
+ * @brief 标准输入/输出传输层
+ * 关闭时恢复描述符原来的阻塞属性，不关闭描述符
+ */
+class StdioTransport : public FdTransport
+{
+    Q_OBJECT
+public:
+    explicit StdioTransport(QObject *parent = nullptr);
+    ~StdioTransport();
+
+    Kind kind() const override { return StdioKind; }
+
+    bool open() override;
+    void close() override;
+
+private:
+    int m_stdinFlags;       ///< 打开前标准输入的文件状态标志
+    int m_stdoutFlags;      ///< 打开前标准输出的文件状态标志
+};
+
+#endif // Q_OS_UNIX
+
+#endif // FDTRANSPORT_H
@@ -0,0 +1,605 @@
+#include "filetransfer.h"
+#include "crc.h"
+#include <QtEndian>
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QRandomGenerator>
+#include <cstring>
+#ifdef Q_OS_LINUX
+#  include <fcntl.h>
+#  include <cerrno>
+#endif
+
+namespace {
+
+const char PART_SUFFIX[] = ".part";
+const char RESUME_SUFFIX[] = ".part.resume";
+
+quint32 newTransferId()
+{
+    quint32 id = 0;
+    while(id == 0) {
+        id = QRandomGenerator::global()->generate();
+    }
+    return id;
+}
+
+/**
+ * @brief 第n个候选保存路径，n为0时即path，否则为"名称 (n).扩展名"
+ */
+QString numberedPath(const QString& path, int n)
+{
+    if(n == 0) {
+        return path;
+    }
+    const QFileInfo info(path);
+    const QString base = info.baseName();
+    const QString name = base.isEmpty() ? QString("%1 (%2)").arg(info.fileName()).arg(n)
+                                        : QString("%1 (%2)").arg(base).arg(n)
+                                          + info.fileName().mid(base.size());
+    return QDir(info.path()).filePath(name);
+}
+
+/**
+ * @brief 保存路径为path的续传记录与标识和大小一致时返回记录的偏移，否则返回-1
+ */
+qint64 resumeOffset(const QString& path, quint32 key, qint64 size)
+{
+    QFile resume(path + RESUME_SUFFIX);
+    if(!resume.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QList<QByteArray> fields = resume.readAll().trimmed().split(' ');
+    if(fields.size() != 3 || fields[0].toUInt() != key || fields[1].toLongLong() != size ||
+       !QFile::exists(path + PART_SUFFIX)) {
+        return -1;
+    }
+    return qBound<qint64>(0, fields[2].toLongLong(), size);
+}
+
+/**
+ * @brief 从path起第一个既没有文件也没有.part的候选路径
+ */
+QString unusedPath(const QString& path)
+{
+    for(int n = 0; ; ++n) {
+        const QString candidate = numberedPath(path, n);
+        if(!QFile::exists(candidate) && !QFile::exists(candidate + PART_SUFFIX)) {
+            return candidate;
+        }
+    }
+}
+
+} // namespace
+
+FileTransfer::FileTransfer(QObject *parent)
+    : QObject(parent)
+    , m_sendState(SendIdle)
+    , m_sendId(0)
+    , m_sendKey(0)
+    , m_sendSize(0)
+    , m_sendAcked(0)
+    , m_sendNext(0)
+    , m_sendStartOffset(0)
+    , m_map(nullptr)
+    , m_mapOffset(0)
+    , m_mapSize(0)
+    , m_sendRetries(0)
+    , m_receiveId(0)
+    , m_receiveKey(0)
+    , m_receiveSize(0)
+    , m_receiveNext(0)
+    , m_receiveStartOffset(0)
+    , m_checkpointOffset(0)
+    , m_lastReceivedId(0)
+    , m_lastReceivedSize(0)
+{
+    m_sendTimer = new QTimer(this);
+    m_sendTimer->setSingleShot(true);
+    m_sendTimer->setInterval(ACK_TIMEOUT);
+    m_receiveTimer = new QTimer(this);
+    m_receiveTimer->setSingleShot(true);
+    m_receiveTimer->setInterval(RECEIVE_TIMEOUT);
+    m_ackTimer = new QTimer(this);
+    m_ackTimer->setSingleShot(true);
+    m_ackTimer->setInterval(0);
+    m_lastProgressNs[0] = m_lastProgressNs[1] = 0;
+    m_clock.start();
+
+    connect(m_sendTimer, &QTimer::timeout,
+            this, &FileTransfer::handleSendTimeout);
+    connect(m_receiveTimer, &QTimer::timeout,
+            this, &FileTransfer::handleReceiveTimeout);
+    connect(m_ackTimer, &QTimer::timeout,
+            this, &FileTransfer::sendAck);
+}
+
+FileTransfer::~FileTransfer()
+{
+    // 退出时保留续传记录
+    if(m_receiveId != 0) {
+        saveCheckpoint();
+    }
+}
+
+QByteArray FileTransfer::packetHeader(PacketType type, quint32 id, int extra)
+{
+    QByteArray packet(HEADER_SIZE + extra, Qt::Uninitialized);
+    uchar* header = reinterpret_cast<uchar*>(packet.data());
+    header[0] = type;
+    qToLittleEndian<quint32>(id, header + 1);
+    return packet;
+}
+
+void FileTransfer::sendPacket(PacketType type, quint32 id, qint64 offset)
+{
+    QByteArray packet = packetHeader(type, id, offset >= 0 ? 8 : 0);
+    if(offset >= 0) {
+        qToLittleEndian<qint64>(offset, reinterpret_cast<uchar*>(packet.data()) + HEADER_SIZE);
+    }
+    emit transmit(packet);
+}
+
+bool FileTransfer::isSending() const
+{
+    return m_sendState != SendIdle;
+}
+
+bool FileTransfer::isReceiving() const
+{
+    return m_receiveId != 0;
+}
+
+void FileTransfer::setReceiveTarget(const QString& path)
+{
+    m_receiveTarget = path;
+}
+
+QString FileTransfer::receiveTarget() const
+{
+    return m_receiveTarget;
+}
+
+void FileTransfer::cancel()
+{
+    if(m_sendState != SendIdle) {
+        sendPacket(CancelPacket, m_sendId);
+        finishSend(false, tr("已取消"));
+    }
+    if(m_receiveId != 0) {
+        sendPacket(CancelPacket, m_receiveId);
+        finishReceive(false, tr("已取消，重新发送同一文件即可续传"));
+    }
+}
+
+void FileTransfer::handleFrame(const QByteArray& frame)
+{
+    if(frame.size() < HEADER_SIZE) {
+        return;
+    }
+
+    const uchar* data = reinterpret_cast<const uchar*>(frame.constData());
+    const quint32 id = qFromLittleEndian<quint32>(data + 1);
+    const uchar* body = data + HEADER_SIZE;
+    const int bodySize = frame.size() - HEADER_SIZE;
+
+    switch(data[0]) {
+        case OfferPacket:
+            if(bodySize >= 12) {
+                handleOffer(id, qFromLittleEndian<qint64>(body), qFromLittleEndian<quint32>(body + 8),
+                            QString::fromUtf8(reinterpret_cast<const char*>(body + 12), bodySize - 12));
+            }
+            break;
+        case AcceptPacket:
+            if(bodySize >= 8) {
+                handleAccept(id, qFromLittleEndian<qint64>(body));
+            }
+            break;
+        case ChunkPacket:
+            if(bodySize >= 12) {
+                handleChunk(id, qFromLittleEndian<qint64>(body), qFromLittleEndian<quint32>(body + 8),
+                            reinterpret_cast<const char*>(body + 12), bodySize - 12);
+            }
+            break;
+        case AckPacket:
+            if(bodySize >= 8) {
+                handleAck(id, qFromLittleEndian<qint64>(body));
+            }
+            break;
+        case CancelPacket:
+            if(m_sendState != SendIdle && id == m_sendId) {
+                finishSend(false, tr("对端已取消"));
+            }
+            if(m_receiveId != 0 && id == m_receiveId) {
+                finishReceive(false, tr("对端已取消"));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// ---------------------------------------------------------------- 发送端
+
+/**
+ * @brief 开始发送文件
+ *
+ * @details
+ * 1. 打开文件，由文件名、大小和修改时间算出文件标识，接收端据此判断能否续传
+ * 2. 发出OFFER，等待对端回复起始偏移
+ */
+bool FileTransfer::sendFile(const QString& path)
+{
+    if(m_sendState != SendIdle) {
+        return false;
+    }
+
+    m_sendFile.setFileName(path);
+    if(!m_sendFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const QFileInfo info(path);
+    m_sendSize = m_sendFile.size();
+    const QByteArray identity = info.fileName().toUtf8() + ' ' + QByteArray::number(m_sendSize)
+                              + ' ' + QByteArray::number(info.lastModified().toMSecsSinceEpoch());
+    m_sendKey = Crc::crc32c(identity.constData(), identity.size());
+    m_sendId = newTransferId();
+    m_sendAcked = 0;
+    m_sendNext = 0;
+    m_sendRetries = 0;
+    m_sendState = SendOffering;
+    sendOffer();
+    return true;
+}
+
+void FileTransfer::sendOffer()
+{
+    const QByteArray name = QFileInfo(m_sendFile.fileName()).fileName().toUtf8();
+    QByteArray packet = packetHeader(OfferPacket, m_sendId, 12 + name.size());
+    uchar* body = reinterpret_cast<uchar*>(packet.data()) + HEADER_SIZE;
+    qToLittleEndian<qint64>(m_sendSize, body);
+    qToLittleEndian<quint32>(m_sendKey, body + 8);
+    memcpy(body + 12, name.constData(), name.size());
+    emit transmit(packet);
+    m_sendTimer->start();
+}
+
+void FileTransfer::handleAccept(quint32 id, qint64 offset)
+{
+    // 重复的ACCEPT（对端没收到第一个数据块前又收到重发的OFFER）忽略
+    if(m_sendState != SendOffering || id != m_sendId) {
+        return;
+    }
+
+    m_sendAcked = qBound<qint64>(0, offset, m_sendSize);
+    m_sendNext = m_sendAcked;
+    m_sendStartOffset = m_sendAcked;
+    m_sendRetries = 0;
+    m_sendState = SendStreaming;
+    m_sendClock.start();
+
+    if(m_sendAcked == m_sendSize) {
+        finishSend(true, m_sendFile.fileName());
+        return;
+    }
+    pump();
+    m_sendTimer->start();
+}
+
+/**
+ * @brief 在窗口允许的范围内发出数据块
+ * 数据直接从映射窗口取出，只为组帧拷贝一次
+ */
+void FileTransfer::pump()
+{
+    const qint64 windowBytes = qint64(WINDOW_CHUNKS) * CHUNK_SIZE;
+    while(m_sendNext < m_sendSize && m_sendNext - m_sendAcked < windowBytes) {
+        const int size = static_cast<int>(qMin<qint64>(CHUNK_SIZE, m_sendSize - m_sendNext));
+        const char* data = chunkData(m_sendNext, size);
+        if(!data) {
+            sendPacket(CancelPacket, m_sendId);
+            finishSend(false, tr("读取文件失败: %1").arg(m_sendFile.errorString()));
+            return;
+        }
+
+        QByteArray packet = packetHeader(ChunkPacket, m_sendId, 12 + size);
+        uchar* body = reinterpret_cast<uchar*>(packet.data()) + HEADER_SIZE;
+        qToLittleEndian<qint64>(m_sendNext, body);
+        qToLittleEndian<quint32>(Crc::crc32c(data, size), body + 8);
+        memcpy(body + 12, data, size);
+        emit transmit(packet);
+        m_sendNext += size;
+    }
+}
+
+const char* FileTransfer::chunkData(qint64 offset, int size)
+{
+    if(!m_map || offset < m_mapOffset || offset + size > m_mapOffset + m_mapSize) {
+        if(m_map) {
+            m_sendFile.unmap(m_map);
+            m_map = nullptr;
+        }
+        m_mapOffset = offset;
+        m_mapSize = qMin<qint64>(MAP_WINDOW, m_sendSize - offset);
+        m_map = m_sendFile.map(m_mapOffset, m_mapSize);
+        if(!m_map) {
+            return nullptr;
+        }
+    }
+    return reinterpret_cast<const char*>(m_map + (offset - m_mapOffset));
+}
+
+void FileTransfer::handleAck(quint32 id, qint64 offset)
+{
+    if(m_sendState != SendStreaming || id != m_sendId ||
+       offset <= m_sendAcked || offset > m_sendNext) {
+        return;
+    }
+
+    m_sendAcked = offset;
+    m_sendRetries = 0;
+    m_sendTimer->start();
+    if(m_sendAcked == m_sendSize) {
+        finishSend(true, m_sendFile.fileName());
+        return;
+    }
+    reportProgress(true, false);
+    pump();
+}
+
+/**
+ * @brief 发送端超时
+ *
+ * @details
+ * 1. 连续MAX_RETRIES次没有进展即放弃，对端保留续传记录
+ * 2. 还在等待ACCEPT时重发OFFER
+ * 3. 发送中则回到已确认的偏移重发整个窗口
+ */
+void FileTransfer::handleSendTimeout()
+{
+    if(++m_sendRetries > MAX_RETRIES) {
+        finishSend(false, tr("对端无响应"));
+        return;
+    }
+
+    if(m_sendState == SendOffering) {
+        sendOffer();
+    } else if(m_sendState == SendStreaming) {
+        m_sendNext = m_sendAcked;
+        pump();
+        m_sendTimer->start();
+    }
+}
+
+void FileTransfer::finishSend(bool success, const QString& message)
+{
+    if(success) {
+        reportProgress(true, true);
+    }
+    m_sendTimer->stop();
+    if(m_map) {
+        m_sendFile.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_sendFile.close();
+    m_sendState = SendIdle;
+    emit finished(true, success, message);
+}
+
+// ---------------------------------------------------------------- 接收端
+
+/**
+ * @brief 处理OFFER
+ *
+ * @details
+ * 1. 正在接收时，编号相同说明ACCEPT丢失，按当前偏移再回复一次；编号不同但标识、大小和
+ *    文件名都相同说明对端重启后重新提供同一文件，改用新编号并从当前偏移继续；其他文件一律拒绝
+ * 2. 按接收位置确定保存路径，不覆盖已有文件：依次检查"名称"、"名称 (1)"……，
+ *    .part.resume记录的标识和大小一致的路径从记录的偏移续传，
+ *    否则取第一个既没有文件也没有.part的路径从头接收
+ * 3. 打开.part并预分配到完整大小，磁盘空间不足在开始时即可发现
+ * 4. 回复ACCEPT
+ */
+void FileTransfer::handleOffer(quint32 id, qint64 size, quint32 key, const QString& name)
+{
+    if(m_receiveId != 0) {
+        if(id == m_receiveId) {
+            sendPacket(AcceptPacket, id, m_receiveNext);
+        } else if(key == m_receiveKey && size == m_receiveSize && name == m_receiveName) {
+            m_receiveId = id;
+            m_receiveTimer->start();
+            sendPacket(AcceptPacket, id, m_receiveNext);
+        } else {
+            sendPacket(CancelPacket, id);
+        }
+        return;
+    }
+    if(id == m_lastReceivedId) {
+        sendPacket(AcceptPacket, id, m_lastReceivedSize);
+        return;
+    }
+    if(m_receiveTarget.isEmpty() || size < 0) {
+        sendPacket(CancelPacket, id);
+        return;
+    }
+
+    QString fileName = QFileInfo(name).fileName();
+    if(fileName.isEmpty()) {
+        fileName = QStringLiteral("received.bin");
+    }
+    const QString target = QFileInfo(m_receiveTarget).isDir() ? QDir(m_receiveTarget).filePath(fileName)
+                                                              : m_receiveTarget;
+    qint64 offset = -1;
+    for(int n = 0; offset < 0; ++n) {
+        m_receivePath = numberedPath(target, n);
+        offset = resumeOffset(m_receivePath, key, size);
+        if(offset < 0 && !QFile::exists(m_receivePath) && !QFile::exists(m_receivePath + PART_SUFFIX)) {
+            offset = 0;
+        }
+    }
+    const QString partPath = m_receivePath + PART_SUFFIX;
+
+    m_receiveFile.setFileName(partPath);
+    bool ok = m_receiveFile.open(QIODevice::ReadWrite);
+    if(ok && offset == 0) {
+        ok = m_receiveFile.resize(0);
+    }
+#ifdef Q_OS_LINUX
+    if(ok && size > 0) {
+        // 不支持fallocate的文件系统退回到resize，只是不保证空间
+        const int result = ::posix_fallocate(m_receiveFile.handle(), 0, size);
+        ok = result == 0 || result == EOPNOTSUPP || result == EINVAL;
+    }
+#endif
+    if(ok && m_receiveFile.size() != size) {
+        ok = m_receiveFile.resize(size);
+    }
+    if(!ok) {
+        const QString error = m_receiveFile.errorString();
+        m_receiveFile.close();
+        sendPacket(CancelPacket, id);
+        emit finished(false, false, tr("无法写入 %1: %2").arg(partPath, error));
+        return;
+    }
+
+    m_receiveId = id;
+    m_receiveKey = key;
+    m_receiveName = name;
+    m_receiveSize = size;
+    m_receiveNext = offset;
+    m_receiveStartOffset = offset;
+    m_checkpointOffset = offset;
+    m_receiveClock.start();
+    m_receiveTimer->start();
+    emit receiveStarted(m_receivePath, size, offset);
+
+    sendPacket(AcceptPacket, id, offset);
+    if(m_receiveNext == m_receiveSize) {
+        finishReceive(true, m_receivePath);
+    }
+}
+
+/**
+ * @brief 处理数据块
+ *
+ * @details
+ * 1. 已完成的传输再收到数据块说明确认丢失，直接确认到文件末尾
+ * 2. 只接受偏移正好连续、长度合法且CRC正确的块，写到.part的对应位置
+ * 3. 每写入RESUME_CHECKPOINT字节记录一次续传偏移
+ * 4. 写完最后一块立即确认并改名，否则在本批帧处理完后确认一次
+ */
+void FileTransfer::handleChunk(quint32 id, qint64 offset, quint32 crc, const char* data, int size)
+{
+    if(m_receiveId == 0 || id != m_receiveId) {
+        if(id == m_lastReceivedId) {
+            sendPacket(AckPacket, id, m_lastReceivedSize);
+        }
+        return;
+    }
+    m_receiveTimer->start();
+
+    if(offset == m_receiveNext && size > 0 && size <= CHUNK_SIZE &&
+       offset + size <= m_receiveSize && Crc::crc32c(data, size) == crc) {
+        if(!m_receiveFile.seek(offset) || m_receiveFile.write(data, size) != size) {
+            sendPacket(CancelPacket, id);
+            finishReceive(false, tr("写入文件失败: %1").arg(m_receiveFile.errorString()));
+            return;
+        }
+        m_receiveNext += size;
+        if(m_receiveNext - m_checkpointOffset >= RESUME_CHECKPOINT) {
+            saveCheckpoint();
+        }
+        reportProgress(false, false);
+    }
+
+    if(m_receiveNext == m_receiveSize) {
+        sendPacket(AckPacket, id, m_receiveNext);
+        finishReceive(true, m_receivePath);
+        return;
+    }
+    if(!m_ackTimer->isActive()) {
+        m_ackTimer->start();
+    }
+}
+
+void FileTransfer::sendAck()
+{
+    if(m_receiveId != 0) {
+        sendPacket(AckPacket, m_receiveId, m_receiveNext);
+    }
+}
+
+/**
+ * @brief 记录续传偏移
+ * 先把已写入的数据交给系统，再原子地替换记录文件，记录的偏移之前的数据一定已经写入
+ */
+void FileTransfer::saveCheckpoint()
+{
+    if(!m_receiveFile.isOpen() || !m_receiveFile.flush()) {
+        return;
+    }
+
+    QSaveFile resume(m_receivePath + RESUME_SUFFIX);
+    if(resume.open(QIODevice::WriteOnly)) {
+        resume.write(QByteArray::number(m_receiveKey) + ' ' + QByteArray::number(m_receiveSize)
+                     + ' ' + QByteArray::number(m_receiveNext) + '\n');
+        if(resume.commit()) {
+            m_checkpointOffset = m_receiveNext;
+        }
+    }
+}
+
+void FileTransfer::handleReceiveTimeout()
+{
+    finishReceive(false, tr("传输中断，重新发送同一文件即可续传"));
+}
+
+void FileTransfer::finishReceive(bool success, const QString& message)
+{
+    m_receiveTimer->stop();
+    m_ackTimer->stop();
+
+    QString result = message;
+    if(success) {
+        reportProgress(false, true);
+        m_receiveFile.close();
+        // 不覆盖接收期间出现的同名文件，改存为下一个未使用的名称
+        const QString resumePath = m_receivePath + RESUME_SUFFIX;
+        if(QFile::exists(m_receivePath)) {
+            m_receivePath = unusedPath(m_receivePath);
+        }
+        if(m_receiveFile.rename(m_receivePath)) {
+            QFile::remove(resumePath);
+        } else {
+            success = false;
+            result = tr("无法保存 %1: %2").arg(m_receivePath, m_receiveFile.errorString());
+        }
+        m_lastReceivedId = m_receiveId;
+        m_lastReceivedSize = m_receiveSize;
+    } else {
+        saveCheckpoint();
+        m_receiveFile.close();
+    }
+
+    m_receiveId = 0;
+    emit finished(false, success, result);
+}
+
+void FileTransfer::reportProgress(bool sending, bool force)
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    qint64& last = m_lastProgressNs[sending ? 1 : 0];
+    if(!force && now - last < qint64(PROGRESS_INTERVAL) * 1000000) {
+        return;
+    }
+    last = now;
+
+    const qint64 bytes = sending ? m_sendAcked : m_receiveNext;
+    const qint64 total = sending ? m_sendSize : m_receiveSize;
+    const qint64 start = sending ? m_sendStartOffset : m_receiveStartOffset;
+    const double seconds = (sending ? m_sendClock : m_receiveClock).nsecsElapsed() / 1e9;
+    emit progress(sending, bytes, total, seconds > 0 ? (bytes - start) / seconds : 0);
+}
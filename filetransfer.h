@@ -0,0 +1,212 @@
+#ifndef FILETRANSFER_H
+#define FILETRANSFER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
+
+/**
+ * @brief 串口文件传输
+ *
+ * 在CH34xQt的二进制帧上以CHANNEL通道传输文件，收发两个方向互不影响，可以同时进行。
+ * 内存占用与文件大小无关：
+ * - 发送端按MAP_WINDOW大小分段映射文件，只在当前窗口内取数据，越过窗口即解除映射
+ * - 接收端先把临时文件（目标路径加.part）预分配到完整大小，数据块直接写到对应偏移
+ *
+ * 流程：
+ * 1. 发送端发出OFFER（文件名、大小、文件标识），接收端回复ACCEPT并给出起始偏移
+ * 2. 发送端从该偏移起按CHUNK_SIZE发出数据块，每块带CRC-32C，最多WINDOW_CHUNKS块在途
+ * 3. 接收端只接受偏移连续且校验正确的块，确认已连续写入的偏移；
+ *    发送端ACK_TIMEOUT内没有进展即从已确认的偏移重发（回退N步）
+ * 4. 接收端每写入RESUME_CHECKPOINT字节把已写入的偏移记到.part.resume，
+ *    中断后再次发送同一文件时从记录的偏移续传；全部写完后改名为目标文件
+ *
+ * 帧格式（小端）：
+ * - OFFER： | 10 | id(4) | size(8) | key(4) | 文件名(UTF-8) |
+ * - ACCEPT：| 11 | id(4) | offset(8) |
+ * - CHUNK： | 12 | id(4) | offset(8) | crc32c(4) | 数据 |
+ * - ACK：   | 13 | id(4) | offset(8) |
+ * - CANCEL：| 14 | id(4) |
+ * key由文件名、大小和修改时间算出，文件变化后不会接着旧的.part续传。
+ *
+ * 对象不是线程安全的，须在所属线程使用；发出的帧通过transmit信号交给设备。
+ */
+class FileTransfer : public QObject
+{
+    Q_OBJECT
+public:
+    static const quint8 CHANNEL = 2;                ///< 使用的二进制帧通道
+    static const int CHUNK_SIZE = 4096;             ///< 数据块大小
+    static const int WINDOW_CHUNKS = 16;            ///< 同时在途的最大块数
+    static const int MAP_WINDOW = 4 * 1024 * 1024;  ///< 发送端每次映射的长度，须为CHUNK_SIZE的整数倍
+
+    explicit FileTransfer(QObject *parent = nullptr);
+    ~FileTransfer();
+
+    /**
+     * @brief 开始发送文件
+     * @param path 文件路径
+     * @return 是否已开始（文件无法打开或已有文件在发送时为false）
+     */
+    bool sendFile(const QString& path);
+
+    /**
+     * @brief 设置接收位置
+     * 为目录时按对端给出的文件名保存在其中，否则作为保存路径；为空时拒绝对端的文件。
+     * 不覆盖已有文件，保存路径已存在时改存为"名称 (1).扩展名"等，实际路径由finished给出
+     */
+    void setReceiveTarget(const QString& path);
+    QString receiveTarget() const;
+
+    /**
+     * @brief 取消正在进行的收发
+     * 接收端保留.part和续传记录
+     */
+    void cancel();
+
+    bool isSending() const;
+    bool isReceiving() const;
+
+    /**
+     * @brief 处理一个从CHANNEL通道收到的帧
+     */
+    void handleFrame(const QByteArray& frame);
+
+signals:
+    /**
+     * @brief 需要发出一个帧，由连接方写入CHANNEL通道
+     */
+    void transmit(const QByteArray& packet);
+
+    /**
+     * @brief 开始接收文件
+     * @param path 保存路径
+     * @param size 文件大小
+     * @param offset 续传的起始偏移，0表示从头开始
+     */
+    void receiveStarted(const QString& path, qint64 size, qint64 offset);
+
+    /**
+     * @brief 传输进度，每PROGRESS_INTERVAL最多一次，结束时必定发出一次
+     * @param sending 是否为发送方向
+     * @param bytes 已确认（发送）或已写入（接收）的字节数
+     * @param total 文件大小
+     * @param bytesPerSecond 本次传输的平均速率，不含续传前已有的部分
+     */
+    void progress(bool sending, qint64 bytes, qint64 total, double bytesPerSecond);
+
+    /**
+     * @brief 传输结束
+     * @param sending 是否为发送方向
+     * @param success 是否成功
+     * @param message 成功时为文件路径，失败时为原因
+     */
+    void finished(bool sending, bool success, const QString& message);
+
+private slots:
+    /**
+     * @brief 发送端超时，重发OFFER或从已确认的偏移重发
+     */
+    void handleSendTimeout();
+
+    /**
+     * @brief 接收端长时间没有收到数据，保存续传记录后结束
+     */
+    void handleReceiveTimeout();
+
+    /**
+     * @brief 确认已连续写入的偏移，同一批帧只确认一次
+     */
+    void sendAck();
+
+private:
+    enum PacketType {
+        OfferPacket = 0x10,
+        AcceptPacket = 0x11,
+        ChunkPacket = 0x12,
+        AckPacket = 0x13,
+        CancelPacket = 0x14
+    };
+
+    enum SendState {
+        SendIdle,
+        SendOffering,       ///< 已发出OFFER，等待ACCEPT
+        SendStreaming       ///< 正在发送数据块
+    };
+
+    static QByteArray packetHeader(PacketType type, quint32 id, int extra);
+
+    // 发送端
+    void handleAccept(quint32 id, qint64 offset);
+    void handleAck(quint32 id, qint64 offset);
+    void sendOffer();
+    void pump();
+
+    /**
+     * @brief 取得从offset开始的一个块，必要时移动映射窗口
+     */
+    const char* chunkData(qint64 offset, int size);
+    void finishSend(bool success, const QString& message);
+
+    // 接收端
+    void handleOffer(quint32 id, qint64 size, quint32 key, const QString& name);
+    void handleChunk(quint32 id, qint64 offset, quint32 crc, const char* data, int size);
+
+    /**
+     * @brief 把已写入的偏移记到续传文件
+     */
+    void saveCheckpoint();
+    void finishReceive(bool success, const QString& message);
+
+    /**
+     * @brief 发出只带编号（和偏移）的帧
+     * @param offset 小于0时不带偏移
+     */
+    void sendPacket(PacketType type, quint32 id, qint64 offset = -1);
+    void reportProgress(bool sending, bool force);
+
+    SendState m_sendState;
+    QFile m_sendFile;               ///< 正在发送的文件
+    quint32 m_sendId;               ///< 发送中的传输编号
+    quint32 m_sendKey;              ///< 文件标识
+    qint64 m_sendSize;              ///< 文件大小
+    qint64 m_sendAcked;             ///< 对端已确认的偏移
+    qint64 m_sendNext;              ///< 下一个要发出的偏移
+    qint64 m_sendStartOffset;       ///< 本次从哪个偏移开始，用于计算速率
+    uchar* m_map;                   ///< 当前映射窗口
+    qint64 m_mapOffset;             ///< 映射窗口在文件中的起始偏移
+    qint64 m_mapSize;               ///< 映射窗口长度
+    int m_sendRetries;              ///< 连续无进展的超时次数
+    QTimer* m_sendTimer;            ///< 发送端超时
+    QElapsedTimer m_sendClock;      ///< 本次发送的计时
+
+    QString m_receiveTarget;        ///< 接收位置
+    QFile m_receiveFile;            ///< 正在写入的.part文件
+    QString m_receivePath;          ///< 完成后的文件路径
+    quint32 m_receiveId;            ///< 接收中的传输编号，0表示空闲
+    quint32 m_receiveKey;           ///< 文件标识
+    QString m_receiveName;          ///< OFFER中的文件名，对端重启后重新提供时据此认出同一文件
+    qint64 m_receiveSize;           ///< 文件大小
+    qint64 m_receiveNext;           ///< 已连续写入的偏移
+    qint64 m_receiveStartOffset;    ///< 本次从哪个偏移开始
+    qint64 m_checkpointOffset;      ///< 最近一次记录的续传偏移
+    quint32 m_lastReceivedId;       ///< 最近完成的传输编号，对端重发时据此再次确认
+    qint64 m_lastReceivedSize;      ///< 最近完成的文件大小
+    QTimer* m_receiveTimer;         ///< 接收端空闲超时
+    QTimer* m_ackTimer;             ///< 合并确认
+    QElapsedTimer m_receiveClock;   ///< 本次接收的计时
+
+    qint64 m_lastProgressNs[2];     ///< 两个方向上次报告进度的时刻
+    QElapsedTimer m_clock;          ///< 进度节流使用的时钟
+
+    static const int HEADER_SIZE = 5;               ///< 类型和编号
+    static const int ACK_TIMEOUT = 1000;            ///< 发送端无进展超时(ms)
+    static const int MAX_RETRIES = 10;              ///< 连续超时次数上限
+    static const int RECEIVE_TIMEOUT = 15000;       ///< 接收端空闲超时(ms)
+    static const int RESUME_CHECKPOINT = 256 * 1024;    ///< 续传记录的间隔(字节)
+    static const int PROGRESS_INTERVAL = 200;       ///< 进度报告的最小间隔(ms)
+};
+
+#endif // FILETRANSFER_H
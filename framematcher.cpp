@@ -0,0 +1,312 @@
+#include "framematcher.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#  define FRAMEMATCHER_X86
+#  include <immintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  endif
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define FRAMEMATCHER_HAVE_SSE2
+#endif
+
+// AVX2代码只在运行时确认CPU支持后才会执行，编译时无需全局打开-mavx2
+#if defined(FRAMEMATCHER_X86) && (defined(__GNUC__) || defined(__clang__))
+#  define FRAMEMATCHER_HAVE_AVX2
+#  define FRAMEMATCHER_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(FRAMEMATCHER_X86) && defined(_MSC_VER)
+#  define FRAMEMATCHER_HAVE_AVX2
+#  define FRAMEMATCHER_TARGET_AVX2
+#endif
+
+namespace {
+
+typedef const char* (*FindByteFn)(const char* p, const char* end, char c);
+typedef const char* (*FindMultiFn)(const char* p, const char* end,
+                                   const char* needle, int k, const int* skip);
+
+/**
+ * @brief 最低位1的下标
+ */
+inline int lowestBit(unsigned mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// ---------------------------------------------------------------- 标量实现
+
+const char* findByteScalar(const char* p, const char* end, char c)
+{
+    return static_cast<const char*>(std::memchr(p, c, static_cast<size_t>(end - p)));
+}
+
+/**
+ * @brief Horspool查找，跳转表在setPattern()时预先计算
+ */
+const char* findMultiScalar(const char* p, const char* end,
+                            const char* needle, int k, const int* skip)
+{
+    const unsigned char last = static_cast<unsigned char>(needle[k - 1]);
+    while(end - p >= k) {
+        const unsigned char c = static_cast<unsigned char>(p[k - 1]);
+        if(c == last && std::memcmp(p, needle, static_cast<size_t>(k - 1)) == 0) {
+            return p;
+        }
+        p += skip[c];
+    }
+    return nullptr;
+}
+
+// ---------------------------------------------------------------- SSE2实现
+
+#ifdef FRAMEMATCHER_HAVE_SSE2
+const char* findByteSse2(const char* p, const char* end, char c)
+{
+    const __m128i needle = _mm_set1_epi8(c);
+    while(end - p >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const unsigned mask = static_cast<unsigned>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+        if(mask) {
+            return p + lowestBit(mask);
+        }
+        p += 16;
+    }
+    return findByteScalar(p, end, c);
+}
+
+/**
+ * @brief 首尾字节过滤的子串查找
+ * 同时比较候选位置的首字节和尾字节，两者都匹配的位置才做memcmp确认
+ */
+const char* findMultiSse2(const char* p, const char* end,
+                          const char* needle, int k, const int* skip)
+{
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[k - 1]);
+    while(end - p >= 16 + k - 1) {
+        const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+                    _mm_and_si128(_mm_cmpeq_epi8(blockFirst, first),
+                                  _mm_cmpeq_epi8(blockLast, last))));
+        while(mask) {
+            const int bit = lowestBit(mask);
+            if(std::memcmp(p + bit + 1, needle + 1, static_cast<size_t>(k - 2)) == 0) {
+                return p + bit;
+            }
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+    return findMultiScalar(p, end, needle, k, skip);
+}
+#endif
+
+// ---------------------------------------------------------------- AVX2实现
+
+#ifdef FRAMEMATCHER_HAVE_AVX2
+FRAMEMATCHER_TARGET_AVX2
+const char* findByteAvx2(const char* p, const char* end, char c)
+{
+    const __m256i needle = _mm256_set1_epi8(c);
+    while(end - p >= 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const unsigned mask = static_cast<unsigned>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)));
+        if(mask) {
+            return p + lowestBit(mask);
+        }
+        p += 32;
+    }
+    return findByteScalar(p, end, c);
+}
+
+FRAMEMATCHER_TARGET_AVX2
+const char* findMultiAvx2(const char* p, const char* end,
+                          const char* needle, int k, const int* skip)
+{
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[k - 1]);
+    while(end - p >= 32 + k - 1) {
+        const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + k - 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+                    _mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first),
+                                     _mm256_cmpeq_epi8(blockLast, last))));
+        while(mask) {
+            const int bit = lowestBit(mask);
+            if(std::memcmp(p + bit + 1, needle + 1, static_cast<size_t>(k - 2)) == 0) {
+                return p + bit;
+            }
+            mask &= mask - 1;
+        }
+        p += 32;
+    }
+    return findMultiScalar(p, end, needle, k, skip);
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if(!osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;   // 操作系统未保存YMM寄存器
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+struct Dispatch {
+    FindByteFn findByte;
+    FindMultiFn findMulti;
+};
+
+Dispatch dispatchFor(FrameMatcher::Implementation impl)
+{
+    Dispatch d = { findByteScalar, findMultiScalar };
+    switch(impl) {
+#ifdef FRAMEMATCHER_HAVE_SSE2
+    case FrameMatcher::Sse2Implementation:
+        d.findByte = findByteSse2;
+        d.findMulti = findMultiSse2;
+        break;
+#endif
+#ifdef FRAMEMATCHER_HAVE_AVX2
+    case FrameMatcher::Avx2Implementation:
+        d.findByte = findByteAvx2;
+        d.findMulti = findMultiAvx2;
+        break;
+#endif
+    default:
+        break;
+    }
+    return d;
+}
+
+FrameMatcher::Implementation bestImplementation()
+{
+    static const FrameMatcher::Implementation best =
+            FrameMatcher::isSupported(FrameMatcher::Avx2Implementation)
+            ? FrameMatcher::Avx2Implementation
+            : FrameMatcher::isSupported(FrameMatcher::Sse2Implementation)
+              ? FrameMatcher::Sse2Implementation
+              : FrameMatcher::ScalarImplementation;
+    return best;
+}
+
+} // namespace
+
+FrameMatcher::FrameMatcher()
+    : m_impl(bestImplementation())
+{
+    setPattern(QByteArray());
+}
+
+FrameMatcher::FrameMatcher(const QByteArray& pattern)
+    : m_impl(bestImplementation())
+{
+    setPattern(pattern);
+}
+
+/**
+ * @brief 预处理标记
+ * 计算Horspool跳转表，供标量实现及SIMD实现的尾部处理使用
+ */
+void FrameMatcher::setPattern(const QByteArray& pattern)
+{
+    m_pattern = pattern;
+
+    const int k = m_pattern.size();
+    for(int i = 0; i < 256; ++i) {
+        m_skip[i] = qMax(k, 1);
+    }
+    for(int i = 0; i < k - 1; ++i) {
+        m_skip[static_cast<unsigned char>(m_pattern.at(i))] = k - 1 - i;
+    }
+}
+
+int FrameMatcher::indexIn(const char* data, int size, int from) const
+{
+    const int k = m_pattern.size();
+    if(k == 0 || from < 0 || size - from < k) {
+        return -1;
+    }
+
+    const Dispatch d = dispatchFor(m_impl);
+    const char* begin = data + from;
+    const char* end = data + size;
+    const char* found = (k == 1)
+            ? d.findByte(begin, end, m_pattern.at(0))
+            : d.findMulti(begin, end, m_pattern.constData(), k, m_skip);
+    return found ? static_cast<int>(found - data) : -1;
+}
+
+bool FrameMatcher::setImplementation(Implementation impl)
+{
+    if(impl == AutoImplementation) {
+        m_impl = bestImplementation();
+        return true;
+    }
+    if(!isSupported(impl)) {
+        return false;
+    }
+    m_impl = impl;
+    return true;
+}
+
+bool FrameMatcher::isSupported(Implementation impl)
+{
+    switch(impl) {
+    case AutoImplementation:
+    case ScalarImplementation:
+        return true;
+    case Sse2Implementation:
+#ifdef FRAMEMATCHER_HAVE_SSE2
+        return true;
+#else
+        return false;
+#endif
+    case Avx2Implementation:
+#ifdef FRAMEMATCHER_HAVE_AVX2
+    {
+        static const bool supported = cpuHasAvx2();
+        return supported;
+    }
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+const char* FrameMatcher::implementationName(Implementation impl)
+{
+    switch(impl) {
+    case AutoImplementation: return "auto";
+    case ScalarImplementation: return "scalar";
+    case Sse2Implementation: return "sse2";
+    case Avx2Implementation: return "avx2";
+    }
+    return "unknown";
+}
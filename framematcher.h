@@ -0,0 +1,78 @@
+#ifndef FRAMEMATCHER_H
+#define FRAMEMATCHER_H
+
+#include <QByteArray>
+
+/**
+ * @brief 预编译的帧分隔符/标记查找器
+ *
+ * 在setPattern()时一次性编码并预处理标记，接收路径上不再重复toUtf8()：
+ * - 单字节分隔符：SSE2/AVX2按16/32字节并行比较
+ * - 多字节标记：先用SIMD同时比较首字节和尾字节筛选候选位置，再逐个确认
+ * - 不支持SIMD的平台退化为memchr/Horspool
+ *
+ * 具体实现在运行时根据CPU特性选择，也可手动指定以便基准测试对比。
+ */
+class FrameMatcher
+{
+public:
+    /**
+     * @brief 查找实现
+     */
+    enum Implementation {
+        AutoImplementation,     ///< 按CPU特性自动选择最快的实现
+        ScalarImplementation,   ///< memchr/Horspool
+        Sse2Implementation,     ///< SSE2，16字节并行
+        Avx2Implementation      ///< AVX2，32字节并行
+    };
+
+    FrameMatcher();
+    explicit FrameMatcher(const QByteArray& pattern);
+
+    /**
+     * @brief 设置并预处理要查找的标记
+     * @param pattern 标记字节序列，为空时indexIn()总是返回-1
+     */
+    void setPattern(const QByteArray& pattern);
+    const QByteArray& pattern() const { return m_pattern; }
+    int size() const { return m_pattern.size(); }
+    bool isEmpty() const { return m_pattern.isEmpty(); }
+
+    /**
+     * @brief 在数据中查找标记
+     * @param data 数据指针
+     * @param size 数据长度
+     * @param from 起始偏移
+     * @return 标记首字节的偏移，未找到返回-1
+     */
+    int indexIn(const char* data, int size, int from = 0) const;
+    int indexIn(const QByteArray& data, int from = 0) const
+    {
+        return indexIn(data.constData(), data.size(), from);
+    }
+
+    /**
+     * @brief 指定查找实现
+     * @param impl 实现
+     * @return CPU不支持该实现时返回false并保持原实现
+     */
+    bool setImplementation(Implementation impl);
+    Implementation implementation() const { return m_impl; }
+
+    /**
+     * @brief 当前CPU是否支持指定实现
+     */
+    static bool isSupported(Implementation impl);
+
+    /**
+     * @brief 实现名称，用于日志和基准测试输出
+     */
+    static const char* implementationName(Implementation impl);
+
+private:
+    QByteArray m_pattern;       ///< 标记字节序列
+    Implementation m_impl;      ///< 实际使用的实现（不为Auto）
+    int m_skip[256];            ///< Horspool坏字符跳转表
+};
+
+#endif // FRAMEMATCHER_H
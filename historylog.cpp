@@ -0,0 +1,305 @@
+#include "historylog.h"
+#include <QtEndian>
+#include <QLockFile>
+#include <QDebug>
+
+HistoryLog::HistoryLog()
+    : m_current(0)
+    , m_lock(nullptr)
+    , m_maxSize(0)
+    , m_first(0)
+    , m_count(0)
+{
+    m_segments[0].base = m_segments[1].base = 0;
+    m_segments[0].dataSize = m_segments[1].dataSize = 0;
+}
+
+HistoryLog::~HistoryLog()
+{
+    close();
+}
+
+/**
+ * @brief 打开日志
+ *
+ * @details
+ * 1. 取得path加".lock"的锁，锁只在持有的进程退出后才失效，运行再久也不会被其他进程抢走
+ * 2. 清空并打开两段的记录文件和索引文件
+ */
+bool HistoryLog::open(const QString& path, qint64 maxSize)
+{
+    close();
+    m_current = 0;
+
+    m_lock = new QLockFile(path + QStringLiteral(".lock"));
+    m_lock->setStaleLockTime(0);
+    if(!m_lock->tryLock(0)) {
+        m_errorString = m_lock->error() == QLockFile::LockFailedError
+                        ? QStringLiteral("已被其他进程使用") : QStringLiteral("无法创建锁文件");
+        delete m_lock;
+        m_lock = nullptr;
+        return false;
+    }
+
+    // 已有自己的缓冲区，不再经过QFile的缓冲
+    const QIODevice::OpenMode mode = QIODevice::ReadWrite | QIODevice::Truncate | QIODevice::Unbuffered;
+    for(int i = 0; i < 2; ++i) {
+        Segment& segment = m_segments[i];
+        const QString dataPath = i == 0 ? path : path + QStringLiteral(".1");
+        segment.dataFile.setFileName(dataPath);
+        segment.indexFile.setFileName(dataPath + QStringLiteral(".idx"));
+        if(!segment.dataFile.open(mode)) {
+            m_errorString = segment.dataFile.errorString();
+            close();
+            return false;
+        }
+        if(!segment.indexFile.open(mode)) {
+            m_errorString = segment.indexFile.errorString();
+            close();
+            return false;
+        }
+        segment.base = 0;
+        segment.dataSize = 0;
+    }
+
+    m_dataBuffer.reserve(BUFFER_SIZE);
+    m_indexBuffer.reserve(BUFFER_SIZE);
+    m_maxSize = qMax<qint64>(0, maxSize);
+    m_first = 0;
+    m_count = 0;
+    m_errorString.clear();
+    return true;
+}
+
+void HistoryLog::close()
+{
+    if(isOpen()) {
+        flush();
+    }
+    for(Segment& segment : m_segments) {
+        segment.dataFile.close();
+        segment.indexFile.close();
+    }
+    m_dataBuffer.clear();
+    m_indexBuffer.clear();
+    delete m_lock;
+    m_lock = nullptr;
+}
+
+bool HistoryLog::isOpen() const
+{
+    return m_segments[m_current].dataFile.isOpen();
+}
+
+QString HistoryLog::path() const
+{
+    return m_segments[0].dataFile.fileName();
+}
+
+QString HistoryLog::errorString() const
+{
+    return m_errorString;
+}
+
+/**
+ * @brief 追加消息
+ *
+ * @details
+ * 1. 设置了上限且当前段（记录加索引）已达到上限的一半时先轮换
+ * 2. 记录和索引项追加到缓冲区，缓冲区满时写入文件
+ */
+void HistoryLog::append(const ChatMessageModel::Message& message)
+{
+    if(!isOpen()) {
+        return;
+    }
+
+    Segment* segment = &m_segments[m_current];
+    const qint64 segmentCount = m_count - segment->base;
+    if(m_maxSize > 0 && segmentCount > 0 &&
+       segment->dataSize + segmentCount * INDEX_ENTRY_SIZE >= m_maxSize / 2) {
+        rotate();
+        if(!isOpen()) {
+            return;
+        }
+        segment = &m_segments[m_current];
+    }
+
+    const QByteArray text = message.text.toUtf8();
+    uchar header[RECORD_HEADER_SIZE] = {};
+    qToLittleEndian<qint64>(message.time, header);
+    header[8] = uchar(message.kind);
+    qToLittleEndian<quint32>(quint32(text.size()), header + 12);
+
+    uchar entry[INDEX_ENTRY_SIZE];
+    qToLittleEndian<qint64>(segment->dataSize, entry);
+    m_indexBuffer.append(reinterpret_cast<const char*>(entry), INDEX_ENTRY_SIZE);
+    m_dataBuffer.append(reinterpret_cast<const char*>(header), RECORD_HEADER_SIZE);
+    m_dataBuffer.append(text);
+    segment->dataSize += RECORD_HEADER_SIZE + text.size();
+    m_count++;
+
+    if(m_dataBuffer.size() >= BUFFER_SIZE || m_indexBuffer.size() >= BUFFER_SIZE) {
+        flush();
+    }
+}
+
+/**
+ * @brief 读取消息
+ *
+ * @details
+ * 1. 先写出缓冲区，保证要读的记录都已在文件中
+ * 2. 范围从较早一段开始时先从该段读取，其余部分从当前段读取
+ */
+QVector<ChatMessageModel::Message> HistoryLog::read(qint64 first, int count)
+{
+    QVector<ChatMessageModel::Message> messages;
+    if(!isOpen() || first < m_first || first >= m_count || count <= 0 || !flush()) {
+        return messages;
+    }
+
+    count = int(qMin<qint64>(count, m_count - first));
+    messages.reserve(count);
+    Segment& current = m_segments[m_current];
+    if(first < current.base) {
+        const int older = int(qMin<qint64>(count, current.base - first));
+        if(!readSegment(m_segments[1 - m_current], current.base, first, older, messages)) {
+            return messages;
+        }
+        first += older;
+        count -= older;
+    }
+    if(count > 0) {
+        readSegment(current, m_count, first, count, messages);
+    }
+    return messages;
+}
+
+/**
+ * @brief 从一段中读取消息
+ *
+ * @details
+ * 1. 由索引文件取得第一条记录的偏移，以及之后一条记录的偏移作为结束位置，
+ *    读到该段末尾时以记录文件长度为结束位置
+ * 2. 一次读入整段记录后逐条解析，记录不完整时停止
+ */
+bool HistoryLog::readSegment(Segment& segment, qint64 end, qint64 first, int count,
+                             QVector<ChatMessageModel::Message>& messages)
+{
+    const qint64 entry = first - segment.base;
+    const bool toEnd = first + count == end;
+    const int entries = toEnd ? 1 : 2;
+    QByteArray index(entries * INDEX_ENTRY_SIZE, Qt::Uninitialized);
+    QFile& indexFile = segment.indexFile;
+    if(!indexFile.seek(entry * INDEX_ENTRY_SIZE)
+       || indexFile.read(index.data(), INDEX_ENTRY_SIZE) != INDEX_ENTRY_SIZE
+       || (!toEnd && (!indexFile.seek((entry + count) * INDEX_ENTRY_SIZE)
+                      || indexFile.read(index.data() + INDEX_ENTRY_SIZE, INDEX_ENTRY_SIZE)
+                         != INDEX_ENTRY_SIZE))) {
+        qWarning() << "History index read failed:" << indexFile.fileName() << indexFile.errorString();
+        return false;
+    }
+
+    const uchar* offsets = reinterpret_cast<const uchar*>(index.constData());
+    const qint64 begin = qFromLittleEndian<qint64>(offsets);
+    const qint64 stop = toEnd ? segment.dataSize : qFromLittleEndian<qint64>(offsets + INDEX_ENTRY_SIZE);
+    if(!segment.dataFile.seek(begin)) {
+        return false;
+    }
+    const QByteArray data = segment.dataFile.read(stop - begin);
+    if(data.size() != stop - begin) {
+        qWarning() << "History read failed:" << segment.dataFile.fileName()
+                   << segment.dataFile.errorString();
+        return false;
+    }
+
+    const uchar* records = reinterpret_cast<const uchar*>(data.constData());
+    qint64 pos = 0;
+    for(int i = 0; i < count; ++i) {
+        const uchar* header = records + pos;
+        if(data.size() - pos < RECORD_HEADER_SIZE) {
+            return false;
+        }
+        const quint32 length = qFromLittleEndian<quint32>(header + 12);
+        if(data.size() - pos - RECORD_HEADER_SIZE < length) {
+            return false;
+        }
+        messages.append(ChatMessageModel::Message{
+            quint64(first + i),
+            QString::fromUtf8(data.constData() + pos + RECORD_HEADER_SIZE, int(length)),
+            qFromLittleEndian<qint64>(header),
+            ChatMessageModel::Kind(header[8])});
+        pos += RECORD_HEADER_SIZE + length;
+    }
+    return true;
+}
+
+bool HistoryLog::flush()
+{
+    if(!isOpen()) {
+        return false;
+    }
+
+    // 读取会移动文件位置，写入前回到末尾；resize(0)保留reserve()预留的容量
+    Segment& segment = m_segments[m_current];
+    if(!m_dataBuffer.isEmpty()) {
+        const bool complete = segment.dataFile.seek(segment.dataFile.size())
+                              && segment.dataFile.write(m_dataBuffer) == m_dataBuffer.size();
+        m_dataBuffer.resize(0);
+        if(!complete) {
+            fail(segment.dataFile);
+            return false;
+        }
+    }
+    if(!m_indexBuffer.isEmpty()) {
+        const bool complete = segment.indexFile.seek(segment.indexFile.size())
+                              && segment.indexFile.write(m_indexBuffer) == m_indexBuffer.size();
+        m_indexBuffer.resize(0);
+        if(!complete) {
+            fail(segment.indexFile);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 轮换
+ *
+ * @details
+ * 1. 写出当前段的缓冲区
+ * 2. 清空另一段，其中较早的消息不再能读取，可读取的范围从当前段开始
+ * 3. 之后的消息写入另一段
+ */
+void HistoryLog::rotate()
+{
+    if(!flush()) {
+        return;
+    }
+
+    Segment& next = m_segments[1 - m_current];
+    if(!next.dataFile.resize(0)) {
+        fail(next.dataFile);
+        return;
+    }
+    if(!next.indexFile.resize(0)) {
+        fail(next.indexFile);
+        return;
+    }
+    m_first = m_segments[m_current].base;
+    next.base = m_count;
+    next.dataSize = 0;
+    m_current = 1 - m_current;
+}
+
+void HistoryLog::fail(const QFile& file)
+{
+    m_errorString = file.errorString();
+    qWarning() << "History log stopped:" << file.fileName() << m_errorString;
+    for(Segment& segment : m_segments) {
+        segment.dataFile.close();
+        segment.indexFile.close();
+    }
+    m_dataBuffer.clear();
+    m_indexBuffer.clear();
+}
@@ -0,0 +1,119 @@
+#ifndef HISTORYLOG_H
+#define HISTORYLOG_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include "chatmessagemodel.h"
+
+class QLockFile;
+
+/**
+ * @brief 聊天记录的磁盘日志
+ *
+ * 消息按到达顺序追加到记录文件，每条消息在索引文件中占一个固定长度的偏移，
+ * 第i条消息的位置由索引文件第i项直接得到，不需要在内存中保存索引（均为小端）：
+ * - 记录文件：| time(8，Unix毫秒) | kind(1) | 保留(3) | length(4) | UTF-8文本 |
+ * - 索引文件：| 记录在记录文件中的偏移(8) | ...
+ * 写入先进入内存缓冲区，满BUFFER_SIZE、读取前或关闭时写入文件。
+ * 写入失败（如磁盘已满）时给出警告并关闭日志，之后既不记录也不能读取。
+ *
+ * 日志分为两段轮流写入，设置了上限时当前段达到上限的一半即清空另一段并改写到那一段，
+ * 较早一段中的消息随之删除，磁盘占用不超过上限；first()之前的消息不能再读取。
+ * 两段文件在打开时清空，只保存本次运行的记录。
+ * 打开期间持有path加".lock"的锁，同一路径不能被两个进程同时使用。
+ */
+class HistoryLog
+{
+public:
+    HistoryLog();
+    ~HistoryLog();
+
+    /**
+     * @brief 新建日志，两段的记录文件为path和path加".1"，索引文件另加".idx"，已存在的文件被覆盖
+     * @param maxSize 两段文件合计的字节数上限，0表示不限
+     * @return 是否成功（路径已被其他进程使用时也失败），失败原因见errorString()
+     */
+    bool open(const QString& path, qint64 maxSize = 0);
+
+    /**
+     * @brief 写出缓冲的记录并关闭文件
+     */
+    void close();
+
+    bool isOpen() const;
+    QString path() const;
+    QString errorString() const;
+
+    /**
+     * @brief 已追加的消息数
+     */
+    qint64 count() const { return m_count; }
+
+    /**
+     * @brief 仍可读取的第一条消息的序号，更早的消息已随轮换删除
+     */
+    qint64 first() const { return m_first; }
+
+    /**
+     * @brief 追加一条消息，消息的编号不写入日志，按追加顺序从0编号
+     */
+    void append(const ChatMessageModel::Message& message);
+
+    /**
+     * @brief 读取从first开始的最多count条消息，消息编号为其在日志中的序号
+     */
+    QVector<ChatMessageModel::Message> read(qint64 first, int count);
+
+    /**
+     * @brief 把缓冲的记录写入文件
+     * @return 是否成功
+     */
+    bool flush();
+
+    static const int RECORD_HEADER_SIZE = 16;   ///< 记录头长度
+    static const int INDEX_ENTRY_SIZE = 8;      ///< 索引项长度
+
+private:
+    /**
+     * @brief 日志的一段
+     */
+    struct Segment {
+        QFile dataFile;     ///< 记录文件
+        QFile indexFile;    ///< 索引文件
+        qint64 base;        ///< 第一条消息的序号
+        qint64 dataSize;    ///< 记录文件长度，含缓冲部分
+    };
+
+    /**
+     * @brief 从一段中读取消息，该段的消息序号止于end
+     * @return 是否读到了全部count条
+     */
+    bool readSegment(Segment& segment, qint64 end, qint64 first, int count,
+                     QVector<ChatMessageModel::Message>& messages);
+
+    /**
+     * @brief 清空另一段并改为写入它
+     */
+    void rotate();
+
+    /**
+     * @brief 写入失败后关闭日志
+     */
+    void fail(const QFile& file);
+
+    Segment m_segments[2];      ///< 两段日志
+    int m_current;              ///< 正在写入的段
+    QLockFile* m_lock;          ///< 打开期间持有的锁
+    QByteArray m_dataBuffer;    ///< 尚未写入文件的记录
+    QByteArray m_indexBuffer;   ///< 尚未写入文件的索引项
+    qint64 m_maxSize;           ///< 两段合计的字节数上限，0表示不限
+    qint64 m_first;             ///< 仍可读取的第一条消息的序号
+    qint64 m_count;             ///< 已追加的消息数
+    QString m_errorString;      ///< 最近一次失败的原因
+
+    static const int BUFFER_SIZE = 64 * 1024;   ///< 缓冲区达到该长度即写入文件
+};
+
+#endif // HISTORYLOG_H
@@ -0,0 +1,114 @@
+#include "localsockettransport.h"
+#include <QLocalSocket>
+
+LocalSocketTransport::LocalSocketTransport(QObject *parent)
+    : SerialTransport(parent)
+    , m_closing(false)
+{
+    m_socket = new QLocalSocket(this);
+
+    connect(m_socket, &QLocalSocket::readyRead,
+            this, &SerialTransport::readyRead);
+    connect(m_socket, &QLocalSocket::bytesWritten,
+            this, &SerialTransport::bytesWritten);
+    connect(m_socket, &QLocalSocket::disconnected,
+            this, &LocalSocketTransport::handleDisconnected);
+}
+
+LocalSocketTransport::~LocalSocketTransport()
+{
+    close();
+}
+
+/**
+ * @brief 连接到服务端
+ *
+ * @details
+ * 1. 服务端不存在或拒绝连接时报告DeviceNotFoundError，由调用方重试
+ * 2. 无权限报告PermissionError，其他错误报告OpenError
+ */
+bool LocalSocketTransport::open()
+{
+    m_socket->connectToServer(address(), QIODevice::ReadWrite);
+    if(m_socket->waitForConnected(CONNECT_TIMEOUT)) {
+        return true;
+    }
+
+    QSerialPort::SerialPortError error = QSerialPort::OpenError;
+    switch(m_socket->error()) {
+    case QLocalSocket::ServerNotFoundError:
+    case QLocalSocket::ConnectionRefusedError:
+    case QLocalSocket::SocketTimeoutError:
+        error = QSerialPort::DeviceNotFoundError;
+        break;
+    case QLocalSocket::SocketAccessError:
+        error = QSerialPort::PermissionError;
+        break;
+    default:
+        break;
+    }
+
+    const QString message = m_socket->errorString();
+    m_closing = true;
+    m_socket->abort();
+    m_closing = false;
+    setError(error, message);
+    return false;
+}
+
+void LocalSocketTransport::close()
+{
+    if(m_socket->state() == QLocalSocket::UnconnectedState) {
+        return;
+    }
+
+    m_closing = true;
+    m_socket->abort();
+    m_closing = false;
+}
+
+bool LocalSocketTransport::isOpen() const
+{
+    return m_socket->state() == QLocalSocket::ConnectedState;
+}
+
+QByteArray LocalSocketTransport::readAll()
+{
+    return m_socket->readAll();
+}
+
+qint64 LocalSocketTransport::bytesAvailable() const
+{
+    return m_socket->bytesAvailable();
+}
+
+qint64 LocalSocketTransport::write(const char* data, qint64 size)
+{
+    return m_socket->write(data, size);
+}
+
+qint64 LocalSocketTransport::bytesToWrite() const
+{
+    return m_socket->bytesToWrite();
+}
+
+void LocalSocketTransport::setReadBufferSize(qint64 size)
+{
+    m_socket->setReadBufferSize(size);
+}
+
+bool LocalSocketTransport::clear(QSerialPort::Directions directions)
+{
+    if(directions & QSerialPort::Input) {
+        m_socket->readAll();
+    }
+    // 已交给QLocalSocket的数据无法撤回，输出方向只能忽略
+    return true;
+}
+
+void LocalSocketTransport::handleDisconnected()
+{
+    if(!m_closing) {
+        setError(QSerialPort::ResourceError, tr("对端已断开"));
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef LOCALSOCKETTRANSPORT_H
+#define LOCALSOCKETTRANSPORT_H
+
+#include "serialtransport.h"
+
+class QLocalSocket;
+
+/**
+ * @brief Unix域套接字传输层
+ *
+ * 端口名为"unix:路径"。服务端尚未监听时以DeviceNotFoundError报告，
+ * CH34xQt会像等待串口设备出现一样重试；连接断开报告ResourceError。
+ */
+class LocalSocketTransport : public SerialTransport
+{
+    Q_OBJECT
+public:
+    explicit LocalSocketTransport(QObject *parent = nullptr);
+    ~LocalSocketTransport();
+
+    Kind kind() const override { return LocalSocketKind; }
+
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+
+    QByteArray readAll() override;
+    qint64 bytesAvailable() const override;
+    qint64 write(const char* data, qint64 size) override;
+    qint64 bytesToWrite() const override;
+    void setReadBufferSize(qint64 size) override;
+    bool clear(QSerialPort::Directions directions = QSerialPort::AllDirections) override;
+
+private slots:
+    void handleDisconnected();
+
+private:
+    QLocalSocket* m_socket;     ///< 套接字对象
+    bool m_closing;             ///< 正在主动关闭，不报告断开
+
+    static const int CONNECT_TIMEOUT = 200;     ///< 连接超时(ms)
+};
+
+#endif // LOCALSOCKETTRANSPORT_H
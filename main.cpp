@@ -55,7 +55,7 @@ int main(int argc, char *argv[])
     } else {
         // CLI模式
         if(cli.handleCommands(parser)) {
-            return 0;  // 命令已执行完毕
+            return cli.exitCode();  // 命令已执行完毕
         }
         return app->exec();  // 持续运行（如读取模式）
     }
@@ -1,32 +1,94 @@
 #include "messagelistwindow.h"
-#include <QHBoxLayout>
+#include <QPainter>
+#include <QEvent>
 
-MessageListItem::MessageListItem(const QString& name, const QString& message, 
-                               const QDateTime& time, QWidget* parent)
-    : QWidget(parent)
+ConversationDelegate::ConversationDelegate(QObject* parent)
+    : QStyledItemDelegate(parent)
 {
-    QVBoxLayout* mainLayout = new QVBoxLayout(this);
-    mainLayout->setSpacing(4);
-    mainLayout->setContentsMargins(8, 8, 8, 8);
-    
-    QHBoxLayout* topLayout = new QHBoxLayout();
-    
-    m_nameLabel = new QLabel(name, this);
-    m_timeLabel = new QLabel(time.toString("hh:mm:ss"), this);
-    
-    m_nameLabel->setStyleSheet("font-weight: bold; color: #1890ff;");
-    m_timeLabel->setStyleSheet("color: #8c8c8c; font-size: 9pt;");
-    
-    topLayout->addWidget(m_nameLabel);
-    topLayout->addStretch();
-    topLayout->addWidget(m_timeLabel);
-    
-    m_messageLabel = new QLabel(message, this);
-    m_messageLabel->setWordWrap(true);
-    m_messageLabel->setStyleSheet("color: #333333;");
-    
-    mainLayout->addLayout(topLayout);
-    mainLayout->addWidget(m_messageLabel);
+}
+
+/**
+ * @brief 绘制一个会话
+ *
+ * @details
+ * 1. 悬停时绘制浅灰背景，底部绘制分隔线
+ * 2. 第一行左侧为对端名称，右侧为时间
+ * 3. 第二行为最后一条消息，本端发出的加"我: "前缀，超出宽度时省略
+ * 4. 有未读时在第二行右侧绘制红色角标，超过99显示"99+"
+ */
+void ConversationDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option,
+                                 const QModelIndex& index) const
+{
+    const QRect rect = option.rect;
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+
+    if(option.state & QStyle::State_MouseOver) {
+        painter->fillRect(rect, QColor("#f5f5f5"));
+    }
+    painter->setPen(QColor("#f0f0f0"));
+    painter->drawLine(rect.bottomLeft(), rect.bottomRight());
+
+    const QRect content = rect.adjusted(PADDING, PADDING, -PADDING, -PADDING);
+    const int lineHeight = content.height() / 2;
+    const QRect topRect(content.left(), content.top(), content.width(), lineHeight);
+    QRect bottomRect(content.left(), content.top() + lineHeight, content.width(), lineHeight);
+
+    // 时间
+    QFont timeFont = option.font;
+    timeFont.setPointSizeF(9);
+    painter->setFont(timeFont);
+    painter->setPen(QColor("#8c8c8c"));
+    const QString time = index.data(ConversationModel::TimeRole).toDateTime().toString("hh:mm:ss");
+    const int timeWidth = QFontMetrics(timeFont).horizontalAdvance(time);
+    painter->drawText(topRect, Qt::AlignRight | Qt::AlignVCenter, time);
+
+    // 对端名称
+    QFont nameFont = option.font;
+    nameFont.setBold(true);
+    painter->setFont(nameFont);
+    painter->setPen(QColor("#1890ff"));
+    const QRect nameRect = topRect.adjusted(0, 0, -timeWidth - PADDING, 0);
+    painter->drawText(nameRect, Qt::AlignLeft | Qt::AlignVCenter,
+                      QFontMetrics(nameFont).elidedText(index.data().toString(), Qt::ElideRight,
+                                                        nameRect.width()));
+
+    // 未读角标
+    const int unread = index.data(ConversationModel::UnreadRole).toInt();
+    painter->setFont(option.font);
+    if(unread > 0) {
+        const QString badge = unread > 99 ? QString("99+") : QString::number(unread);
+        const int badgeWidth = qMax(int(BADGE_HEIGHT),
+                                    QFontMetrics(option.font).horizontalAdvance(badge) + BADGE_HEIGHT / 2);
+        const QRect badgeRect(bottomRect.right() - badgeWidth + 1,
+                              bottomRect.center().y() - BADGE_HEIGHT / 2,
+                              badgeWidth, BADGE_HEIGHT);
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(QColor("#ff4d4f"));
+        painter->drawRoundedRect(badgeRect, BADGE_HEIGHT / 2.0, BADGE_HEIGHT / 2.0);
+        painter->setPen(Qt::white);
+        painter->drawText(badgeRect, Qt::AlignCenter, badge);
+        bottomRect.setRight(badgeRect.left() - PADDING);
+    }
+
+    // 最后一条消息，只显示第一行
+    QString message = index.data(ConversationModel::LastMessageRole).toString();
+    message = message.left(message.indexOf(QLatin1Char('\n')));
+    if(index.data(ConversationModel::FromMeRole).toBool()) {
+        message = tr("我: %1").arg(message);
+    }
+    painter->setPen(QColor("#333333"));
+    painter->drawText(bottomRect, Qt::AlignLeft | Qt::AlignVCenter,
+                      QFontMetrics(option.font).elidedText(message, Qt::ElideRight, bottomRect.width()));
+
+    painter->restore();
+}
+
+QSize ConversationDelegate::sizeHint(const QStyleOptionViewItem& option,
+                                     const QModelIndex& index) const
+{
+    Q_UNUSED(index);
+    return QSize(option.rect.width(), ROW_HEIGHT);
 }
 
 MessageListWindow::MessageListWindow(QWidget* parent) : QWidget(parent)
@@ -46,14 +108,24 @@ void MessageListWindow::setupUi()
     m_titleLabel->setAlignment(Qt::AlignCenter);
     m_titleLabel->setFixedHeight(40);
     
-    // 消息列表
-    m_listWidget = new QListWidget(this);
-    m_listWidget->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
-    m_listWidget->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    m_listWidget->setFrameShape(QFrame::NoFrame);
+    // 会话列表，每个端口一行
+    m_model = new ConversationModel(this);
+    m_listView = new QListView(this);
+    m_listView->setModel(m_model);
+    m_listView->setItemDelegate(new ConversationDelegate(m_listView));
+    m_listView->setUniformItemSizes(true);
+    m_listView->setMouseTracking(true);
+    m_listView->setSelectionMode(QAbstractItemView::NoSelection);
+    m_listView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_listView->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    m_listView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    m_listView->setFrameShape(QFrame::NoFrame);
+    connect(m_listView, &QListView::clicked, this, [this](const QModelIndex& index) {
+        m_model->markRead(index.data().toString());
+    });
     
     mainLayout->addWidget(m_titleLabel);
-    mainLayout->addWidget(m_listWidget);
+    mainLayout->addWidget(m_listView);
     
     setFixedWidth(300);
 }
@@ -71,35 +143,65 @@ void MessageListWindow::applyStyle()
             font-size: 12pt;
             font-weight: bold;
         }
-        QListWidget {
+        QListView {
             background-color: white;
             border: none;
         }
-        QListWidget::item {
-            background-color: white;
-            border-bottom: 1px solid #f0f0f0;
-            padding: 0px;
-        }
-        QListWidget::item:hover {
-            background-color: #f5f5f5;
-        }
     )");
 }
 
 void MessageListWindow::addMessage(const QString& portName, const QString& message, bool isFromMe)
 {
-    QString name = isFromMe ? tr("我") : portName;
-    QListWidgetItem* item = new QListWidgetItem(m_listWidget);
-    MessageListItem* widget = new MessageListItem(name, message, QDateTime::currentDateTime());
-    
-    item->setSizeHint(widget->sizeHint());
-    m_listWidget->addItem(item);
-    m_listWidget->setItemWidget(item, widget);
-    m_listWidget->scrollToBottom();
+    const int unread = !isFromMe && !isViewing(portName) ? 1 : 0;
+    m_model->update(portName, message, isFromMe, QDateTime::currentMSecsSinceEpoch(), unread);
+}
+
+/**
+ * @brief 按一批消息更新会话
+ *
+ * @details
+ * 1. 统计批内收到的消息数作为新增未读，正在查看该端口时不计
+ * 2. 以批内最后一条非系统消息更新该行，整批只发出一次dataChanged
+ */
+void MessageListWindow::addMessages(const QString& portName,
+                                    const QVector<ChatMessageModel::Message>& messages)
+{
+    const ChatMessageModel::Message* last = nullptr;
+    int received = 0;
+    for(const ChatMessageModel::Message& message : messages) {
+        if(message.kind == ChatMessageModel::System) {
+            continue;
+        }
+        last = &message;
+        if(message.kind == ChatMessageModel::Received) {
+            received++;
+        }
+    }
+    if(!last) {
+        return;
+    }
+
+    const int unread = isViewing(portName) ? 0 : received;
+    m_model->update(portName, last->text, last->kind == ChatMessageModel::Sent, last->time, unread);
 }
 
 void MessageListWindow::setCurrentPort(const QString& portName)
 {
     m_currentPort = portName;
     m_titleLabel->setText(tr("消息列表 - %1").arg(portName));
-} 
\ No newline at end of file
+    m_model->markRead(portName);
+}
+
+void MessageListWindow::changeEvent(QEvent* event)
+{
+    QWidget::changeEvent(event);
+    // 窗口回到前台时当前端口的消息视为已读
+    if(event->type() == QEvent::ActivationChange && isActiveWindow() && !m_currentPort.isEmpty()) {
+        m_model->markRead(m_currentPort);
+    }
+}
+
+bool MessageListWindow::isViewing(const QString& portName) const
+{
+    return portName == m_currentPort && isActiveWindow();
+}
@@ -2,23 +2,43 @@
 #define MESSAGELISTWINDOW_H
 
 #include <QWidget>
-#include <QListWidget>
+#include <QListView>
 #include <QVBoxLayout>
 #include <QLabel>
 #include <QDateTime>
+#include <QStyledItemDelegate>
+#include "chatmessagemodel.h"
+#include "conversationmodel.h"
 
-class MessageListItem : public QWidget
+/**
+ * @brief 绘制会话行的委托
+ *
+ * 第一行为对端名称和时间，第二行为省略到一行的最后一条消息，有未读时右侧显示红色角标。
+ */
+class ConversationDelegate : public QStyledItemDelegate
 {
     Q_OBJECT
 public:
-    explicit MessageListItem(const QString& name, const QString& message, 
-                           const QDateTime& time, QWidget* parent = nullptr);
+    explicit ConversationDelegate(QObject* parent = nullptr);
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option,
+               const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option,
+                   const QModelIndex& index) const override;
+
 private:
-    QLabel* m_nameLabel;
-    QLabel* m_messageLabel;
-    QLabel* m_timeLabel;
+    static const int ROW_HEIGHT = 60;       ///< 行高
+    static const int PADDING = 8;           ///< 内边距
+    static const int BADGE_HEIGHT = 18;     ///< 未读角标高度
 };
 
+/**
+ * @brief 会话列表
+ *
+ * 每个端口一行，显示最后一条消息、时间和未读数，不保存聊天记录。
+ * 窗口不在前台或消息来自其他端口时，收到的消息计为未读；
+ * 窗口回到前台时清除当前端口的未读，点击一行清除该行的未读。
+ */
 class MessageListWindow : public QWidget
 {
     Q_OBJECT
@@ -26,15 +46,34 @@ public:
     explicit MessageListWindow(QWidget* parent = nullptr);
     
     void addMessage(const QString& portName, const QString& message, bool isFromMe);
+
+    /**
+     * @brief 按一批消息更新会话，系统提示不计入，每批只更新一次该行
+     */
+    void addMessages(const QString& portName, const QVector<ChatMessageModel::Message>& messages);
     void setCurrentPort(const QString& portName);
+
+    /**
+     * @brief 会话模型
+     */
+    ConversationModel* model() const { return m_model; }
+
+protected:
+    void changeEvent(QEvent* event) override;
     
 private:
-    QListWidget* m_listWidget;
+    QListView* m_listView;
+    ConversationModel* m_model;
     QString m_currentPort;
     QLabel* m_titleLabel;
     
     void setupUi();
     void applyStyle();
+
+    /**
+     * @brief 当前是否正在查看该端口的会话
+     */
+    bool isViewing(const QString& portName) const;
 };
 
-#endif // MESSAGELISTWINDOW_H 
\ No newline at end of file
+#endif // MESSAGELISTWINDOW_H 
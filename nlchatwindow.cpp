@@ -3,11 +3,31 @@
 #include "chatbubblewidget.h"
 #include "messagelistwindow.h"
 #include "uilayoutmanager.h"
+#include <QTimer>
+#include <QStandardPaths>
+#include <QDir>
+#include <QDebug>
 
 NLChatWindow::NLChatWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::NLChatWindow)
+    , m_updateStats{}
+    , m_loggedFlushes(0)
+    , m_loggedSegments(0)
+    , m_reconnecting(false)
 {
+    // 收到的消息攒到下一帧再加入界面，每帧只布局和滚动一次
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FLUSH_INTERVAL);
+    connect(m_flushTimer, &QTimer::timeout,
+            this, &NLChatWindow::flushPendingMessages);
+    m_statsTimer = new QTimer(this);
+    m_statsTimer->setInterval(STATS_LOG_INTERVAL);
+    connect(m_statsTimer, &QTimer::timeout,
+            this, &NLChatWindow::logStatistics);
+    m_statsTimer->start();
+
     ui->setupUi(this);
     setupUi();
     initializeSerialManager();
@@ -38,6 +58,21 @@ void NLChatWindow::setupUi()
     
     m_chatDisplay = new ChatBubbleWidget(this);
     m_chatDisplay->setObjectName("chatDisplay");
+
+    // 内存中只保留最近的消息，消息写入缓存目录下的日志，向上滚动时按页读回；
+    // 日志被另一个实例占用时换用下一个文件名
+    m_chatDisplay->model()->setHistoryLimit(HISTORY_MESSAGES, HISTORY_BYTES);
+    const QString historyDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if(!historyDir.isEmpty() && QDir().mkpath(historyDir)) {
+        for(int slot = 1; slot <= HISTORY_FILE_SLOTS; ++slot) {
+            const QString name = slot == 1 ? QStringLiteral("history.log")
+                                           : QString("history-%1.log").arg(slot);
+            if(m_chatDisplay->model()->setHistoryFile(QDir(historyDir).filePath(name),
+                                                      HISTORY_FILE_BYTES)) {
+                break;
+            }
+        }
+    }
     
     m_messageInput = new QTextEdit(this);
     m_messageInput->setMaximumHeight(50);
@@ -80,23 +115,39 @@ void NLChatWindow::setupUi()
 
 void NLChatWindow::initializeSerialManager()
 {
-    m_serialManager = new SerialManager(this);
+    // 串口读写放在独立线程，避免界面重绘或模态对话框推迟读取
+    m_serialManager = new SerialManager(this, true);
     
-    connect(m_serialManager, &SerialManager::messageReceived, 
-            this, &NLChatWindow::handleMessage);
+    connect(m_serialManager, &SerialManager::messagesReceived,
+            this, &NLChatWindow::handleMessages);
     connect(m_serialManager, &SerialManager::errorOccurred,
             this, &NLChatWindow::handleError);
     connect(m_serialManager, &SerialManager::portsChanged,
             this, &NLChatWindow::handlePortsChanged);
     connect(m_serialManager, &SerialManager::connectionStatusChanged,
             this, &NLChatWindow::handleConnectionStatus);
+    connect(m_serialManager, &SerialManager::reconnecting,
+            this, &NLChatWindow::handleReconnecting);
+    connect(m_serialManager, &SerialManager::messageWritten,
+            this, [this](bool success) {
+        if(!success) {
+            appendSystemMessage(tr("消息发送失败"));
+        }
+    });
             
     refreshPortList();
 }
 
 void NLChatWindow::handleConnectButton()
 {
-    if(!m_serialManager->isOpen()) {
+    if(m_reconnecting) {
+        // 重连期间按钮用于取消重连
+        m_serialManager->closePort();
+        m_reconnecting = false;
+        updateConnectionUi(false);
+        appendSystemMessage(tr("已取消重连"));
+        m_messageList->hide();
+    } else if(!m_serialManager->isOpen()) {
         QString selectedPort = m_portList->currentText();
         if(selectedPort.isEmpty()) {
             QMessageBox::warning(this, tr("错误"), 
@@ -104,10 +155,12 @@ void NLChatWindow::handleConnectButton()
             return;
         }
         
+        // 异步打开，等待期间禁用按钮，结果由handleConnectionStatus处理
         if(m_serialManager->openPort(selectedPort)) {
-            appendSystemMessage(tr("已连接到 %1").arg(selectedPort));
-            m_messageList->setCurrentPort(selectedPort);
-            m_messageList->show();  // 连接成功时显示消息列表
+            m_port = selectedPort;
+            m_connectButton->setEnabled(false);
+            m_connectButton->setText(tr("连接中..."));
+            m_portList->setEnabled(false);
         }
     } else {
         m_serialManager->closePort();
@@ -116,8 +169,51 @@ void NLChatWindow::handleConnectButton()
     }
 }
 
+/**
+ * @brief 连接状态变化
+ * 端口取打开时记录的端口名，重连期间端口列表刷新后当前选择可能已经不同
+ */
 void NLChatWindow::handleConnectionStatus(bool connected)
 {
+    if(connected) {
+        appendSystemMessage(m_reconnecting ? tr("已重新连接到 %1").arg(m_port)
+                                           : tr("已连接到 %1").arg(m_port));
+        m_messageList->setCurrentPort(m_port);
+        m_messageList->show();  // 连接成功时显示消息列表
+    }
+    
+    m_reconnecting = false;
+    updateConnectionUi(connected);
+}
+
+void NLChatWindow::handleReconnecting(int attempt, int maxAttempts)
+{
+    // 取消重连之前已经发出的通知在取消之后才到达，以设备的当前状态为准
+    if(!m_serialManager->isReconnecting()) {
+        return;
+    }
+    
+    if(!m_reconnecting) {
+        m_reconnecting = true;
+        appendSystemMessage(tr("%1 已断开，正在自动重连").arg(m_port));
+    }
+    
+    updateConnectionUi(false);
+    m_portList->setEnabled(false);
+    m_refreshButton->setEnabled(false);
+    if(attempt == 0) {
+        m_connectButton->setText(tr("取消重连"));
+    } else if(maxAttempts > 0) {
+        m_connectButton->setText(tr("取消重连 (%1/%2)").arg(attempt).arg(maxAttempts));
+    } else {
+        m_connectButton->setText(tr("取消重连 (%1)").arg(attempt));
+    }
+    m_messageInput->setPlaceholderText(tr("设备已断开，正在重连..."));
+}
+
+void NLChatWindow::updateConnectionUi(bool connected)
+{
+    m_connectButton->setEnabled(true);
     m_connectButton->setText(connected ? tr("断开") : tr("连接"));
     m_portList->setEnabled(!connected);
     m_refreshButton->setEnabled(!connected);
@@ -148,16 +244,25 @@ void NLChatWindow::handleSendButton()
     if(m_serialManager->sendData(message)) {
         appendMessage(message, true);
         m_messageInput->clear();
+    } else {
+        appendSystemMessage(tr("发送队列已满，请稍后重试"));
     }
 }
 
-void NLChatWindow::handleMessage(const QString& message)
+void NLChatWindow::handleMessages(const QStringList& messages)
 {
-    appendMessage(message, false);
+    for(const QString& message : messages) {
+        appendMessage(message, false);
+    }
 }
 
 void NLChatWindow::handleError(const QString& error)
 {
+    // 打开失败或放弃重连后回到未连接状态
+    if(!m_serialManager->isOpen()) {
+        m_reconnecting = false;
+        updateConnectionUi(false);
+    }
     QMessageBox::critical(this, tr("串口错误"), error);
 }
 
@@ -169,8 +274,83 @@ void NLChatWindow::refreshPortList()
 
 void NLChatWindow::appendMessage(const QString& message, bool isFromMe)
 {
-    m_chatDisplay->addMessage(message, isFromMe);
-    m_messageList->addMessage(m_portList->currentText(), message, isFromMe);
+    queueMessage(message, isFromMe ? ChatMessageModel::Sent : ChatMessageModel::Received);
+}
+
+void NLChatWindow::queueMessage(const QString& message, ChatMessageModel::Kind kind)
+{
+    if(m_pendingMessages.isEmpty()) {
+        m_pendingClock.start();
+    }
+    // 时间取到达时刻，而不是刷新时刻
+    m_pendingMessages.append(ChatMessageModel::Message{0, message, QDateTime::currentMSecsSinceEpoch(), kind});
+    if(!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+/**
+ * @brief 刷新等待中的消息
+ *
+ * @details
+ * 1. 取走整批消息，收发消息和系统提示保持到达顺序
+ * 2. 聊天区和消息列表各追加一次，各滚动一次
+ * 3. 记录本批消息数和最早一条消息的等待时间
+ */
+void NLChatWindow::flushPendingMessages()
+{
+    if(m_pendingMessages.isEmpty()) {
+        return;
+    }
+
+    QVector<ChatMessageModel::Message> batch;
+    batch.swap(m_pendingMessages);
+    m_chatDisplay->addMessages(batch);
+    m_messageList->addMessages(m_port, batch);
+
+    const qint64 latencyUs = m_pendingClock.nsecsElapsed() / 1000;
+    m_updateStats.flushes++;
+    m_updateStats.messagesFlushed += batch.size();
+    m_updateStats.lastFlushMessages = batch.size();
+    m_updateStats.maxFlushMessages = qMax(m_updateStats.maxFlushMessages, batch.size());
+    m_updateStats.lastFlushLatencyUs = latencyUs;
+    m_updateStats.maxFlushLatencyUs = qMax(m_updateStats.maxFlushLatencyUs, latencyUs);
+}
+
+void NLChatWindow::logStatistics()
+{
+    if(m_updateStats.flushes != m_loggedFlushes) {
+        m_loggedFlushes = m_updateStats.flushes;
+
+        qDebug() << "UI flushes:" << m_updateStats.flushes
+                 << "messages:" << m_updateStats.messagesFlushed
+                 << "last batch:" << m_updateStats.lastFlushMessages
+                 << "max batch:" << m_updateStats.maxFlushMessages
+                 << "last latency:" << m_updateStats.lastFlushLatencyUs
+                 << "us, max latency:" << m_updateStats.maxFlushLatencyUs << "us";
+    }
+
+    if(!m_serialSettings.reliable) {
+        return;
+    }
+    // 计数与上次输出时不同即有新的收发
+    ReliableLink::Statistics link = m_serialManager->reliableStatistics();
+    qint64 segments = link.segmentsSent + link.acksReceived;
+    if(segments == m_loggedSegments) {
+        return;
+    }
+    m_loggedSegments = segments;
+
+    qDebug() << "Reliable delivered:" << link.messagesDelivered << "/" << link.messagesSent
+             << "failed:" << link.messagesFailed
+             << "goodput:" << qRound64(link.goodput) << "B/s"
+             << "retransmissions:" << link.retransmissions
+             << "fast:" << link.fastRetransmissions
+             << "timeouts:" << link.timeouts
+             << "resyncs:" << link.resyncs
+             << "srtt:" << link.srttUs << "us, rto:" << link.rtoMs << "ms"
+             << "in flight:" << link.inFlight << "/" << link.window
+             << "queued:" << link.queued;
 }
 
 void NLChatWindow::handlePortsChanged()
@@ -194,16 +374,14 @@ void NLChatWindow::handleSettingsButton()
         m_serialSettings = dialog.getSettings();
         // 应用自动滚动设置
         m_chatDisplay->setAutoScroll(m_serialSettings.autoScroll);
-        // 如果串口已经打开，应用新设置
-        if(m_serialManager->isOpen()) {
-            m_serialManager->applySettings(m_serialSettings);
-        }
+        // 端口关闭时设置只被记录，下次打开时生效
+        m_serialManager->applySettings(m_serialSettings);
     }
 }
 
 void NLChatWindow::appendSystemMessage(const QString& message)
 {
-    m_chatDisplay->addSystemMessage(message);
+    queueMessage(message, ChatMessageModel::System);
 }
 
 // 添加事件过滤器处理函数
@@ -12,6 +12,7 @@
 #include <QApplication>
 #include <QScrollBar>
 #include <QKeyEvent>
+#include <QElapsedTimer>
 #include "serialmanager.h"
 #include "serialsettingsdialog.h"
 #include "chatbubblewidget.h"
@@ -26,22 +27,54 @@ class NLChatWindow : public QMainWindow
     Q_OBJECT
 
 public:
+    /**
+     * @brief 界面刷新统计
+     */
+    struct UpdateStatistics {
+        qint64 flushes;                 ///< 刷新次数
+        qint64 messagesFlushed;         ///< 刷新到界面的消息总数
+        int lastFlushMessages;          ///< 最近一次刷新的消息数
+        int maxFlushMessages;           ///< 单次刷新的最大消息数
+        qint64 lastFlushLatencyUs;      ///< 最近一次刷新中最早的消息从到达到显示的耗时(us)
+        qint64 maxFlushLatencyUs;       ///< 上述耗时的最大值(us)
+    };
+
     NLChatWindow(QWidget *parent = nullptr);
     ~NLChatWindow();
 
+    /**
+     * @brief 界面刷新统计
+     */
+    UpdateStatistics updateStatistics() const { return m_updateStats; }
+
 protected:
     bool eventFilter(QObject *obj, QEvent *event) override;
 
 private slots:
     void handleConnectButton();
     void handleSendButton();
-    void handleMessage(const QString& message);
+    void handleMessages(const QStringList& messages);
     void handleError(const QString& error);
     void handlePortsChanged();
     void handleConnectionStatus(bool connected);
+
+    /**
+     * @brief 设备断开后正在自动重连，不弹出对话框，按钮改为取消重连
+     */
+    void handleReconnecting(int attempt, int maxAttempts);
     void refreshPortList();
     void handleSettingsButton();
 
+    /**
+     * @brief 把等待中的消息一次性加入聊天区和消息列表
+     */
+    void flushPendingMessages();
+
+    /**
+     * @brief 输出界面刷新统计和可靠传输统计，自上次输出以来没有刷新或收发时不输出对应的一行
+     */
+    void logStatistics();
+
 private:
     Ui::NLChatWindow *ui;
     SerialManager* m_serialManager;
@@ -57,11 +90,37 @@ private:
     SerialSettingsDialog::Settings m_serialSettings;
     MessageListWindow* m_messageList;
     QPoint m_dragPosition;
+    QTimer* m_flushTimer;                               ///< 界面刷新定时器
+    QVector<ChatMessageModel::Message> m_pendingMessages;   ///< 等待刷新到界面的消息
+    QElapsedTimer m_pendingClock;                       ///< 最早一条等待中的消息到达后的时间
+    UpdateStatistics m_updateStats;                     ///< 界面刷新统计
+    QTimer* m_statsTimer;                               ///< 定期输出界面刷新统计和可靠传输统计
+    qint64 m_loggedFlushes;                             ///< 上次输出统计时的刷新次数
+    qint64 m_loggedSegments;                            ///< 上次输出统计时可靠传输收发的段数
+    QString m_port;                                     ///< 已连接、正在连接或正在重连的端口
+    bool m_reconnecting;                                ///< 设备断开后正在自动重连
+
+    static const int FLUSH_INTERVAL = 16;               ///< 刷新间隔(ms)，约一帧
+    static const int STATS_LOG_INTERVAL = 10000;        ///< 输出统计的周期(ms)
+    static const int HISTORY_MESSAGES = 5000;           ///< 聊天区在内存中保留的消息数
+    static const qint64 HISTORY_BYTES = 16 * 1024 * 1024;   ///< 聊天区在内存中保留的消息字节数
+    static const qint64 HISTORY_FILE_BYTES = 256 * 1024 * 1024; ///< 聊天记录日志占用的磁盘上限
+    static const int HISTORY_FILE_SLOTS = 8;            ///< 同时运行的实例各用一个日志文件，最多尝试的文件数
 
     void setupUi();
     void initializeSerialManager();
     void appendMessage(const QString& message, bool isFromMe);
     void appendSystemMessage(const QString& message);
+
+    /**
+     * @brief 按连接状态启用或禁用控件
+     */
+    void updateConnectionUi(bool connected);
+
+    /**
+     * @brief 把消息放入等待队列，并在一帧后刷新
+     */
+    void queueMessage(const QString& message, ChatMessageModel::Kind kind);
 };
 
 #endif // NLCHATWINDOW_H
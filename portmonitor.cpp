@@ -0,0 +1,186 @@
+#include "portmonitor.h"
+#include "ch34x_qt.h"
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#  include <cstring>
+#  include <unistd.h>
+#  include <sys/socket.h>
+#  include <sys/inotify.h>
+#  include <linux/netlink.h>
+#endif
+
+PortMonitor* PortMonitor::instance()
+{
+    // C++11保证局部静态变量只初始化一次
+    static PortMonitor* monitor = new PortMonitor(QCoreApplication::instance());
+    return monitor;
+}
+
+/**
+ * @brief 构造函数
+ *
+ * @details
+ * 1. 同步枚举一次，保证首次ports()即有结果
+ * 2. 依次尝试netlink、inotify作为事件源
+ * 3. 都不可用时启动轮询定时器
+ */
+PortMonitor::PortMonitor(QObject *parent)
+    : QObject(parent)
+    , m_fd(-1)
+    , m_netlink(false)
+    , m_notifier(nullptr)
+{
+    Q_ASSERT(!QCoreApplication::instance() ||
+             QThread::currentThread() == QCoreApplication::instance()->thread());
+
+    m_ports = CH34xQt::enumeratePorts();
+
+    m_debounceTimer.setSingleShot(true);
+    m_debounceTimer.setInterval(DEBOUNCE_INTERVAL);
+    m_settleTimer.setSingleShot(true);
+    m_settleTimer.setInterval(SETTLE_INTERVAL);
+    m_pollTimer.setInterval(POLL_INTERVAL);
+    connect(&m_debounceTimer, &QTimer::timeout, this, [this]() {
+        refresh();
+        m_settleTimer.start();
+    });
+    connect(&m_settleTimer, &QTimer::timeout, this, &PortMonitor::refresh);
+    connect(&m_pollTimer, &QTimer::timeout, this, &PortMonitor::refresh);
+
+    if(openNetlink() || openInotify()) {
+        m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+        connect(m_notifier, &QSocketNotifier::activated,
+                this, &PortMonitor::handleEvent);
+    } else {
+        m_pollTimer.start();
+    }
+}
+
+PortMonitor::~PortMonitor()
+{
+#ifdef Q_OS_LINUX
+    if(m_fd >= 0) {
+        ::close(m_fd);
+    }
+#endif
+}
+
+QStringList PortMonitor::ports() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_ports;
+}
+
+bool PortMonitor::isEventDriven() const
+{
+    return m_fd >= 0;
+}
+
+void PortMonitor::refresh()
+{
+    const QStringList current = CH34xQt::enumeratePorts();
+    {
+        QMutexLocker locker(&m_mutex);
+        if(current == m_ports) {
+            return;
+        }
+        m_ports = current;
+    }
+    emit portsChanged();
+}
+
+/**
+ * @brief 订阅内核uevent广播
+ * 普通用户即可接收，容器等环境下可能失败
+ */
+bool PortMonitor::openNetlink()
+{
+#ifdef Q_OS_LINUX
+    const int fd = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                            NETLINK_KOBJECT_UEVENT);
+    if(fd < 0) {
+        return false;
+    }
+    sockaddr_nl addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;     // 内核事件组
+    if(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return false;
+    }
+    m_fd = fd;
+    m_netlink = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief 监视/dev下设备节点的创建和删除
+ * sysfs不产生inotify事件，因此只监视/dev
+ */
+bool PortMonitor::openInotify()
+{
+#ifdef Q_OS_LINUX
+    const int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(fd < 0) {
+        return false;
+    }
+    if(::inotify_add_watch(fd, "/dev", IN_CREATE | IN_DELETE) < 0) {
+        ::close(fd);
+        return false;
+    }
+    m_fd = fd;
+    m_netlink = false;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief 处理事件描述符上的数据
+ *
+ * @details
+ * 1. 读空描述符上所有待处理的事件
+ * 2. 只关心tty设备的增删（uevent的devpath含/tty/，或/dev下tty开头的节点）
+ * 3. 有相关事件时重启去抖定时器，插拔产生的一串事件只枚举一次
+ */
+void PortMonitor::handleEvent()
+{
+#ifdef Q_OS_LINUX
+    alignas(inotify_event) char buffer[8192];
+    bool relevant = false;
+    for(;;) {
+        const ssize_t n = ::read(m_fd, buffer, sizeof(buffer) - 1);
+        if(n <= 0) {
+            break;
+        }
+        buffer[n] = '\0';
+
+        if(m_netlink) {
+            // 消息头形如"add@/devices/.../tty/ttyUSB0"，后跟以'\0'分隔的键值对
+            if((std::strncmp(buffer, "add@", 4) == 0 || std::strncmp(buffer, "remove@", 7) == 0) &&
+               std::strstr(buffer, "/tty/") != nullptr) {
+                relevant = true;
+            }
+        } else {
+            for(ssize_t offset = 0; offset < n; ) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                if(event->len > 0 && std::strncmp(event->name, "tty", 3) == 0) {
+                    relevant = true;
+                }
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+        }
+    }
+    if(relevant) {
+        m_debounceTimer.start();
+    }
+#endif
+}
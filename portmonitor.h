@@ -0,0 +1,80 @@
+#ifndef PORTMONITOR_H
+#define PORTMONITOR_H
+
+#include <QObject>
+#include <QStringList>
+#include <QMutex>
+#include <QTimer>
+
+class QSocketNotifier;
+
+/**
+ * @brief 进程级CH34x设备热插拔监视器
+ *
+ * 所有CH34xQt实例共享同一份已过滤的设备列表，避免每个实例各自定时枚举：
+ * - Linux下优先监听内核uevent（netlink），不可用时改为inotify监视/dev，
+ *   收到tty设备的增删事件后去抖再重新枚举，毫秒级发出portsChanged
+ * - 两者都不可用或非Linux平台时退回原来的2秒轮询
+ *
+ * 单例属于主线程，ports()可在任意线程调用。
+ */
+class PortMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 获取单例，首次调用须在主线程
+     */
+    static PortMonitor* instance();
+
+    ~PortMonitor();
+
+    /**
+     * @brief 缓存的CH34x设备列表
+     * @return 串口名称列表
+     */
+    QStringList ports() const;
+
+    /**
+     * @brief 是否使用事件驱动（false表示正在轮询）
+     */
+    bool isEventDriven() const;
+
+    /**
+     * @brief 立即重新枚举设备
+     */
+    void refresh();
+
+signals:
+    /**
+     * @brief 设备列表发生变化
+     */
+    void portsChanged();
+
+private slots:
+    /**
+     * @brief 读取并筛选热插拔事件，相关事件触发去抖定时器
+     */
+    void handleEvent();
+
+private:
+    explicit PortMonitor(QObject *parent = nullptr);
+
+    bool openNetlink();
+    bool openInotify();
+
+    mutable QMutex m_mutex;          ///< 保护m_ports
+    QStringList m_ports;             ///< 缓存的设备列表
+    int m_fd;                        ///< netlink或inotify描述符，-1表示未使用
+    bool m_netlink;                  ///< m_fd是netlink套接字（否则为inotify）
+    QSocketNotifier* m_notifier;     ///< 事件描述符的读通知
+    QTimer m_debounceTimer;          ///< 事件去抖，合并同一次插拔产生的多个事件
+    QTimer m_settleTimer;            ///< 事件后的补充枚举，等待udev完成设备节点处理
+    QTimer m_pollTimer;              ///< 轮询退路
+
+    static const int DEBOUNCE_INTERVAL = 50;     ///< 去抖间隔(ms)
+    static const int SETTLE_INTERVAL = 1000;     ///< 补充枚举延迟(ms)
+    static const int POLL_INTERVAL = 2000;       ///< 轮询间隔(ms)
+};
+
+#endif // PORTMONITOR_H
@@ -0,0 +1,81 @@
+#include "receivebuffer.h"
+#include <cstring>
+
+ReceiveBuffer::ReceiveBuffer()
+    : m_readPos(0)
+    , m_scanPos(0)
+{
+}
+
+/**
+ * @brief 追加数据
+ *
+ * @details
+ * 追加前若读游标已越过存储区的一半，先压缩一次。
+ * 每个字节最多被前移一次，压缩的均摊开销为O(1)。
+ */
+void ReceiveBuffer::append(const char* data, int size)
+{
+    if(size <= 0) {
+        return;
+    }
+
+    if(m_readPos > 0 && m_readPos >= m_buffer.size() / 2) {
+        compact();
+    }
+
+    m_buffer.append(data, size);
+}
+
+void ReceiveBuffer::consume(int count)
+{
+    if(count <= 0) {
+        return;
+    }
+
+    count = qMin(count, size());
+    m_readPos += count;
+    m_scanPos = qMax(0, m_scanPos - count);
+
+    if(m_readPos == m_buffer.size()) {
+        // 全部消费完毕，直接复位游标即可
+        m_buffer.resize(0);
+        m_readPos = 0;
+    }
+}
+
+void ReceiveBuffer::clear()
+{
+    m_buffer.resize(0);
+    m_readPos = 0;
+    m_scanPos = 0;
+}
+
+/**
+ * @brief 缩减容量
+ * 重新分配一块目标容量的存储并拷贝未消费数据，只在空闲时调用
+ */
+void ReceiveBuffer::shrink(int capacity)
+{
+    compact();
+    capacity = qMax(capacity, m_buffer.size());
+    if(m_buffer.capacity() <= capacity) {
+        return;
+    }
+
+    QByteArray smaller;
+    smaller.reserve(capacity);
+    smaller.append(m_buffer);
+    m_buffer.swap(smaller);
+}
+
+void ReceiveBuffer::compact()
+{
+    const int remaining = size();
+    if(remaining > 0) {
+        char* base = m_buffer.data();
+        std::memmove(base, base + m_readPos, remaining);
+    }
+    m_buffer.resize(remaining);
+    m_readPos = 0;
+}
@@ -0,0 +1,87 @@
+#ifndef RECEIVEBUFFER_H
+#define RECEIVEBUFFER_H
+
+#include <QByteArray>
+
+/**
+ * @brief 串口接收缓冲区（读游标 + 惰性压缩）
+ *
+ * 取代"每解析一帧就 mid() 拷贝剩余数据"的做法：
+ * - 已消费的数据只移动读游标，不做拷贝
+ * - 记录上次分隔符扫描停止的位置，新数据到达后从该处继续扫描
+ * - 仅当已消费部分超过缓冲区一半时才整体前移一次
+ *
+ * 因此解析开销与接收字节数成线性关系。
+ */
+class ReceiveBuffer
+{
+public:
+    ReceiveBuffer();
+
+    /**
+     * @brief 追加新接收的数据
+     * @param data 数据指针
+     * @param size 数据长度
+     */
+    void append(const char* data, int size);
+    void append(const QByteArray& data) { append(data.constData(), data.size()); }
+
+    /**
+     * @brief 未消费数据的起始指针
+     */
+    const char* data() const { return m_buffer.constData() + m_readPos; }
+
+    /**
+     * @brief 未消费数据的长度
+     */
+    int size() const { return m_buffer.size() - m_readPos; }
+
+    bool isEmpty() const { return size() == 0; }
+
+    /**
+     * @brief 消费（丢弃）开头的count字节，扫描位置随之前移
+     * @param count 消费字节数
+     */
+    void consume(int count);
+
+    /**
+     * @brief 上次扫描停止的位置（相对于data()）
+     * 在该位置之前已确认不存在分隔符
+     */
+    int scanPos() const { return m_scanPos; }
+    void setScanPos(int pos) { m_scanPos = pos; }
+
+    /**
+     * @brief 清空缓冲区，保留已分配的容量
+     */
+    void clear();
+
+    /**
+     * @brief 预留存储空间
+     * @param size 容量（字节）
+     */
+    void reserve(int size) { m_buffer.reserve(size); }
+
+    /**
+     * @brief 当前已分配的容量
+     */
+    int capacity() const { return m_buffer.capacity(); }
+
+    /**
+     * @brief 释放多余的存储空间，未消费的数据保留
+     * @param capacity 目标容量，不会小于未消费数据的长度
+     */
+    void shrink(int capacity);
+
+private:
+    /**
+     * @brief 将未消费数据前移到存储区开头
+     */
+    void compact();
+
+    QByteArray m_buffer;    ///< 底层存储
+    int m_readPos;          ///< 读游标
+    int m_scanPos;          ///< 扫描游标（相对读游标）
+};
+
+#endif // RECEIVEBUFFER_H
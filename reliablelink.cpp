@@ -0,0 +1,419 @@
+#include "reliablelink.h"
+#include <QtEndian>
+#include <QRandomGenerator>
+#include <cstring>
+
+ReliableLink::ReliableLink(QObject *parent)
+    : QObject(parent)
+    , m_epoch(0)
+    , m_sndUna(0)
+    , m_window(DEFAULT_WINDOW)
+    , m_nextId(1)
+    , m_srtt(0)
+    , m_rttVar(0)
+    , m_rto(INITIAL_RTO)
+    , m_peerEpoch(0)
+    , m_peerEpochValid(false)
+    , m_rcvNext(0)
+    , m_statsStartNs(0)
+{
+    m_retransmitTimer = new QTimer(this);
+    m_retransmitTimer->setSingleShot(true);
+    m_ackTimer = new QTimer(this);
+    m_ackTimer->setSingleShot(true);
+    m_ackTimer->setInterval(0);
+    m_clock.start();
+
+    connect(m_retransmitTimer, &QTimer::timeout,
+            this, &ReliableLink::handleRetransmitTimeout);
+    connect(m_ackTimer, &QTimer::timeout,
+            this, &ReliableLink::sendAck);
+
+    resetStatistics();
+    reset();
+}
+
+void ReliableLink::setWindow(int segments)
+{
+    m_window = qBound(1, segments, int(MAX_WINDOW));
+    fillWindow();
+}
+
+int ReliableLink::window() const
+{
+    return m_window;
+}
+
+/**
+ * @brief 开始新的会话
+ *
+ * @details
+ * 1. 未确认和排队中的消息以失败结束
+ * 2. 选取新的epoch，序号和往返时间估计从头开始
+ * 3. 接收状态一并清除，等对端的下一个数据段重新建立
+ */
+void ReliableLink::reset()
+{
+    failAll();
+
+    newEpoch();
+    m_sndUna = 0;
+    m_srtt = 0;
+    m_rttVar = 0;
+    m_rto = INITIAL_RTO;
+
+    m_peerEpochValid = false;
+    m_rcvNext = 0;
+    m_reorder.clear();
+    m_ackTimer->stop();
+}
+
+void ReliableLink::newEpoch()
+{
+    quint32 epoch = QRandomGenerator::global()->generate();
+    while(epoch == m_epoch) {
+        epoch = QRandomGenerator::global()->generate();
+    }
+    m_epoch = epoch;
+}
+
+/**
+ * @brief 对端丢失了接收状态，重新同步
+ *
+ * @details
+ * 1. 选取新的epoch，对端看到后从序号0重新开始接收
+ * 2. 在途的段按原顺序从序号0重新编号，清除选择确认和发出次数，立即全部重发；
+ *    消息不以失败结束。对端丢失状态前已交付但确认未送达的消息会再交付一次
+ * 3. 往返时间估计保留，链路本身没有变化
+ */
+void ReliableLink::resync()
+{
+    m_stats.resyncs++;
+    newEpoch();
+    m_sndUna = 0;
+    for(int i = 0; i < m_inFlight.size(); ++i) {
+        Segment& segment = m_inFlight[i];
+        segment.transmissions = 0;
+        segment.sacked = false;
+        segment.fastRetransmitted = false;
+        transmitSegment(quint32(i), segment);
+    }
+    if(!m_inFlight.isEmpty()) {
+        restartRetransmitTimer();
+    }
+}
+
+quint32 ReliableLink::send(const QByteArray& payload)
+{
+    if(payload.size() > MAX_PAYLOAD || m_queue.size() >= MAX_QUEUED) {
+        return 0;
+    }
+
+    const quint32 id = m_nextId++;
+    if(m_nextId == 0) {
+        m_nextId = 1;
+    }
+    m_queue.enqueue(qMakePair(id, payload));
+    m_stats.messagesSent++;
+    fillWindow();
+    return id;
+}
+
+void ReliableLink::fillWindow()
+{
+    while(m_inFlight.size() < m_window && !m_queue.isEmpty()) {
+        const QPair<quint32, QByteArray> message = m_queue.dequeue();
+        Segment segment;
+        segment.id = message.first;
+        segment.payload = message.second;
+        segment.sentNs = 0;
+        segment.transmissions = 0;
+        segment.sacked = false;
+        segment.fastRetransmitted = false;
+        m_inFlight.append(segment);
+        transmitSegment(m_sndUna + quint32(m_inFlight.size() - 1), m_inFlight.last());
+    }
+    if(!m_inFlight.isEmpty() && !m_retransmitTimer->isActive()) {
+        restartRetransmitTimer();
+    }
+}
+
+void ReliableLink::transmitSegment(quint32 seq, Segment& segment)
+{
+    QByteArray packet(HEADER_SIZE + segment.payload.size(), Qt::Uninitialized);
+    uchar* header = reinterpret_cast<uchar*>(packet.data());
+    header[0] = DataPacket;
+    qToLittleEndian<quint32>(m_epoch, header + 1);
+    qToLittleEndian<quint32>(seq, header + 5);
+    memcpy(packet.data() + HEADER_SIZE, segment.payload.constData(), segment.payload.size());
+
+    if(segment.transmissions > 0) {
+        m_stats.retransmissions++;
+    }
+    segment.transmissions++;
+    segment.sentNs = m_clock.nsecsElapsed();
+    m_stats.segmentsSent++;
+    emit transmit(packet);
+}
+
+void ReliableLink::handleFrame(const QByteArray& frame, QList<QByteArray>& messages)
+{
+    if(frame.size() < HEADER_SIZE) {
+        return;
+    }
+
+    const uchar* header = reinterpret_cast<const uchar*>(frame.constData());
+    const quint32 epoch = qFromLittleEndian<quint32>(header + 1);
+    const quint32 value = qFromLittleEndian<quint32>(header + 5);
+    switch(header[0]) {
+        case DataPacket:
+            handleData(epoch, value, frame.mid(HEADER_SIZE), messages);
+            break;
+        case AckPacket:
+            if(frame.size() >= HEADER_SIZE + 8) {
+                handleAck(epoch, value, qFromLittleEndian<quint64>(header + HEADER_SIZE));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 处理数据段
+ *
+ * @details
+ * 1. 新的epoch说明对端开始了新会话，接收状态从序号0重新开始
+ * 2. 已交付或已暂存的段计为重复并丢弃；超出窗口上限的段丢弃，等对端重传
+ * 3. 正好是期望的序号时交付，并依次交付暂存区中已连续的段；否则暂存
+ * 4. 无论是否重复都安排一次确认，对端据此得知确认是否丢失
+ */
+void ReliableLink::handleData(quint32 epoch, quint32 seq, const QByteArray& payload,
+                              QList<QByteArray>& messages)
+{
+    if(!m_peerEpochValid || epoch != m_peerEpoch) {
+        m_peerEpoch = epoch;
+        m_peerEpochValid = true;
+        m_rcvNext = 0;
+        m_reorder.clear();
+    }
+
+    const qint32 offset = qint32(seq - m_rcvNext);
+    if(offset < 0 || m_reorder.contains(seq)) {
+        m_stats.duplicatesReceived++;
+    } else if(offset == 0) {
+        messages.append(payload);
+        m_stats.bytesDelivered += payload.size();
+        m_rcvNext++;
+        while(!m_reorder.isEmpty()) {
+            auto it = m_reorder.find(m_rcvNext);
+            if(it == m_reorder.end()) {
+                break;
+            }
+            messages.append(it.value());
+            m_stats.bytesDelivered += it.value().size();
+            m_reorder.erase(it);
+            m_rcvNext++;
+        }
+    } else if(offset <= MAX_WINDOW) {
+        m_reorder.insert(seq, payload);
+        m_stats.outOfOrderReceived++;
+    }
+
+    if(!m_ackTimer->isActive()) {
+        m_ackTimer->start();
+    }
+}
+
+void ReliableLink::sendAck()
+{
+    if(!m_peerEpochValid) {
+        return;
+    }
+
+    quint64 sack = 0;
+    for(int i = 0; i < 64 && !m_reorder.isEmpty(); ++i) {
+        if(m_reorder.contains(m_rcvNext + 1 + quint32(i))) {
+            sack |= quint64(1) << i;
+        }
+    }
+
+    QByteArray packet(HEADER_SIZE + 8, Qt::Uninitialized);
+    uchar* header = reinterpret_cast<uchar*>(packet.data());
+    header[0] = AckPacket;
+    qToLittleEndian<quint32>(m_peerEpoch, header + 1);
+    qToLittleEndian<quint32>(m_rcvNext, header + 5);
+    qToLittleEndian<quint64>(sack, header + HEADER_SIZE);
+    m_stats.acksSent++;
+    emit transmit(packet);
+}
+
+/**
+ * @brief 处理确认
+ *
+ * @details
+ * 1. 不是本会话的确认丢弃；同一会话的累计确认不会倒退（链路不改变帧的顺序），
+ *    倒退说明对端重启或重置后丢失了接收状态，立即重新同步，不等重传次数用尽
+ * 2. 累计确认之前的段全部完成，用其中未重传过的最新一段更新往返时间估计
+ * 3. 按SACK位图标记已收到的段；某个未确认段之后已有DUP_THRESHOLD个段到达时
+ *    视为丢失，立即重传一次
+ * 4. 窗口前移后补充新段，有进展时重启重传定时器
+ */
+void ReliableLink::handleAck(quint32 epoch, quint32 cumAck, quint64 sack)
+{
+    if(epoch != m_epoch) {
+        return;
+    }
+    const qint32 advance = qint32(cumAck - m_sndUna);
+    if(advance < 0) {
+        resync();
+        return;
+    }
+    if(advance > m_inFlight.size()) {
+        return;
+    }
+    m_stats.acksReceived++;
+
+    const qint64 now = m_clock.nsecsElapsed();
+    qint64 rttSample = -1;
+    QList<quint32> acked;
+    for(int i = 0; i < advance; ++i) {
+        const Segment segment = m_inFlight.takeFirst();
+        if(segment.transmissions == 1) {
+            rttSample = now - segment.sentNs;
+        }
+        m_stats.messagesDelivered++;
+        m_stats.bytesAcked += segment.payload.size();
+        acked.append(segment.id);
+    }
+    m_sndUna = cumAck;
+    if(rttSample >= 0) {
+        updateRtt(rttSample);
+    }
+
+    // 位图第i位对应序号cumAck+1+i，即m_inFlight[i+1]
+    for(int i = 0; i < 64 && i + 1 < m_inFlight.size(); ++i) {
+        if((sack >> i) & 1) {
+            m_inFlight[i + 1].sacked = true;
+        }
+    }
+    int sackedAbove = 0;
+    for(int i = m_inFlight.size() - 1; i >= 0; --i) {
+        Segment& segment = m_inFlight[i];
+        if(segment.sacked) {
+            sackedAbove++;
+        } else if(sackedAbove >= DUP_THRESHOLD && !segment.fastRetransmitted) {
+            segment.fastRetransmitted = true;
+            m_stats.fastRetransmissions++;
+            transmitSegment(m_sndUna + quint32(i), segment);
+        }
+    }
+
+    if(m_inFlight.isEmpty()) {
+        m_retransmitTimer->stop();
+    } else if(advance > 0) {
+        restartRetransmitTimer();
+    }
+    fillWindow();
+
+    // 状态更新完再通知，接收方可以在槽中直接发送下一条消息
+    for(quint32 id : acked) {
+        emit delivered(id, true);
+    }
+}
+
+/**
+ * @brief 按RFC 6298更新往返时间估计
+ * 第一个样本R：SRTT=R，RTTVAR=R/2；之后RTTVAR=3/4·RTTVAR+1/4·|SRTT-R|，
+ * SRTT=7/8·SRTT+1/8·R；RTO=SRTT+max(G,4·RTTVAR)，G取1ms，再限制在MIN_RTO到MAX_RTO之间
+ */
+void ReliableLink::updateRtt(qint64 sampleNs)
+{
+    if(m_srtt == 0) {
+        m_srtt = qMax<qint64>(sampleNs, 1);
+        m_rttVar = sampleNs / 2;
+    } else {
+        m_rttVar = (3 * m_rttVar + qAbs(m_srtt - sampleNs)) / 4;
+        m_srtt = (7 * m_srtt + sampleNs) / 8;
+    }
+    const qint64 rtoNs = m_srtt + qMax<qint64>(1000000, 4 * m_rttVar);
+    m_rto = static_cast<int>(qBound<qint64>(MIN_RTO, (rtoNs + 999999) / 1000000, MAX_RTO));
+}
+
+void ReliableLink::restartRetransmitTimer()
+{
+    m_retransmitTimer->start(m_rto);
+}
+
+/**
+ * @brief 重传定时器到期
+ *
+ * @details
+ * 1. 超时加倍，不超过MAX_RTO
+ * 2. 重传最早的未被选择确认的段
+ * 3. 该段已发出MAX_TRANSMISSIONS次时认为链路不通，放弃全部消息并开始新会话，
+ *    否则对端会一直等待这个空洞
+ */
+void ReliableLink::handleRetransmitTimeout()
+{
+    if(m_inFlight.isEmpty()) {
+        return;
+    }
+    m_stats.timeouts++;
+    m_rto = qMin(m_rto * 2, int(MAX_RTO));
+
+    for(int i = 0; i < m_inFlight.size(); ++i) {
+        Segment& segment = m_inFlight[i];
+        if(segment.sacked) {
+            continue;
+        }
+        if(segment.transmissions >= MAX_TRANSMISSIONS) {
+            reset();
+            return;
+        }
+        // 超时后允许同一段再次快速重传
+        segment.fastRetransmitted = false;
+        transmitSegment(m_sndUna + quint32(i), segment);
+        break;
+    }
+    restartRetransmitTimer();
+}
+
+void ReliableLink::failAll()
+{
+    m_retransmitTimer->stop();
+    QList<quint32> failed;
+    for(const Segment& segment : m_inFlight) {
+        failed.append(segment.id);
+    }
+    while(!m_queue.isEmpty()) {
+        failed.append(m_queue.dequeue().first);
+    }
+    m_inFlight.clear();
+
+    m_stats.messagesFailed += failed.size();
+    for(quint32 id : failed) {
+        emit delivered(id, false);
+    }
+}
+
+ReliableLink::Statistics ReliableLink::statistics() const
+{
+    Statistics stats = m_stats;
+    const double seconds = (m_clock.nsecsElapsed() - m_statsStartNs) / 1e9;
+    stats.goodput = seconds > 0 ? m_stats.bytesAcked / seconds : 0;
+    stats.srttUs = m_srtt / 1000;
+    stats.rttVarUs = m_rttVar / 1000;
+    stats.rtoMs = m_rto;
+    stats.inFlight = m_inFlight.size();
+    stats.queued = m_queue.size();
+    stats.window = m_window;
+    return stats;
+}
+
+void ReliableLink::resetStatistics()
+{
+    // 值初始化，全部字段清零
+    m_stats = Statistics();
+    m_statsStartNs = m_clock.nsecsElapsed();
+}
@@ -0,0 +1,210 @@
+#ifndef RELIABLELINK_H
+#define RELIABLELINK_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <QHash>
+#include <QQueue>
+#include <QPair>
+#include <QTimer>
+#include <QElapsedTimer>
+
+/**
+ * @brief 可靠消息层
+ *
+ * 位于SerialManager与CH34xQt之间，在有损的星闪无线链路上为聊天消息提供确认送达：
+ * - 每条消息一个32位序号，接收端按序交付，重复的段直接丢弃
+ * - 确认为累计确认加选择确认（SACK）位图，乱序到达的段先暂存，补齐后一并交付
+ * - 滑动窗口允许多条消息同时在途，不必每条等一个往返
+ * - 重传超时按RFC 6298由往返时间估计，超时后指数退避；重传过的段不参与估计（Karn算法）
+ * - SACK显示某段之后已有DUP_THRESHOLD个段到达时立即重传该段（快速重传）
+ *
+ * 数据段和确认都作为CH34xQt的二进制帧在CHANNEL通道上传输，帧本身已带CRC，
+ * 损坏的帧在分帧时即被丢弃，这里只需处理丢失、重复和乱序。帧格式（小端）：
+ * - 数据段：| 01 | epoch(4) | seq(4) | 负载 |
+ * - 确认：  | 02 | epoch(4) | cumAck(4) | sack(8) |
+ *   cumAck为期望收到的下一个序号，sack第i位表示cumAck+1+i已收到
+ *
+ * epoch是发送端每次reset()时随机选取的会话号，确认回显数据段的epoch。
+ * 接收端看到新的epoch即从序号0重新开始；接收端重启或重置后会对旧会话的段回复
+ * 倒退的累计确认，发送端据此换新的epoch，把在途的段从序号0重发。
+ * 因此任一端重启或放弃重传后双方都能重新同步。
+ *
+ * 对象不是线程安全的，须在所属线程使用；发出的帧通过transmit信号交给设备。
+ */
+class ReliableLink : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 统计信息
+     */
+    struct Statistics {
+        qint64 messagesSent;        ///< 已接受发送的消息数
+        qint64 messagesDelivered;   ///< 已被对端确认的消息数
+        qint64 messagesFailed;      ///< 重传次数用尽或链路重置而放弃的消息数
+        qint64 segmentsSent;        ///< 发出的数据段数，含重传
+        qint64 retransmissions;     ///< 重传的数据段数，含快速重传
+        qint64 fastRetransmissions; ///< 由SACK触发的快速重传数
+        qint64 timeouts;            ///< 重传定时器超时次数
+        qint64 acksSent;            ///< 发出的确认数
+        qint64 acksReceived;        ///< 收到的有效确认数
+        qint64 duplicatesReceived;  ///< 重复收到而丢弃的数据段数
+        qint64 outOfOrderReceived;  ///< 乱序到达、暂存等待补齐的数据段数
+        qint64 resyncs;             ///< 因对端丢失接收状态而重新同步的次数
+        qint64 bytesDelivered;      ///< 按序交付给上层的负载字节数
+        qint64 bytesAcked;          ///< 被对端确认的负载字节数
+        double goodput;             ///< 自上次重置以来被确认的负载速率(字节/秒)
+        qint64 srttUs;              ///< 平滑往返时间(us)，尚无样本时为0
+        qint64 rttVarUs;            ///< 往返时间偏差(us)
+        int rtoMs;                  ///< 当前重传超时(ms)
+        int inFlight;               ///< 已发出未确认的段数
+        int queued;                 ///< 等待窗口的消息数
+        int window;                 ///< 窗口大小（段数）
+    };
+
+    static const quint8 CHANNEL = 1;            ///< 使用的二进制帧通道
+    static const int DEFAULT_WINDOW = 16;       ///< 默认窗口大小
+    static const int MAX_WINDOW = 64;           ///< 窗口上限，受SACK位图宽度限制
+    static const int MAX_QUEUED = 1024;         ///< 等待窗口的消息数上限
+    static const int HEADER_SIZE = 9;           ///< 数据段头长度
+    static const int MAX_PAYLOAD = 0xFFFF - HEADER_SIZE;    ///< 单条消息最大长度
+
+    explicit ReliableLink(QObject *parent = nullptr);
+
+    /**
+     * @brief 设置窗口大小
+     * @param segments 同时在途的最大段数，限制在1到MAX_WINDOW之间
+     */
+    void setWindow(int segments);
+    int window() const;
+
+    /**
+     * @brief 开始新的会话
+     * 选取新的epoch，序号从0开始，未确认和排队中的消息全部以失败结束
+     */
+    void reset();
+
+    /**
+     * @brief 发送一条消息
+     * 窗口未满时立即发出，否则排队
+     * @return 消息编号，消息过长或队列已满时返回0
+     */
+    quint32 send(const QByteArray& payload);
+
+    /**
+     * @brief 处理一个从CHANNEL通道收到的帧
+     * @param frame 帧负载
+     * @param messages 按序交付的消息追加在末尾
+     */
+    void handleFrame(const QByteArray& frame, QList<QByteArray>& messages);
+
+    /**
+     * @brief 统计快照
+     */
+    Statistics statistics() const;
+
+    /**
+     * @brief 清零计数器，不影响会话状态
+     */
+    void resetStatistics();
+
+signals:
+    /**
+     * @brief 需要发出一个帧，由连接方写入CHANNEL通道
+     */
+    void transmit(const QByteArray& packet);
+
+    /**
+     * @brief 消息结束
+     * @param id send()返回的编号
+     * @param success 是否已被对端确认
+     */
+    void delivered(quint32 id, bool success);
+
+private slots:
+    /**
+     * @brief 重传定时器到期，重传最早的未确认段并退避
+     */
+    void handleRetransmitTimeout();
+
+    /**
+     * @brief 发出累计确认和SACK位图
+     * 同一批帧只确认一次
+     */
+    void sendAck();
+
+private:
+    /**
+     * @brief 在途的数据段
+     */
+    struct Segment {
+        quint32 id;                 ///< 消息编号
+        QByteArray payload;         ///< 负载
+        qint64 sentNs;              ///< 最近一次发出的时刻
+        int transmissions;          ///< 发出次数
+        bool sacked;                ///< 已被选择确认
+        bool fastRetransmitted;     ///< 已快速重传过
+    };
+
+    enum PacketType {
+        DataPacket = 0x01,
+        AckPacket = 0x02
+    };
+
+    void transmitSegment(quint32 seq, Segment& segment);
+    void handleData(quint32 epoch, quint32 seq, const QByteArray& payload, QList<QByteArray>& messages);
+    void handleAck(quint32 epoch, quint32 cumAck, quint64 sack);
+    void fillWindow();
+
+    /**
+     * @brief 选取与当前不同的随机epoch
+     */
+    void newEpoch();
+
+    /**
+     * @brief 对端丢失了接收状态，换新的epoch把在途的段从序号0重发
+     */
+    void resync();
+    void updateRtt(qint64 sampleNs);
+    void restartRetransmitTimer();
+
+    /**
+     * @brief 以失败结束所有未确认和排队的消息
+     */
+    void failAll();
+
+    // 发送端
+    quint32 m_epoch;                    ///< 本端会话号
+    quint32 m_sndUna;                   ///< 最早的未确认序号，即m_inFlight[0]的序号
+    QList<Segment> m_inFlight;          ///< 已发出未确认的段，第i个的序号为m_sndUna+i
+    QQueue<QPair<quint32, QByteArray>> m_queue;     ///< 等待窗口的消息
+    int m_window;                       ///< 窗口大小
+    quint32 m_nextId;                   ///< 下一个消息编号
+    QTimer* m_retransmitTimer;          ///< 重传定时器，只跟踪最早的未确认段
+
+    // 往返时间估计(ns)
+    qint64 m_srtt;                      ///< 平滑往返时间，0表示尚无样本
+    qint64 m_rttVar;                    ///< 往返时间偏差
+    int m_rto;                          ///< 重传超时(ms)
+
+    // 接收端
+    quint32 m_peerEpoch;                ///< 对端会话号
+    bool m_peerEpochValid;              ///< 是否已收到过数据段
+    quint32 m_rcvNext;                  ///< 期望收到的下一个序号
+    QHash<quint32, QByteArray> m_reorder;   ///< 乱序到达、等待交付的段
+    QTimer* m_ackTimer;                 ///< 延迟到本批帧处理完再确认
+
+    QElapsedTimer m_clock;              ///< 单调时钟
+    qint64 m_statsStartNs;              ///< 统计开始时刻
+    Statistics m_stats;                 ///< 计数器，快照时补充派生字段
+
+    static const int INITIAL_RTO = 1000;    ///< 尚无样本时的重传超时(ms)
+    static const int MIN_RTO = 100;         ///< 重传超时下限(ms)
+    static const int MAX_RTO = 10000;       ///< 重传超时上限(ms)
+    static const int MAX_TRANSMISSIONS = 8; ///< 单段最多发出次数，超过即放弃并重置会话
+    static const int DUP_THRESHOLD = 3;     ///< 触发快速重传的后续到达段数
+};
+
+#endif // RELIABLELINK_H
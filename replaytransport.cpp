@@ -0,0 +1,203 @@
+#include "replaytransport.h"
+#include <QTimer>
+#include <QFileInfo>
+
+ReplayTransport::ReplayTransport(QObject *parent)
+    : SerialTransport(parent)
+    , m_hasRecord(false)
+    , m_firstTimestamp(0)
+    , m_speed(1)
+    , m_readBufferSize(0)
+    , m_pendingWritten(0)
+    , m_replayedBytes(0)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout,
+            this, &ReplayTransport::deliver);
+}
+
+ReplayTransport::~ReplayTransport()
+{
+    close();
+}
+
+/**
+ * @brief 打开捕获文件
+ *
+ * @details
+ * 1. 端口名中最后一个@之后为速度（正数或max），否则整个地址都是路径
+ * 2. 文件不存在时报告DeviceNotFoundError，格式不符报告OpenError
+ * 3. 第一次交付在事件循环中进行，打开后的清理不会丢掉回放数据
+ */
+bool ReplayTransport::open()
+{
+    QString path = address();
+    m_speed = 1;
+    const int at = path.lastIndexOf(QLatin1Char('@'));
+    if(at >= 0) {
+        const QString suffix = path.mid(at + 1);
+        bool ok = false;
+        const double speed = suffix.toDouble(&ok);
+        if(suffix.compare(QLatin1String("max"), Qt::CaseInsensitive) == 0) {
+            m_speed = 0;
+            path.truncate(at);
+        } else if(ok && speed > 0) {
+            m_speed = speed;
+            path.truncate(at);
+        }
+    }
+
+    if(!QFileInfo::exists(path)) {
+        setError(QSerialPort::DeviceNotFoundError, tr("捕获文件 %1 不存在").arg(path));
+        return false;
+    }
+    if(!m_reader.open(path)) {
+        setError(QSerialPort::OpenError, m_reader.errorString());
+        return false;
+    }
+
+    m_readBuffer.clear();
+    m_pendingWritten = 0;
+    m_replayedBytes = 0;
+    m_hasRecord = nextReceived();
+    m_firstTimestamp = m_hasRecord ? m_record.timestamp : 0;
+    m_clock.start();
+    m_timer->start(0);
+    return true;
+}
+
+void ReplayTransport::close()
+{
+    m_timer->stop();
+    m_reader.close();
+    m_hasRecord = false;
+    m_readBuffer.clear();
+    m_pendingWritten = 0;
+}
+
+bool ReplayTransport::isOpen() const
+{
+    return m_reader.isOpen();
+}
+
+QByteArray ReplayTransport::readAll()
+{
+    QByteArray data;
+    data.swap(m_readBuffer);
+    if(m_hasRecord && !m_timer->isActive()) {
+        m_timer->start(0);
+    }
+    return data;
+}
+
+qint64 ReplayTransport::bytesAvailable() const
+{
+    return m_readBuffer.size();
+}
+
+qint64 ReplayTransport::write(const char* data, qint64 size)
+{
+    Q_UNUSED(data);
+    if(!isOpen()) {
+        return -1;
+    }
+
+    // 与真实设备一样在事件循环中报告写出
+    if(m_pendingWritten == 0) {
+        QMetaObject::invokeMethod(this, [this]() {
+            const qint64 written = m_pendingWritten;
+            m_pendingWritten = 0;
+            if(written > 0) {
+                emit bytesWritten(written);
+            }
+        }, Qt::QueuedConnection);
+    }
+    m_pendingWritten += size;
+    return size;
+}
+
+qint64 ReplayTransport::bytesToWrite() const
+{
+    return m_pendingWritten;
+}
+
+void ReplayTransport::setReadBufferSize(qint64 size)
+{
+    m_readBufferSize = size;
+    if(isOpen() && m_hasRecord && !m_timer->isActive()) {
+        m_timer->start(0);
+    }
+}
+
+bool ReplayTransport::clear(QSerialPort::Directions directions)
+{
+    if(directions & QSerialPort::Input) {
+        m_readBuffer.clear();
+    }
+    if(directions & QSerialPort::Output) {
+        m_pendingWritten = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief 交付记录
+ *
+ * @details
+ * 1. 读缓冲已满时等待readAll()
+ * 2. 按速度换算每条记录的到期时刻，到期的记录追加到读缓冲，未到期则定时后返回
+ * 3. 不等待时每次只交付一条记录，下一条在下一轮事件循环中交付
+ * 4. 有新数据时发出一次readyRead，全部交付后发出finished
+ */
+void ReplayTransport::deliver()
+{
+    if(!isOpen()) {
+        return;
+    }
+
+    bool delivered = false;
+    while(m_hasRecord) {
+        if(m_readBufferSize > 0 && m_readBuffer.size() >= m_readBufferSize) {
+            break;
+        }
+        if(m_speed > 0) {
+            const qint64 dueNs = qint64((m_record.timestamp - m_firstTimestamp) / m_speed);
+            const qint64 waitNs = dueNs - m_clock.nsecsElapsed();
+            if(waitNs > 0) {
+                m_timer->start(int((waitNs + 999999) / 1000000));
+                break;
+            }
+        }
+
+        m_readBuffer.append(m_record.data, m_record.size);
+        m_replayedBytes += m_record.size;
+        delivered = true;
+        m_hasRecord = nextReceived();
+        if(m_speed <= 0) {
+            if(m_hasRecord) {
+                m_timer->start(0);
+            }
+            break;
+        }
+    }
+
+    if(delivered) {
+        emit readyRead();
+    }
+    // 没有记录时只会由open()或最后一次交付调用到这里，finished只发出一次
+    if(!m_hasRecord && isOpen()) {
+        emit finished();
+    }
+}
+
+bool ReplayTransport::nextReceived()
+{
+    while(m_reader.next(m_record)) {
+        if(m_record.direction == CaptureRecord::Received) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,86 @@
+#ifndef REPLAYTRANSPORT_H
+#define REPLAYTRANSPORT_H
+
+#include "serialtransport.h"
+#include "capturelog.h"
+#include <QElapsedTimer>
+
+class QTimer;
+
+/**
+ * @brief 回放捕获文件的传输层
+ *
+ * 端口名为"replay:路径[@速度]"，把CaptureWriter记录的接收数据按原来的分块重新交给CH34xQt，
+ * 经过完整的分帧、解码和界面路径，可用作解析器和界面的性能回归输入：
+ * - 速度为正数时按记录的时间间隔除以速度交付，默认1即原速；
+ *   同一时刻已到期的记录合并为一次readyRead，与内核攒批的行为一致
+ * - 速度为max时不等待，每条记录一次readyRead，保留原始的读取分块；
+ *   此时没有空闲间隔，GapFraming会把相邻的帧连在一起
+ * 读缓冲达到上限时暂停交付，直到数据被取走。发送方向的记录不回放，
+ * 写入的数据直接丢弃并报告已写出。回放到末尾后保持打开并发出finished。
+ */
+class ReplayTransport : public SerialTransport
+{
+    Q_OBJECT
+public:
+    explicit ReplayTransport(QObject *parent = nullptr);
+    ~ReplayTransport();
+
+    Kind kind() const override { return ReplayKind; }
+
+    /**
+     * @brief 打开端口名中的捕获文件，文件不存在时报告DeviceNotFoundError
+     */
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+
+    QByteArray readAll() override;
+    qint64 bytesAvailable() const override;
+    qint64 write(const char* data, qint64 size) override;
+    qint64 bytesToWrite() const override;
+    void setReadBufferSize(qint64 size) override;
+    bool clear(QSerialPort::Directions directions = QSerialPort::AllDirections) override;
+
+    /**
+     * @brief 回放速度，0表示不等待
+     */
+    double speed() const { return m_speed; }
+
+    /**
+     * @brief 已交付的接收数据字节数
+     */
+    qint64 replayedBytes() const { return m_replayedBytes; }
+
+signals:
+    /**
+     * @brief 所有接收记录都已交付
+     */
+    void finished();
+
+private slots:
+    /**
+     * @brief 交付已到期的记录，并为下一条记录定时
+     */
+    void deliver();
+
+private:
+    /**
+     * @brief 读取下一条接收方向的记录
+     */
+    bool nextReceived();
+
+    CaptureReader m_reader;         ///< 捕获文件
+    CaptureRecord m_record;         ///< 下一条待交付的记录
+    bool m_hasRecord;               ///< m_record是否有效
+    qint64 m_firstTimestamp;        ///< 第一条接收记录的时间戳，回放从它开始计时
+    double m_speed;                 ///< 回放速度，0表示不等待
+    QElapsedTimer m_clock;          ///< 回放开始后的时间
+    QTimer* m_timer;                ///< 下一条记录到期的定时器
+    QByteArray m_readBuffer;        ///< 已交付未取走的数据
+    qint64 m_readBufferSize;        ///< 读缓冲上限，0表示不限
+    qint64 m_pendingWritten;        ///< 尚未报告写出的字节数
+    qint64 m_replayedBytes;         ///< 已交付的接收数据字节数
+};
+
+#endif // REPLAYTRANSPORT_H
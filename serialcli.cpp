@@ -1,15 +1,76 @@
 #include "serialcli.h"
+#include "serialtransport.h"
+#include "filetransfer.h"
 #include <QCoreApplication>
 #include <QTextStream>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
 
-SerialCLI::SerialCLI(QObject *parent) : QObject(parent)
+SerialCLI::SerialCLI(QObject *parent)
+    : QObject(parent)
+    , m_device(nullptr)
+    , m_pendingWriteId(0)
+    , m_transfer(nullptr)
+    , m_exitCode(0)
+    , m_output(stdout)
+    , m_errorOutput(stderr)
 {
-    m_device = new CH34xQt(this);
-    
-    connect(m_device, &CH34xQt::dataReceived,
-            this, &SerialCLI::handleReceived);
-    connect(m_device, &CH34xQt::errorOccurred,
-            this, &SerialCLI::handleError);
+}
+
+CH34xQt* SerialCLI::device()
+{
+    if(!m_device) {
+        m_device = new CH34xQt(this);
+        
+        connect(m_device, &CH34xQt::framesReceived,
+                this, &SerialCLI::handleFramesReceived);
+        connect(m_device, &CH34xQt::errorOccurred,
+                this, &SerialCLI::handleError);
+        connect(m_device, &CH34xQt::writeCompleted,
+                this, &SerialCLI::handleWriteCompleted);
+        connect(m_device, &CH34xQt::reconnecting,
+                this, [this](int attempt, int) {
+            if(attempt == 0) {
+                QTextStream err(m_errorOutput);
+                err << "设备已断开连接，正在自动重连\n";
+                err.flush();
+            }
+        });
+    }
+    return m_device;
+}
+
+FILE* SerialCLI::stdioTextOutput()
+{
+#ifdef Q_OS_UNIX
+    // 从同一终端继承的描述符共享非阻塞标志，重新打开得到独立的打开文件
+    if(::isatty(STDERR_FILENO)) {
+        const char* name = ::ttyname(STDERR_FILENO);
+        FILE* tty = name ? std::fopen(name, "w") : nullptr;
+        if(tty) {
+            return tty;
+        }
+    }
+#endif
+    return stderr;
+}
+
+FileTransfer* SerialCLI::transfer()
+{
+    if(!m_transfer) {
+        m_transfer = new FileTransfer(this);
+        
+        connect(m_transfer, &FileTransfer::transmit,
+                this, [this](const QByteArray& packet) {
+            device()->queueWrite(packet, FileTransfer::CHANNEL);
+        });
+        connect(m_transfer, &FileTransfer::progress,
+                this, &SerialCLI::handleFileProgress);
+        connect(m_transfer, &FileTransfer::finished,
+                this, &SerialCLI::handleFileFinished);
+    }
+    return m_transfer;
 }
 
 void SerialCLI::setupOptions(QCommandLineParser& parser)
@@ -22,13 +83,22 @@ void SerialCLI::setupOptions(QCommandLineParser& parser)
     
     parser.addOptions({
         {{"l", "list"}, "列出可用的CH34x设备"},
-        {{"p", "port"}, "指定要操作的串口", "portname"},
+        {{"p", "port"}, "指定要操作的串口，也可以是pty:[链接路径]、unix:套接字路径、stdio:"
+                        "或replay:捕获文件[@速度|@max]", "portname"},
         {{"b", "baud"}, "设置波特率", "baudrate", "115200"},
         {{"d", "data"}, "设置数据位 (5-8)", "databits", "8"},
         {{"s", "stop"}, "设置停止位 (1,2)", "stopbits", "1"},
         {{"y", "parity"}, "设置校验位 (none,odd,even)", "parity", "none"},
         {{"f", "flow"}, "设置流控 (none,hard,soft)", "flow", "none"},
+        {"framing", "设置分帧方式 (line,binary,binary32,gap)", "framing", "line"},
+        {"gap", "gap分帧的帧间空闲时间(ms)", "msec", "50"},
+        {"low-latency", "低延迟模式，以CPU占用换取更低的接收延迟"},
+        {"io-cpu", "低延迟模式下绑定到指定CPU", "cpu", "-1"},
+        {"io-priority", "低延迟模式下的SCHED_FIFO优先级(1-99)", "priority", "0"},
+        {"capture", "把原始收发数据连同时间戳记录到捕获文件，可用replay:端口回放", "file"},
         {{"w", "write"}, "发送数据", "data"},
+        {"send-file", "发送文件，对端用--recv-file接收（使用二进制分帧）", "file"},
+        {"recv-file", "接收一个文件，保存到指定目录或路径，中断后可续传（使用二进制分帧）", "path"},
         {{"r", "read"}, "持续读取数据"},
         {"status", "显示设备状态"}
     });
@@ -44,7 +114,7 @@ bool SerialCLI::handleCommands(QCommandLineParser& parser)
     
     // 打开设备
     if(parser.isSet("port")) {
-        CH34xQt::SerialConfig config;
+        CH34xQt::SerialConfig config = device()->currentConfig();
         config.portName = parser.value("port");
         config.baudRate = parser.value("baud").toInt();
         
@@ -84,12 +154,64 @@ bool SerialCLI::handleCommands(QCommandLineParser& parser)
             config.flowControl = QSerialPort::NoFlowControl;
         }
         
+        // 设置分帧方式
+        QString framing = parser.value("framing").toLower();
+        if(framing.startsWith("binary")) {
+            config.framing = CH34xQt::BinaryFraming;
+            config.binaryCrc32 = (framing == "binary32");
+        } else if(framing == "gap") {
+            config.framing = CH34xQt::GapFraming;
+            config.frameGap = qMax(1, parser.value("gap").toInt());
+        } else {
+            config.framing = CH34xQt::LineFraming;
+        }
+        
+        // 文件按块以二进制帧传输
+        if(parser.isSet("send-file") || parser.isSet("recv-file")) {
+            config.framing = CH34xQt::BinaryFraming;
+        }
+        
+        // 设置低延迟模式
+        config.lowLatency = parser.isSet("low-latency");
+        config.ioThreadCpu = parser.value("io-cpu").toInt();
+        config.ioThreadPriority = parser.value("io-priority").toInt();
+        
+        // 设置捕获文件
+        config.capturePath = parser.value("capture");
+        
+        // stdio:的标准输出用于收发数据，提示和收到的文本都不能写入其中
+        if(SerialTransport::kindForPort(config.portName) == SerialTransport::StdioKind) {
+            m_output = stdioTextOutput();
+            m_errorOutput = m_output;
+        }
+        
         openPort(config.portName, config);
         
         // 发送数据
         if(parser.isSet("write")) {
-            sendData(parser.value("write"));
-            return true;
+            // 入队成功后保持事件循环运行，写出完成时再退出
+            if(!sendData(parser.value("write"))) {
+                m_exitCode = 1;
+                return true;
+            }
+            return false;
+        }
+        
+        // 发送文件
+        if(parser.isSet("send-file")) {
+            if(!transfer()->sendFile(parser.value("send-file"))) {
+                QTextStream out(m_output);
+                out << "无法打开文件 " << parser.value("send-file") << "\n";
+                m_exitCode = 1;
+                return true;
+            }
+            return false;  // 传输结束时退出
+        }
+        
+        // 接收文件
+        if(parser.isSet("recv-file")) {
+            transfer()->setReceiveTarget(parser.value("recv-file"));
+            return false;  // 收完一个文件时退出
         }
         
         // 持续读取
@@ -110,25 +232,29 @@ bool SerialCLI::handleCommands(QCommandLineParser& parser)
 
 void SerialCLI::listPorts()
 {
-    QTextStream out(stdout);
+    QTextStream out(m_output);
     QStringList ports = CH34xQt::availablePorts();
     
     if(ports.isEmpty()) {
         out << "未找到CH34x设备\n";
-        return;
+    } else {
+        out << "可用的CH34x设备:\n";
+        for(const QString& port : ports) {
+            out << "  " << port << "\n";
+        }
     }
     
-    out << "可用的CH34x设备:\n";
-    for(const QString& port : ports) {
+    out << "虚拟端口:\n";
+    for(const QString& port : SerialTransport::virtualPorts()) {
         out << "  " << port << "\n";
     }
 }
 
 void SerialCLI::openPort(const QString& portName, const CH34xQt::SerialConfig& config)
 {
-    QTextStream out(stdout);
+    QTextStream out(m_output);
     
-    if(m_device->applyConfig(config)) {
+    if(device()->applyConfig(config)) {
         out << "成功打开设备 " << portName << "\n";
     } else {
         out << "无法打开设备 " << portName << "\n";
@@ -136,22 +262,22 @@ void SerialCLI::openPort(const QString& portName, const CH34xQt::SerialConfig& c
     }
 }
 
-void SerialCLI::sendData(const QString& data)
+bool SerialCLI::sendData(const QString& data)
 {
-    QTextStream out(stdout);
-    
-    if(m_device->writeData(data.toUtf8())) {
-        out << "数据发送成功\n";
-    } else {
+    m_pendingWriteId = device()->queueWrite(data.toUtf8());
+    if(m_pendingWriteId == 0) {
+        QTextStream out(m_output);
         out << "数据发送失败\n";
+        return false;
     }
+    return true;
 }
 
 void SerialCLI::showStatus()
 {
-    QTextStream out(stdout);
+    QTextStream out(m_output);
     
-    if(!m_device->isOpen()) {
+    if(!m_device || !m_device->isOpen()) {
         out << "设备未打开\n";
         return;
     }
@@ -168,19 +294,97 @@ void SerialCLI::showStatus()
         << "  流控制: " << config.flowControl << "\n"
         << "  已接收: " << stats.bytesReceived << " 字节\n"
         << "  已发送: " << stats.bytesSent << " 字节\n"
-        << "  错误数: " << stats.errors << "\n";
+        << "  错误数: " << stats.errors << "\n"
+        << "  接收速率: " << qRound64(stats.receiveByteRate) << " 字节/秒, "
+        << qRound64(stats.receiveFrameRate) << " 帧/秒\n"
+        << "  发送速率: " << qRound64(stats.sendByteRate) << " 字节/秒\n"
+        << "  待发送: " << stats.writeQueueBytes << " 字节\n"
+        << "  帧错误: " << stats.framingErrors
+        << ", CRC错误: " << stats.crcErrors
+        << ", 丢失帧: " << stats.sequenceErrors << "\n"
+        << "  已丢弃: " << stats.droppedFrames << " 帧, "
+        << stats.droppedBytes << " 字节\n"
+        << "  背压暂停: " << stats.readPauses << " 次\n"
+        << "  低延迟模式: " << (config.lowLatency ? (stats.lowLatencyActive ? "已生效" : "驱动不支持")
+                                                   : "未启用")
+        << ", 读取 " << stats.reads << " 次, 设备线程CPU占用 "
+        << qRound(stats.ioCpuLoad * 100) << "%\n"
+        << "  捕获文件: " << (config.capturePath.isEmpty() ? QString("未启用") : config.capturePath) << "\n"
+        << "  帧内最大读取间隔: " << stats.maxIntraFrameGapUs << " us (空闲分帧阈值 "
+        << config.frameGap << " ms)\n"
+        << "  重连: " << stats.reconnects << " 次尝试, "
+        << stats.recoveries << " 次恢复, 最近恢复耗时 "
+        << stats.lastRecoveryUs / 1000 << " ms (最长 "
+        << stats.maxRecoveryUs / 1000 << " ms)\n"
+        << "  接收缓冲: " << stats.receiveBufferCapacity << " 字节 (峰值 "
+        << stats.receiveBufferPeak << ")\n"
+        << "  发送缓冲: " << stats.writeBufferCapacity << " 字节 (峰值 "
+        << stats.writeBufferPeak << ")\n";
+}
+
+void SerialCLI::handleFramesReceived(const QVector<CH34xQt::Frame>& frames)
+{
+    // 整批写入后只刷新一次输出
+    QTextStream out(m_output);
+    for(const CH34xQt::Frame& frame : frames) {
+        if(m_transfer && frame.channel == FileTransfer::CHANNEL) {
+            m_transfer->handleFrame(frame.data);
+        } else if(frame.encoding == Utf8Validator::Invalid) {
+            out << QString::fromLocal8Bit(frame.data) << "\n";
+        } else {
+            out << QString::fromUtf8(frame.data) << "\n";
+        }
+    }
+    out.flush();
+}
+
+void SerialCLI::handleWriteCompleted(quint32 id, bool success)
+{
+    if(id != m_pendingWriteId) {
+        return;
+    }
+    
+    QTextStream out(m_output);
+    out << (success ? "数据发送成功\n" : "数据发送失败\n");
+    out.flush();
+    
+    m_pendingWriteId = 0;
+    QCoreApplication::exit(success ? 0 : 1);
 }
 
-void SerialCLI::handleReceived(const QByteArray& data)
+void SerialCLI::handleFileProgress(bool sending, qint64 bytes, qint64 total, double bytesPerSecond)
 {
-    QTextStream out(stdout);
-    out << QString::fromUtf8(data);
+    // 同一行刷新进度
+    QTextStream out(m_output);
+    out << "\r" << (sending ? "已发送 " : "已接收 ") << bytes << "/" << total << " 字节";
+    if(total > 0) {
+        out << " (" << bytes * 100 / total << "%)";
+    }
+    out << ", " << qRound64(bytesPerSecond / 1024) << " KiB/秒   ";
     out.flush();
 }
 
+void SerialCLI::handleFileFinished(bool sending, bool success, const QString& message)
+{
+    QTextStream out(m_output);
+    if(success) {
+        out << "\n" << (sending ? "文件发送完成: " : "文件已保存到 ") << message << "\n";
+    } else {
+        out << "\n" << (sending ? "文件发送失败: " : "文件接收失败: ") << message << "\n";
+    }
+    out.flush();
+    
+    QCoreApplication::exit(success ? 0 : 1);
+}
+
 void SerialCLI::handleError(const QString& error)
 {
-    QTextStream err(stderr);
+    QTextStream err(m_errorOutput);
     err << "错误: " << error << "\n";
     err.flush();
+    
+    // 连接已结束或放弃重连，读取和收发都无法继续
+    if(m_device && !m_device->isOpen() && !m_device->isReconnecting()) {
+        QCoreApplication::exit(1);
+    }
 } 
@@ -4,8 +4,11 @@
 #include <QObject>
 #include <QCommandLineParser>
 #include <QCommandLineOption>
+#include <cstdio>
 #include "ch34x_qt.h"
 
+class FileTransfer;
+
 /**
  * @brief 串口命令行接口类
  * 
@@ -13,6 +16,7 @@
  * - 列出可用设备
  * - 打开/关闭设备
  * - 发送/接收数据
+ * - 发送/接收文件
  * - 配置串口参数
  * - 查看设备状态
  */
@@ -29,6 +33,11 @@ public:
      */
     bool handleCommands(QCommandLineParser& parser);
     
+    /**
+     * @brief handleCommands()要求退出时程序的退出码，命令失败时非0
+     */
+    int exitCode() const { return m_exitCode; }
+    
     /**
      * @brief 设置命令行选项
      * @param parser 命令行解析器
@@ -36,7 +45,24 @@ public:
     void setupOptions(QCommandLineParser& parser);
     
 private:
-    CH34xQt* m_device;
+    CH34xQt* m_device;          ///< 首次需要时才创建，--list等命令不会分配设备对象
+    quint32 m_pendingWriteId;   ///< 等待写出结果的消息编号
+    FileTransfer* m_transfer;   ///< --send-file/--recv-file时创建
+    int m_exitCode;             ///< 命令执行完毕时的退出码
+    FILE* m_output;             ///< 文本输出，stdio:端口时不使用作为数据通道的标准输出
+    FILE* m_errorOutput;        ///< 错误信息输出
+    
+    /**
+     * @brief 获取设备对象，首次调用时创建
+     */
+    CH34xQt* device();
+    
+    /**
+     * @brief stdio:端口使用的文本输出
+     * 标准输出是数据通道，且打开后与标准输入一起被设为非阻塞，文本改写到标准错误；
+     * 标准错误与它们共用同一个终端时重新打开该终端，得到仍为阻塞的描述符
+     */
+    static FILE* stdioTextOutput();
     
     /**
      * @brief 列出可用设备
@@ -52,9 +78,16 @@ private:
     
     /**
      * @brief 发送数据
+     * 数据进入异步发送队列，写出结果由handleWriteCompleted输出
      * @param data 要发送的数据
+     * @return 是否已加入发送队列
+     */
+    bool sendData(const QString& data);
+    
+    /**
+     * @brief 创建文件传输对象并接到设备的文件通道
      */
-    void sendData(const QString& data);
+    FileTransfer* transfer();
     
     /**
      * @brief 显示设备状态
@@ -62,8 +95,11 @@ private:
     void showStatus();
     
 private slots:
-    void handleReceived(const QByteArray& data);
+    void handleFramesReceived(const QVector<CH34xQt::Frame>& frames);
     void handleError(const QString& error);
+    void handleWriteCompleted(quint32 id, bool success);
+    void handleFileProgress(bool sending, qint64 bytes, qint64 total, double bytesPerSecond);
+    void handleFileFinished(bool sending, bool success, const QString& message);
 };
 
 #endif // SERIALCLI_H 
\ No newline at end of file
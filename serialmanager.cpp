@@ -1,38 +1,126 @@
 #include "serialmanager.h"
+#include <QMetaMethod>
+#include <QStandardPaths>
 
-SerialManager::SerialManager(QObject *parent) : QObject(parent)
+SerialManager::SerialManager(QObject *parent, bool useIoThread)
+    : QObject(parent)
+    , m_ioThread(nullptr)
+    , m_connected(false)
 {
-    m_serialDevice = new CH34xQt(this);
+    m_link = new ReliableLink(this);
+    m_fileTransfer = new FileTransfer(this);
+    m_fileTransfer->setReceiveTarget(QStandardPaths::writableLocation(QStandardPaths::DownloadLocation));
+
+    if(useIoThread) {
+        // 设备对象不能有父对象才能移动到I/O线程，由线程结束时负责释放
+        m_serialDevice = new CH34xQt;
+        m_serialDevice->enableFrameQueue();
+        
+        m_ioThread = new QThread(this);
+        m_ioThread->setObjectName("CH34xQt I/O");
+        m_serialDevice->moveToThread(m_ioThread);
+        connect(m_ioThread, &QThread::finished,
+                m_serialDevice, &QObject::deleteLater);
+        m_ioThread->start(QThread::HighPriority);
+        
+        connect(m_serialDevice, &CH34xQt::framesPending,
+                this, &SerialManager::handleFramesPending);
+    } else {
+        m_serialDevice = new CH34xQt(this);
+        
+        connect(m_serialDevice, &CH34xQt::framesReceived,
+                this, &SerialManager::handleSerialFrames);
+    }
 
-    connect(m_serialDevice, &CH34xQt::dataReceived,
-            this, &SerialManager::handleSerialData);
     connect(m_serialDevice, &CH34xQt::errorOccurred,
             this, &SerialManager::handleSerialError);
+    connect(m_serialDevice, &CH34xQt::writeCompleted,
+            this, [this](quint32, bool success) {
+        // 可靠传输时写出只是中间步骤，以对端确认为准
+        if(!m_currentSettings.reliable) {
+            emit messageWritten(success);
+        }
+    });
     connect(m_serialDevice, &CH34xQt::portsChanged,
             this, &SerialManager::handlePortsChanged);
+    connect(m_serialDevice, &CH34xQt::stateChanged,
+            this, &SerialManager::handleDeviceState);
+    connect(m_serialDevice, &CH34xQt::openFinished,
+            this, [](bool success, const CH34xQt::OpenTiming& timing) {
+        qDebug() << "Open" << (success ? "succeeded" : "failed")
+                 << "in" << timing.totalUs << "us, open:" << timing.openUs
+                 << "us, configure:" << timing.configureUs
+                 << "us, attempts:" << timing.attempts;
+    });
+    connect(m_serialDevice, &CH34xQt::reconnecting,
+            this, &SerialManager::reconnecting);
+    connect(m_serialDevice, &CH34xQt::reconnected,
+            this, [](qint64 recoveryUs) {
+        qDebug() << "Reconnected after" << recoveryUs << "us";
+    });
+    
+    // queueWrite可跨线程调用；被高水位拒绝的数据段由重传补上
+    connect(m_link, &ReliableLink::transmit,
+            this, [this](const QByteArray& packet) {
+        m_serialDevice->queueWrite(packet, ReliableLink::CHANNEL);
+    });
+    connect(m_link, &ReliableLink::delivered,
+            this, [this](quint32, bool success) { emit messageWritten(success); });
+    
+    // 数据块被高水位拒绝时由超时重发补上
+    connect(m_fileTransfer, &FileTransfer::transmit,
+            this, [this](const QByteArray& packet) {
+        m_serialDevice->queueWrite(packet, FileTransfer::CHANNEL);
+    });
+    connect(m_fileTransfer, &FileTransfer::progress,
+            this, &SerialManager::fileProgress);
+    connect(m_fileTransfer, &FileTransfer::finished,
+            this, &SerialManager::fileTransferFinished);
 }
 
 SerialManager::~SerialManager()
 {
     closePort();
+    
+    if(m_ioThread) {
+        m_ioThread->quit();
+        m_ioThread->wait();
+    }
+}
+
+Qt::ConnectionType SerialManager::deviceConnection() const
+{
+    return m_ioThread ? Qt::BlockingQueuedConnection : Qt::DirectConnection;
 }
 
 bool SerialManager::openPort(const QString& portName)
 {
-    bool success = m_serialDevice->openDevice(portName);
-    if(success) {
-        applySettings(m_currentSettings);
-        emit connectionStatusChanged(true);
-    }
-    return success;
+    // 当前设置与端口名合成完整配置，打开时一次性生效；
+    // 调用只启动状态机，结果通过connectionStatusChanged通知
+    const SerialSettingsDialog::Settings settings = m_currentSettings;
+    bool started = false;
+    QMetaObject::invokeMethod(m_serialDevice, [&]() {
+        CH34xQt::SerialConfig config = m_serialDevice->currentConfig();
+        config.portName = portName;
+        config.baudRate = settings.baudRate;
+        config.dataBits = settings.dataBits;
+        config.stopBits = settings.stopBits;
+        config.parity = settings.parity;
+        config.flowControl = settings.flowControl;
+        config.readBufferSize = settings.bufferSize;
+        config.frameGap = settings.packageDelay;
+        config.framing = settings.reliable ? CH34xQt::BinaryFraming
+                       : settings.gapFraming ? CH34xQt::GapFraming : CH34xQt::LineFraming;
+        started = m_serialDevice->openDeviceAsync(config);
+    }, deviceConnection());
+    return started;
 }
 
 void SerialManager::closePort()
 {
-    if(m_serialDevice->isOpen()) {
+    QMetaObject::invokeMethod(m_serialDevice, [this]() {
         m_serialDevice->closeDevice();
-        emit connectionStatusChanged(false);
-    }
+    }, deviceConnection());
 }
 
 bool SerialManager::isOpen() const
@@ -40,9 +128,22 @@ bool SerialManager::isOpen() const
     return m_serialDevice->isOpen();
 }
 
+bool SerialManager::isReconnecting() const
+{
+    bool reconnecting = false;
+    QMetaObject::invokeMethod(m_serialDevice, [&]() {
+        reconnecting = m_serialDevice->isReconnecting();
+    }, deviceConnection());
+    return reconnecting;
+}
+
 bool SerialManager::sendData(const QString& message)
 {
-    return m_serialDevice->writeData(message.toUtf8());
+    if(m_currentSettings.reliable) {
+        return m_serialDevice->isOpen() && m_link->send(message.toUtf8()) != 0;
+    }
+    // queueWrite可跨线程调用，I/O线程模式下也无需等待设备线程
+    return m_serialDevice->queueWrite(message.toUtf8()) != 0;
 }
 
 QStringList SerialManager::getAvailablePorts() const
@@ -50,10 +151,64 @@ QStringList SerialManager::getAvailablePorts() const
     return CH34xQt::availablePorts();
 }
 
-void SerialManager::handleSerialData(const QByteArray& data)
+void SerialManager::handleSerialFrames(const QVector<CH34xQt::Frame>& frames)
+{
+    if(frames.isEmpty()) {
+        return;
+    }
+    
+    // 设备线程已完成编码校验，这里只做一次解码；
+    // 可靠传输的帧先经ReliableLink去重排序，负载需要重新校验
+    QStringList messages;
+    messages.reserve(frames.size());
+    QList<QByteArray> payloads;
+    for(const CH34xQt::Frame& frame : frames) {
+        if(m_currentSettings.reliable && frame.channel == ReliableLink::CHANNEL) {
+            payloads.clear();
+            m_link->handleFrame(frame.data, payloads);
+            for(const QByteArray& payload : payloads) {
+                messages.append(decodeMessage(payload,
+                                              Utf8Validator::validate(payload.constData(), payload.size())));
+            }
+        } else if(m_currentSettings.reliable && frame.channel == FileTransfer::CHANNEL) {
+            m_fileTransfer->handleFrame(frame.data);
+        } else {
+            messages.append(decodeMessage(frame.data, frame.encoding));
+        }
+    }
+    if(messages.isEmpty()) {
+        return;
+    }
+    
+    emit messagesReceived(messages);
+    
+    // 逐条信号仅为兼容保留，没有连接时不发出
+    static const QMetaMethod messageSignal = QMetaMethod::fromSignal(&SerialManager::messageReceived);
+    if(isSignalConnected(messageSignal)) {
+        for(const QString& message : messages) {
+            emit messageReceived(message);
+        }
+    }
+}
+
+QString SerialManager::decodeMessage(const QByteArray& data, Utf8Validator::Result encoding)
+{
+    switch(encoding) {
+        case Utf8Validator::Ascii:
+            return QString::fromLatin1(data);
+        case Utf8Validator::Utf8:
+            return QString::fromUtf8(data);
+        case Utf8Validator::Invalid:
+        default:
+            return QString::fromLocal8Bit(data);
+    }
+}
+
+void SerialManager::handleFramesPending()
 {
-    QString message = QString::fromUtf8(data);
-    emit messageReceived(message);
+    QVector<CH34xQt::Frame> frames;
+    m_serialDevice->takeFrames(frames);
+    handleSerialFrames(frames);
 }
 
 void SerialManager::handleSerialError(const QString& error)
@@ -66,17 +221,43 @@ void SerialManager::handlePortsChanged()
     emit portsChanged();
 }
 
+void SerialManager::handleDeviceState(CH34xQt::DeviceState state)
+{
+    const bool connected = state == CH34xQt::Ready;
+    if(connected != m_connected) {
+        m_connected = connected;
+        // 每次连接开始新的可靠传输会话，断开时未确认的消息以失败结束；
+        // 文件传输随之结束，接收端保留续传记录
+        m_link->reset();
+        if(!connected) {
+            m_fileTransfer->cancel();
+        }
+        emit connectionStatusChanged(connected);
+    }
+}
+
 void SerialManager::applySettings(const SerialSettingsDialog::Settings& settings)
 {
     if(m_serialDevice) {
+        if(settings.reliable != m_currentSettings.reliable) {
+            m_link->reset();
+            m_fileTransfer->cancel();
+        }
         m_currentSettings = settings;
+        m_link->setWindow(settings.reliableWindow);
         
-        m_serialDevice->setBaudRate(settings.baudRate);
-        m_serialDevice->setDataBits(settings.dataBits);
-        m_serialDevice->setStopBits(settings.stopBits);
-        m_serialDevice->setParity(settings.parity);
-        m_serialDevice->setFlowControl(settings.flowControl);
-        m_serialDevice->setReadBufferSize(settings.bufferSize);
+        QMetaObject::invokeMethod(m_serialDevice, [this, settings]() {
+            m_serialDevice->setBaudRate(settings.baudRate);
+            m_serialDevice->setDataBits(settings.dataBits);
+            m_serialDevice->setStopBits(settings.stopBits);
+            m_serialDevice->setParity(settings.parity);
+            m_serialDevice->setFlowControl(settings.flowControl);
+            m_serialDevice->setReadBufferSize(settings.bufferSize);
+            m_serialDevice->setFrameGap(settings.packageDelay);
+            m_serialDevice->setFramingMode(settings.reliable ? CH34xQt::BinaryFraming
+                                           : settings.gapFraming ? CH34xQt::GapFraming
+                                                                 : CH34xQt::LineFraming);
+        }, deviceConnection());
         
         qDebug() << "Applied serial settings:";
         qDebug() << "Baud rate:" << settings.baudRate;
@@ -85,5 +266,35 @@ void SerialManager::applySettings(const SerialSettingsDialog::Settings& settings
         qDebug() << "Parity:" << settings.parity;
         qDebug() << "Flow control:" << settings.flowControl;
         qDebug() << "Buffer size:" << settings.bufferSize;
+        qDebug() << "Gap framing:" << settings.gapFraming << settings.packageDelay << "ms";
+        qDebug() << "Reliable:" << settings.reliable << "window" << m_link->window();
     }
+}
+
+ReliableLink::Statistics SerialManager::reliableStatistics() const
+{
+    return m_link->statistics();
 } 
+
+bool SerialManager::sendFile(const QString& path)
+{
+    if(!m_currentSettings.reliable || !m_serialDevice->isOpen()) {
+        return false;
+    }
+    return m_fileTransfer->sendFile(path);
+}
+
+void SerialManager::setReceiveDirectory(const QString& directory)
+{
+    m_fileTransfer->setReceiveTarget(directory);
+}
+
+QString SerialManager::receiveDirectory() const
+{
+    return m_fileTransfer->receiveTarget();
+}
+
+void SerialManager::cancelFileTransfer()
+{
+    m_fileTransfer->cancel();
+}
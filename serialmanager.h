@@ -2,37 +2,118 @@
 #define SERIALMANAGER_H
 
 #include <QObject>
+#include <QThread>
 #include "ch34x_qt.h"
 #include "serialsettingsdialog.h"
+#include "reliablelink.h"
+#include "filetransfer.h"
 
 class SerialManager : public QObject
 {
     Q_OBJECT
 public:
-    explicit SerialManager(QObject *parent = nullptr);
+    /**
+     * @param parent 父对象
+     * @param useIoThread 为true时串口收发、分帧与统计在独立的I/O线程中运行，
+     *                    数据帧经无锁队列交给本对象所在线程
+     */
+    explicit SerialManager(QObject *parent = nullptr, bool useIoThread = false);
     ~SerialManager();
 
+    /**
+     * @brief 按当前设置异步打开端口
+     * 打开结果通过connectionStatusChanged通知，失败时另有errorOccurred
+     * @return 是否已开始打开
+     */
     bool openPort(const QString& portName);
     void closePort();
     bool isOpen() const;
+    /**
+     * @brief 设备断开后是否正在自动重连
+     */
+    bool isReconnecting() const;
+    /**
+     * @brief 发送消息，只负责入队，不会阻塞事件循环
+     * 启用可靠传输时messageWritten在对端确认后发出，否则在写出到串口后发出
+     * @return 是否已加入发送队列（设备未打开或队列超过高水位时为false）
+     */
     bool sendData(const QString& message);
     QStringList getAvailablePorts() const;
 
     void applySettings(const SerialSettingsDialog::Settings& settings);
 
+    /**
+     * @brief 可靠传输的统计信息，包括有效吞吐量和重传计数
+     */
+    ReliableLink::Statistics reliableStatistics() const;
+
+    /**
+     * @brief 向对端发送文件
+     * 文件按块经二进制帧传输，需要启用可靠传输，对端同样启用才能接收；
+     * 结果通过fileTransferFinished通知
+     * @return 是否已开始（未连接、未启用可靠传输、文件无法打开或已有文件在发送时为false）
+     */
+    bool sendFile(const QString& path);
+
+    /**
+     * @brief 设置收到的文件的保存目录，默认为系统下载目录，为空时拒绝对端发来的文件
+     */
+    void setReceiveDirectory(const QString& directory);
+    QString receiveDirectory() const;
+
+    /**
+     * @brief 取消正在进行的文件收发，未完成的接收可在对端重新发送时续传
+     */
+    void cancelFileTransfer();
+
 signals:
     void messageReceived(const QString& message);
+    /**
+     * @brief 批量消息信号，一次读取中收到的所有消息合并发出
+     */
+    void messagesReceived(const QStringList& messages);
     void errorOccurred(const QString& error);
     void portsChanged();
     void connectionStatusChanged(bool connected);
+    /**
+     * @brief 设备断开后自动重连，参数含义同CH34xQt::reconnecting
+     * 重连成功时另有connectionStatusChanged(true)，放弃重连时另有errorOccurred
+     */
+    void reconnecting(int attempt, int maxAttempts);
+    void messageWritten(bool success);
+    /**
+     * @brief 文件传输进度，参数含义同FileTransfer::progress
+     */
+    void fileProgress(bool sending, qint64 bytes, qint64 total, double bytesPerSecond);
+    /**
+     * @brief 文件传输结束，成功时message为文件路径，失败时为原因
+     */
+    void fileTransferFinished(bool sending, bool success, const QString& message);
 
 private slots:
-    void handleSerialData(const QByteArray& data);
+    void handleSerialFrames(const QVector<CH34xQt::Frame>& frames);
     void handleSerialError(const QString& error);
     void handlePortsChanged();
+    void handleFramesPending();
+    void handleDeviceState(CH34xQt::DeviceState state);
 
 private:
+    /**
+     * @brief 调用设备方法时使用的连接方式
+     * I/O线程模式下阻塞等待设备线程执行完毕，否则直接调用
+     */
+    Qt::ConnectionType deviceConnection() const;
+
+    /**
+     * @brief 按设备的编码校验结果解码一条消息
+     */
+    static QString decodeMessage(const QByteArray& data, Utf8Validator::Result encoding);
+
     CH34xQt* m_serialDevice;
+    ReliableLink* m_link;   ///< 可靠消息层，设置中启用时经它收发
+    FileTransfer* m_fileTransfer;   ///< 文件传输，与可靠消息层共用二进制帧
+    QThread* m_ioThread;
+    bool m_connected;       ///< 最近一次通知的连接状态
     SerialSettingsDialog::Settings m_currentSettings;
 };
 
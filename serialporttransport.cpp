@@ -0,0 +1,195 @@
+#include "serialporttransport.h"
+#include <QFile>
+#ifdef Q_OS_LINUX
+#  include <linux/serial.h>
+#  include <sys/ioctl.h>
+#endif
+
+SerialPortTransport::SerialPortTransport(QObject *parent)
+    : SerialTransport(parent)
+    , m_savedSerialFlags(-1)
+    , m_savedLatencyTimer(-1)
+{
+    m_port = new QSerialPort(this);
+
+    connect(m_port, &QSerialPort::readyRead,
+            this, &SerialTransport::readyRead);
+    connect(m_port, &QSerialPort::bytesWritten,
+            this, &SerialTransport::bytesWritten);
+    connect(m_port, &QSerialPort::errorOccurred,
+            this, &SerialTransport::errorOccurred);
+}
+
+bool SerialPortTransport::open()
+{
+    // 线路参数已经设置在串口对象上，打开时一次性生效
+    m_port->setPortName(portName());
+    return m_port->open(QIODevice::ReadWrite);
+}
+
+void SerialPortTransport::close()
+{
+    if(m_port->isOpen()) {
+        restoreLatency();
+        m_port->close();
+    }
+}
+
+bool SerialPortTransport::isOpen() const
+{
+    return m_port->isOpen();
+}
+
+QByteArray SerialPortTransport::readAll()
+{
+    return m_port->readAll();
+}
+
+qint64 SerialPortTransport::bytesAvailable() const
+{
+    return m_port->bytesAvailable();
+}
+
+qint64 SerialPortTransport::write(const char* data, qint64 size)
+{
+    return m_port->write(data, size);
+}
+
+qint64 SerialPortTransport::bytesToWrite() const
+{
+    return m_port->bytesToWrite();
+}
+
+void SerialPortTransport::setReadBufferSize(qint64 size)
+{
+    m_port->setReadBufferSize(size);
+}
+
+bool SerialPortTransport::clear(QSerialPort::Directions directions)
+{
+    return m_port->clear(directions);
+}
+
+bool SerialPortTransport::probe()
+{
+    m_port->pinoutSignals();
+    const QSerialPort::SerialPortError error = m_port->error();
+    m_port->clearError();
+    return error == QSerialPort::NoError || error == QSerialPort::UnsupportedOperationError;
+}
+
+/**
+ * @brief 启用或关闭低延迟模式
+ *
+ * @details
+ * 1. 通过TIOCGSERIAL/TIOCSSERIAL设置ASYNC_LOW_LATENCY，记录原来的标志
+ * 2. 存在/sys/class/tty/<端口>/device/latency_timer时调到LOW_LATENCY_TIMER，记录原值
+ * 3. 关闭时按记录恢复，设备已拔出时写入失败也无妨
+ */
+bool SerialPortTransport::setLowLatency(bool enable)
+{
+#ifdef Q_OS_LINUX
+    if(!m_port->isOpen()) {
+        return false;
+    }
+    if(!enable) {
+        restoreLatency();
+        return true;
+    }
+
+    bool applied = false;
+    const int fd = m_port->handle();
+    serial_struct serial;
+    if(::ioctl(fd, TIOCGSERIAL, &serial) == 0) {
+        if(m_savedSerialFlags < 0) {
+            m_savedSerialFlags = serial.flags;
+        }
+        serial.flags |= ASYNC_LOW_LATENCY;
+        applied = ::ioctl(fd, TIOCSSERIAL, &serial) == 0;
+    }
+
+    m_latencyTimerPath = QStringLiteral("/sys/class/tty/%1/device/latency_timer").arg(m_port->portName());
+    QFile timer(m_latencyTimerPath);
+    if(timer.open(QIODevice::ReadWrite)) {
+        bool ok = false;
+        const int current = timer.readAll().trimmed().toInt(&ok);
+        if(ok && current > LOW_LATENCY_TIMER) {
+            timer.seek(0);
+            if(timer.write(QByteArray::number(LOW_LATENCY_TIMER)) > 0 && timer.flush()) {
+                if(m_savedLatencyTimer < 0) {
+                    m_savedLatencyTimer = current;
+                }
+                applied = true;
+            }
+        } else if(ok) {
+            applied = true;
+        }
+    }
+    return applied;
+#else
+    Q_UNUSED(enable);
+    return false;
+#endif
+}
+
+void SerialPortTransport::restoreLatency()
+{
+#ifdef Q_OS_LINUX
+    if(m_savedSerialFlags >= 0) {
+        const int fd = m_port->handle();
+        serial_struct serial;
+        if(::ioctl(fd, TIOCGSERIAL, &serial) == 0) {
+            serial.flags = m_savedSerialFlags;
+            ::ioctl(fd, TIOCSSERIAL, &serial);
+        }
+        m_savedSerialFlags = -1;
+    }
+    if(m_savedLatencyTimer >= 0) {
+        QFile timer(m_latencyTimerPath);
+        if(timer.open(QIODevice::WriteOnly)) {
+            timer.write(QByteArray::number(m_savedLatencyTimer));
+        }
+        m_savedLatencyTimer = -1;
+    }
+#endif
+}
+
+void SerialPortTransport::setBaudRate(qint32 baudRate)
+{
+    m_port->setBaudRate(baudRate);
+}
+
+void SerialPortTransport::setDataBits(QSerialPort::DataBits dataBits)
+{
+    m_port->setDataBits(dataBits);
+}
+
+void SerialPortTransport::setStopBits(QSerialPort::StopBits stopBits)
+{
+    m_port->setStopBits(stopBits);
+}
+
+void SerialPortTransport::setParity(QSerialPort::Parity parity)
+{
+    m_port->setParity(parity);
+}
+
+void SerialPortTransport::setFlowControl(QSerialPort::FlowControl flowControl)
+{
+    m_port->setFlowControl(flowControl);
+}
+
+QSerialPort::SerialPortError SerialPortTransport::error() const
+{
+    return m_port->error();
+}
+
+QString SerialPortTransport::errorString() const
+{
+    return m_port->errorString();
+}
+
+void SerialPortTransport::clearError()
+{
+    m_port->clearError();
+}
@@ -0,0 +1,71 @@
+#ifndef SERIALPORTTRANSPORT_H
+#define SERIALPORTTRANSPORT_H
+
+#include "serialtransport.h"
+
+/**
+ * @brief 基于QSerialPort的传输层，即真实串口
+ */
+class SerialPortTransport : public SerialTransport
+{
+    Q_OBJECT
+public:
+    explicit SerialPortTransport(QObject *parent = nullptr);
+
+    Kind kind() const override { return SerialPortKind; }
+
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+
+    QByteArray readAll() override;
+    qint64 bytesAvailable() const override;
+    qint64 write(const char* data, qint64 size) override;
+    qint64 bytesToWrite() const override;
+    void setReadBufferSize(qint64 size) override;
+    bool clear(QSerialPort::Directions directions = QSerialPort::AllDirections) override;
+
+    /**
+     * @brief 读取调制解调器信号线，驱动能响应说明设备已完成初始化
+     */
+    bool probe() override;
+
+    /**
+     * @brief 低延迟模式（仅Linux）
+     *
+     * 内核默认按吞吐量优化串口接收，数据在到达readyRead之前会被攒批：
+     * - 设置ASYNC_LOW_LATENCY后驱动收到数据立即推给线路规程，不经工作队列延后
+     * - FTDI等芯片在USB端还有延迟定时器（latency_timer，默认16ms），
+     *   不足一个USB包的数据要等定时器到期才上报，低延迟模式下调到1ms
+     *
+     * 描述符是非阻塞的，由事件循环在第一个字节可读时唤醒，效果等同VMIN=1、VTIME=0，
+     * 因此不再修改termios。驱动不支持的项（如CH34x没有latency_timer）忽略，
+     * 任一项生效即返回true。
+     */
+    bool setLowLatency(bool enable) override;
+
+    void setBaudRate(qint32 baudRate) override;
+    void setDataBits(QSerialPort::DataBits dataBits) override;
+    void setStopBits(QSerialPort::StopBits stopBits) override;
+    void setParity(QSerialPort::Parity parity) override;
+    void setFlowControl(QSerialPort::FlowControl flowControl) override;
+
+    QSerialPort::SerialPortError error() const override;
+    QString errorString() const override;
+    void clearError() override;
+
+private:
+    /**
+     * @brief 恢复打开低延迟模式之前的设置
+     */
+    void restoreLatency();
+
+    QSerialPort* m_port;    ///< 串口对象
+    int m_savedSerialFlags; ///< 修改前的serial_struct.flags，-1表示未修改
+    int m_savedLatencyTimer;    ///< 修改前的latency_timer(ms)，-1表示未修改
+    QString m_latencyTimerPath; ///< latency_timer的sysfs路径
+
+    static const int LOW_LATENCY_TIMER = 1;     ///< 低延迟模式下的latency_timer(ms)
+};
+
+#endif // SERIALPORTTRANSPORT_H
@@ -19,6 +19,9 @@ void SerialSettingsDialog::setupUi()
     m_flowControlBox = new QComboBox(this);
     m_bufferSizeBox = new QSpinBox(this);
     m_packageDelayBox = new QSpinBox(this);
+    m_framingBox = new QComboBox(this);
+    m_reliableBox = new QCheckBox(tr("可靠传输（确认与重传，对端须同样启用）"), this);
+    m_reliableWindowBox = new QSpinBox(this);
     m_autoScrollBox = new QCheckBox(tr("自动滚动到最新消息"), this);
     m_autoScrollBox->setChecked(true);
     m_autoScrollBox->setEnabled(false);
@@ -34,8 +37,8 @@ void SerialSettingsDialog::setupUi()
     // 使用布局管理器设置界面
     UILayoutManager::setupSerialSettingsDialog(
         this, m_baudRateBox, m_dataBitsBox, m_stopBitsBox,
-        m_parityBox, m_flowControlBox, m_bufferSizeBox,
-        m_packageDelayBox, m_autoScrollBox, m_defaultButton,
+        m_parityBox, m_flowControlBox, m_framingBox, m_bufferSizeBox,
+        m_packageDelayBox, m_reliableBox, m_reliableWindowBox, m_autoScrollBox, m_defaultButton,
         m_okButton, m_cancelButton
     );
     
@@ -47,6 +50,18 @@ void SerialSettingsDialog::setupUi()
             this, &SerialSettingsDialog::handlePackageDelayChanged);
     connect(m_bufferSizeBox, QOverload<int>::of(&QSpinBox::valueChanged),
             this, &SerialSettingsDialog::handleBufferSizeChanged);
+    // 合包延迟只在按空闲间隔分帧时使用
+    connect(m_framingBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, [this]() {
+        m_packageDelayBox->setEnabled(!m_reliableBox->isChecked() &&
+                                      m_framingBox->currentData().toBool());
+    });
+    // 可靠传输使用二进制分帧，分帧方式不再起作用；发送窗口只在可靠传输时使用
+    connect(m_reliableBox, &QCheckBox::toggled, this, [this](bool checked) {
+        m_framingBox->setEnabled(!checked);
+        m_reliableWindowBox->setEnabled(checked);
+        m_packageDelayBox->setEnabled(!checked && m_framingBox->currentData().toBool());
+    });
 }
 
 // 添加新的辅助函数来设置下拉框和数值框的选项
@@ -100,6 +115,10 @@ void SerialSettingsDialog::setupComboBoxes()
     for(const auto& pair : flowControls) {
         m_flowControlBox->addItem(pair.first, pair.second);
     }
+    
+    // 分帧方式选项
+    m_framingBox->addItem(tr("按行"), false);
+    m_framingBox->addItem(tr("按空闲间隔"), true);
 }
 
 void SerialSettingsDialog::setupSpinBoxes()
@@ -114,6 +133,11 @@ void SerialSettingsDialog::setupSpinBoxes()
     m_packageDelayBox->setRange(1, 120);
     m_packageDelayBox->setSuffix(" ms");
     m_packageDelayBox->setButtonSymbols(QAbstractSpinBox::NoButtons);
+    
+    // 可靠传输发送窗口设置
+    m_reliableWindowBox->setRange(1, ReliableLink::MAX_WINDOW);
+    m_reliableWindowBox->setSuffix(tr(" 条"));
+    m_reliableWindowBox->setButtonSymbols(QAbstractSpinBox::NoButtons);
 }
 
 void SerialSettingsDialog::loadDefaultSettings()
@@ -140,9 +164,17 @@ void SerialSettingsDialog::loadDefaultSettings()
     index = m_flowControlBox->findData(QSerialPort::NoFlowControl);
     if(index >= 0) m_flowControlBox->setCurrentIndex(index);
     
+    // 设置分帧方式 按行
+    index = m_framingBox->findData(false);
+    if(index >= 0) m_framingBox->setCurrentIndex(index);
+    m_packageDelayBox->setEnabled(false);
+    
     // 设置缓冲区大小和合包延迟
     m_bufferSizeBox->setValue(4096);  // 4KB 缓冲区
     m_packageDelayBox->setValue(50);   // 50ms 延迟
+    m_reliableBox->setChecked(false);  // 可靠传输关闭
+    m_reliableWindowBox->setValue(ReliableLink::DEFAULT_WINDOW);
+    m_reliableWindowBox->setEnabled(false);
     m_autoScrollBox->setChecked(true); // 自动滚动开启
 }
 
@@ -156,6 +188,9 @@ SerialSettingsDialog::Settings SerialSettingsDialog::getSettings() const
     settings.flowControl = static_cast<QSerialPort::FlowControl>(m_flowControlBox->currentData().toInt());
     settings.bufferSize = m_bufferSizeBox->value();
     settings.packageDelay = m_packageDelayBox->value();
+    settings.gapFraming = m_framingBox->currentData().toBool();
+    settings.reliable = m_reliableBox->isChecked();
+    settings.reliableWindow = m_reliableWindowBox->value();
     settings.autoScroll = true;  // 强制设置为true
     return settings;
 }
@@ -182,6 +217,15 @@ void SerialSettingsDialog::setSettings(const Settings& settings)
     index = m_flowControlBox->findData(settings.flowControl);
     if(index >= 0) m_flowControlBox->setCurrentIndex(index);
     
+    // 设置分帧方式
+    index = m_framingBox->findData(settings.gapFraming);
+    if(index >= 0) m_framingBox->setCurrentIndex(index);
+    m_reliableBox->setChecked(settings.reliable);
+    m_framingBox->setEnabled(!settings.reliable);
+    m_packageDelayBox->setEnabled(settings.gapFraming && !settings.reliable);
+    m_reliableWindowBox->setValue(settings.reliableWindow);
+    m_reliableWindowBox->setEnabled(settings.reliable);
+    
     m_bufferSizeBox->setValue(settings.bufferSize);
     m_packageDelayBox->setValue(settings.packageDelay);
     m_autoScrollBox->setChecked(true);  // 忽略传入的设置，总是保持选中
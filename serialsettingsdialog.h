@@ -11,6 +11,7 @@
 #include <QMessageBox>
 #include <QCheckBox>
 #include <QMouseEvent>
+#include "reliablelink.h"
 
 class SerialSettingsDialog : public QDialog
 {
@@ -20,14 +21,17 @@ public:
     explicit SerialSettingsDialog(QWidget *parent = nullptr);
     
     struct Settings {
-        int baudRate;
-        QSerialPort::DataBits dataBits;
-        QSerialPort::StopBits stopBits;
-        QSerialPort::Parity parity;
-        QSerialPort::FlowControl flowControl;
-        int bufferSize;
-        int packageDelay;
-        bool autoScroll;
+        int baudRate = 115200;
+        QSerialPort::DataBits dataBits = QSerialPort::Data8;
+        QSerialPort::StopBits stopBits = QSerialPort::OneStop;
+        QSerialPort::Parity parity = QSerialPort::NoParity;
+        QSerialPort::FlowControl flowControl = QSerialPort::NoFlowControl;
+        int bufferSize = 4096;
+        int packageDelay = 50;      ///< 合包延迟(ms)，按空闲间隔分帧时的帧间空闲时间
+        bool gapFraming = false;    ///< 按空闲间隔分帧，否则按行分帧
+        bool reliable = false;      ///< 经ReliableLink确认送达，使用二进制分帧，对端须同样启用
+        int reliableWindow = ReliableLink::DEFAULT_WINDOW;  ///< 可靠传输同时在途的最大消息数
+        bool autoScroll = true;
     };
     
     Settings getSettings() const;
@@ -48,6 +52,9 @@ private:
     QComboBox* m_flowControlBox;
     QSpinBox* m_bufferSizeBox;
     QSpinBox* m_packageDelayBox;
+    QComboBox* m_framingBox;
+    QCheckBox* m_reliableBox;
+    QSpinBox* m_reliableWindowBox;
     QPushButton* m_okButton;
     QPushButton* m_cancelButton;
     QPushButton* m_defaultButton;
@@ -0,0 +1,97 @@
+#include "serialtransport.h"
+#include "serialporttransport.h"
+#include "fdtransport.h"
+#include "localsockettransport.h"
+#include "replaytransport.h"
+#include <QDir>
+
+namespace {
+
+const char PTY_PREFIX[] = "pty:";
+const char UNIX_PREFIX[] = "unix:";
+const char STDIO_PREFIX[] = "stdio:";
+const char REPLAY_PREFIX[] = "replay:";
+
+} // namespace
+
+SerialTransport::SerialTransport(QObject *parent)
+    : QObject(parent)
+    , m_error(QSerialPort::NoError)
+{
+}
+
+SerialTransport* SerialTransport::create(const QString& portName, QObject *parent)
+{
+    SerialTransport* transport = nullptr;
+    switch(kindForPort(portName)) {
+#ifdef Q_OS_UNIX
+    case PtyKind:
+        transport = new PtyTransport(parent);
+        break;
+    case StdioKind:
+        transport = new StdioTransport(parent);
+        break;
+#endif
+    case LocalSocketKind:
+        transport = new LocalSocketTransport(parent);
+        break;
+    case ReplayKind:
+        transport = new ReplayTransport(parent);
+        break;
+    default:
+        transport = new SerialPortTransport(parent);
+        break;
+    }
+    transport->setPortName(portName);
+    return transport;
+}
+
+SerialTransport::Kind SerialTransport::kindForPort(const QString& portName)
+{
+    if(portName.startsWith(QLatin1String(PTY_PREFIX))) {
+        return PtyKind;
+    }
+    if(portName.startsWith(QLatin1String(UNIX_PREFIX))) {
+        return LocalSocketKind;
+    }
+    if(portName.startsWith(QLatin1String(STDIO_PREFIX)) || portName == QLatin1String("stdio")) {
+        return StdioKind;
+    }
+    if(portName.startsWith(QLatin1String(REPLAY_PREFIX))) {
+        return ReplayKind;
+    }
+    return SerialPortKind;
+}
+
+QStringList SerialTransport::virtualPorts()
+{
+    QStringList ports;
+#ifdef Q_OS_UNIX
+    ports << QString::fromLatin1(PTY_PREFIX) << QString::fromLatin1(STDIO_PREFIX);
+#endif
+
+    QString socketDir = QString::fromLocal8Bit(qgetenv("NLCHAT_SOCKET_DIR"));
+    if(socketDir.isEmpty()) {
+        socketDir = QDir::tempPath() + QLatin1String("/nlchat");
+    }
+    const QDir dir(socketDir);
+    const QStringList sockets = dir.entryList(QStringList() << QStringLiteral("*.sock"),
+                                              QDir::System | QDir::Files, QDir::Name);
+    for(const QString& name : sockets) {
+        ports << QString::fromLatin1(UNIX_PREFIX) + dir.absoluteFilePath(name);
+    }
+    return ports;
+}
+
+QString SerialTransport::address() const
+{
+    const int colon = m_portName.indexOf(QLatin1Char(':'));
+    return colon < 0 ? QString() : m_portName.mid(colon + 1);
+}
+
+void SerialTransport::setError(QSerialPort::SerialPortError error, const QString& message)
+{
+    m_error = error;
+    m_errorString = message;
+    emit errorOccurred(error);
+}
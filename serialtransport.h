@@ -0,0 +1,141 @@
+#ifndef SERIALTRANSPORT_H
+#define SERIALTRANSPORT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QSerialPort>
+
+/**
+ * @brief CH34xQt使用的字节流传输层接口
+ *
+ * 分帧、重连、统计等逻辑只依赖这个接口，因此可以脱离真实硬件运行和测试。
+ * 具体实现由端口名的前缀决定：
+ * - 无前缀（如ttyUSB0、COM3）：QSerialPort，即真实串口
+ * - pty:[链接路径]：新建一对伪终端，本端持有主设备，从设备路径可供其他程序打开，
+ *   给出链接路径时同时创建指向从设备的符号链接
+ * - unix:路径：连接Unix域套接字
+ * - stdio:：使用本进程的标准输入/输出
+ * - replay:路径[@速度]：回放CH34xQt捕获的数据，见ReplayTransport
+ *
+ * 接口与QSerialPort保持一致：写入只进入缓冲区，由事件循环写出并通过bytesWritten
+ * 报告进度；错误统一用QSerialPort::SerialPortError表示，打开时设备尚未就绪
+ * 报告DeviceNotFoundError或PermissionError，连接断开报告ResourceError。
+ */
+class SerialTransport : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 传输层类型
+     */
+    enum Kind {
+        SerialPortKind,     ///< 真实串口
+        PtyKind,            ///< 伪终端
+        LocalSocketKind,    ///< Unix域套接字
+        StdioKind,          ///< 标准输入/输出
+        ReplayKind          ///< 回放捕获文件
+    };
+
+    explicit SerialTransport(QObject *parent = nullptr);
+
+    /**
+     * @brief 按端口名创建对应的传输层
+     * @param portName 端口名
+     * @param parent 父对象
+     */
+    static SerialTransport* create(const QString& portName, QObject *parent = nullptr);
+
+    /**
+     * @brief 端口名对应的传输层类型
+     */
+    static Kind kindForPort(const QString& portName);
+
+    /**
+     * @brief 可用的虚拟端口
+     * 包括pty:、stdio:，以及套接字目录中的*.sock（目录由环境变量
+     * NLCHAT_SOCKET_DIR指定，默认为临时目录下的nlchat）
+     */
+    static QStringList virtualPorts();
+
+    virtual Kind kind() const = 0;
+
+    void setPortName(const QString& portName) { m_portName = portName; }
+    QString portName() const { return m_portName; }
+
+    /**
+     * @brief 以读写方式打开
+     * @return 是否成功，失败原因见error()
+     */
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+
+    virtual QByteArray readAll() = 0;
+    virtual qint64 bytesAvailable() const = 0;
+
+    /**
+     * @brief 写入数据，只进入发送缓冲区
+     * @return 接受的字节数，失败时为-1
+     */
+    virtual qint64 write(const char* data, qint64 size) = 0;
+    virtual qint64 bytesToWrite() const = 0;
+
+    /**
+     * @brief 设置读缓冲上限，缓冲满后暂停从底层读取，0表示不限
+     */
+    virtual void setReadBufferSize(qint64 size) = 0;
+
+    /**
+     * @brief 丢弃缓冲区中的数据
+     */
+    virtual bool clear(QSerialPort::Directions directions = QSerialPort::AllDirections) = 0;
+
+    /**
+     * @brief 探测设备是否已可以收发
+     * 打开后由CH34xQt调用，未就绪时稍后重试
+     */
+    virtual bool probe() { return isOpen(); }
+
+    /**
+     * @brief 启用或关闭低延迟模式
+     * 须在打开后调用，关闭端口时自动恢复原设置。默认不支持
+     * @return 是否生效
+     */
+    virtual bool setLowLatency(bool enable) { Q_UNUSED(enable); return false; }
+
+    // 串口线路参数，非串口的传输层忽略
+    virtual void setBaudRate(qint32 baudRate) { Q_UNUSED(baudRate); }
+    virtual void setDataBits(QSerialPort::DataBits dataBits) { Q_UNUSED(dataBits); }
+    virtual void setStopBits(QSerialPort::StopBits stopBits) { Q_UNUSED(stopBits); }
+    virtual void setParity(QSerialPort::Parity parity) { Q_UNUSED(parity); }
+    virtual void setFlowControl(QSerialPort::FlowControl flowControl) { Q_UNUSED(flowControl); }
+
+    virtual QSerialPort::SerialPortError error() const { return m_error; }
+    virtual QString errorString() const { return m_errorString; }
+    virtual void clearError() { m_error = QSerialPort::NoError; m_errorString.clear(); }
+
+signals:
+    void readyRead();
+    void bytesWritten(qint64 bytes);
+    void errorOccurred(QSerialPort::SerialPortError error);
+
+protected:
+    /**
+     * @brief 端口名中前缀之后的部分
+     */
+    QString address() const;
+
+    /**
+     * @brief 记录错误并发出errorOccurred
+     */
+    void setError(QSerialPort::SerialPortError error, const QString& message);
+
+private:
+    QString m_portName;                     ///< 完整端口名
+    QSerialPort::SerialPortError m_error;   ///< 最近一次错误
+    QString m_errorString;                  ///< 错误描述
+};
+
+#endif // SERIALTRANSPORT_H
@@ -0,0 +1,90 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QVector>
+#include <atomic>
+#include <utility>
+
+/**
+ * @brief 单生产者/单消费者无锁环形队列
+ *
+ * 用于I/O线程向GUI线程移交已解析的数据帧：
+ * - push()只能由生产者线程调用
+ * - pop()只能由消费者线程调用
+ * - size()可在任意线程调用，结果为近似值
+ *
+ * 容量向上取整为2的幂，队列满时push()返回false，由调用方决定丢弃或暂停读取。
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(int capacity)
+        : m_head(0)
+        , m_tail(0)
+    {
+        int slots = 2;
+        while(slots < capacity) {
+            slots <<= 1;
+        }
+        m_slots.resize(slots);
+        m_data = m_slots.data();  // 之后不再改变大小，两端直接通过指针访问，避免detach检查
+        m_mask = static_cast<unsigned>(slots - 1);
+    }
+
+    /**
+     * @brief 入队（生产者）
+     * @param value 元素
+     * @return 队列已满时返回false
+     */
+    bool push(const T& value)
+    {
+        const unsigned tail = m_tail.load(std::memory_order_relaxed);
+        if(tail - m_head.load(std::memory_order_acquire) > m_mask) {
+            return false;
+        }
+        m_data[tail & m_mask] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 出队（消费者）
+     * @param value 取出的元素
+     * @return 队列为空时返回false
+     */
+    bool pop(T& value)
+    {
+        const unsigned head = m_head.load(std::memory_order_relaxed);
+        if(head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        T& slot = m_data[head & m_mask];
+        value = std::move(slot);
+        slot = T();  // 尽早释放元素持有的内存
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 当前元素个数（近似值）
+     */
+    int size() const
+    {
+        return static_cast<int>(m_tail.load(std::memory_order_acquire)
+                                - m_head.load(std::memory_order_acquire));
+    }
+
+    int capacity() const { return static_cast<int>(m_mask + 1); }
+
+private:
+    QVector<T> m_slots;                 ///< 元素槽位
+    T* m_data;                          ///< 槽位首地址
+    unsigned m_mask;                    ///< 下标掩码
+    char m_padding0[64];                ///< 避免两端游标伪共享
+    std::atomic<unsigned> m_head;       ///< 消费者游标
+    char m_padding1[64];
+    std::atomic<unsigned> m_tail;       ///< 生产者游标
+};
+
+#endif // SPSCQUEUE_H
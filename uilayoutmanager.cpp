@@ -313,8 +313,11 @@ void UILayoutManager::setupSerialSettingsDialog(QDialog* dialog,
                                               QComboBox* stopBitsBox,
                                               QComboBox* parityBox,
                                               QComboBox* flowControlBox,
+                                              QComboBox* framingBox,
                                               QSpinBox* bufferSizeBox,
                                               QSpinBox* packageDelayBox,
+                                              QCheckBox* reliableBox,
+                                              QSpinBox* reliableWindowBox,
                                               QCheckBox* autoScrollBox,
                                               QPushButton* defaultButton,
                                               QPushButton* okButton,
@@ -355,8 +358,9 @@ void UILayoutManager::setupSerialSettingsDialog(QDialog* dialog,
     
     // 创建设置区域
     QWidget* settingsArea = createSettingsArea(baudRateBox, dataBitsBox, stopBitsBox,
-                                             parityBox, flowControlBox, bufferSizeBox,
-                                             packageDelayBox, autoScrollBox);
+                                             parityBox, flowControlBox, framingBox,
+                                             bufferSizeBox, packageDelayBox, reliableBox,
+                                             reliableWindowBox, autoScrollBox);
     
     // 创建按钮区域
     QWidget* buttonArea = createSettingsButtons(defaultButton, okButton, cancelButton);
@@ -379,8 +383,11 @@ QWidget* UILayoutManager::createSettingsArea(QComboBox* baudRateBox,
                                            QComboBox* stopBitsBox,
                                            QComboBox* parityBox,
                                            QComboBox* flowControlBox,
+                                           QComboBox* framingBox,
                                            QSpinBox* bufferSizeBox,
                                            QSpinBox* packageDelayBox,
+                                           QCheckBox* reliableBox,
+                                           QSpinBox* reliableWindowBox,
                                            QCheckBox* autoScrollBox)
 {
     QWidget* widget = new QWidget;
@@ -400,7 +407,10 @@ QWidget* UILayoutManager::createSettingsArea(QComboBox* baudRateBox,
     addRow(QObject::tr("校验位:"), parityBox);
     addRow(QObject::tr("流控制:"), flowControlBox);
     addRow(QObject::tr("缓冲区大小:"), bufferSizeBox);
+    addRow(QObject::tr("分帧方式:"), framingBox);
     addRow(QObject::tr("合包延迟:"), packageDelayBox);
+    layout->addWidget(reliableBox, row++, 0, 1, 2);
+    addRow(QObject::tr("发送窗口:"), reliableWindowBox);
     layout->addWidget(autoScrollBox, row++, 0, 1, 2);
     
     return widget;
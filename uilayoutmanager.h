@@ -35,8 +35,11 @@ public:
                                         QComboBox* stopBitsBox,
                                         QComboBox* parityBox,
                                         QComboBox* flowControlBox,
+                                        QComboBox* framingBox,
                                         QSpinBox* bufferSizeBox,
                                         QSpinBox* packageDelayBox,
+                                        QCheckBox* reliableBox,
+                                        QSpinBox* reliableWindowBox,
                                         QCheckBox* autoScrollBox,
                                         QPushButton* defaultButton,
                                         QPushButton* okButton,
@@ -64,8 +67,11 @@ private:
                                      QComboBox* stopBitsBox,
                                      QComboBox* parityBox,
                                      QComboBox* flowControlBox,
+                                     QComboBox* framingBox,
                                      QSpinBox* bufferSizeBox,
                                      QSpinBox* packageDelayBox,
+                                     QCheckBox* reliableBox,
+                                     QSpinBox* reliableWindowBox,
                                      QCheckBox* autoScrollBox);
                                      
     static QWidget* createSettingsButtons(QPushButton* defaultButton,
@@ -0,0 +1,235 @@
+#include "utf8validator.h"
+#include <cstring>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#  include <immintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#    define UTF8VALIDATOR_HAVE_SSSE3
+#    define UTF8VALIDATOR_TARGET_SSSE3
+#  elif defined(__GNUC__) || defined(__clang__)
+#    define UTF8VALIDATOR_HAVE_SSSE3
+#    define UTF8VALIDATOR_TARGET_SSSE3 __attribute__((target("ssse3")))
+#  endif
+#endif
+
+namespace {
+
+/**
+ * @brief 从第一个非ASCII字节开始逐字符校验
+ * 连续的ASCII按8字节一组跳过
+ */
+Utf8Validator::Result validateScalarImpl(const unsigned char* p, const unsigned char* end)
+{
+    bool nonAscii = false;
+    while(p < end) {
+        if(end - p >= 8) {
+            std::uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            if((word & 0x8080808080808080ull) == 0) {
+                p += 8;
+                continue;
+            }
+        }
+
+        const unsigned char c = *p;
+        if(c < 0x80) {
+            ++p;
+            continue;
+        }
+        nonAscii = true;
+
+        int length;
+        unsigned char low = 0x80;   // 第二个字节的合法范围
+        unsigned char high = 0xBF;
+        if(c >= 0xC2 && c <= 0xDF) {
+            length = 2;
+        } else if(c >= 0xE0 && c <= 0xEF) {
+            length = 3;
+            if(c == 0xE0) low = 0xA0;           // 超长编码
+            else if(c == 0xED) high = 0x9F;     // UTF-16代理区
+        } else if(c >= 0xF0 && c <= 0xF4) {
+            length = 4;
+            if(c == 0xF0) low = 0x90;           // 超长编码
+            else if(c == 0xF4) high = 0x8F;     // 超出U+10FFFF
+        } else {
+            return Utf8Validator::Invalid;
+        }
+
+        if(end - p < length || p[1] < low || p[1] > high) {
+            return Utf8Validator::Invalid;
+        }
+        for(int i = 2; i < length; ++i) {
+            if((p[i] & 0xC0) != 0x80) {
+                return Utf8Validator::Invalid;
+            }
+        }
+        p += length;
+    }
+    return nonAscii ? Utf8Validator::Utf8 : Utf8Validator::Ascii;
+}
+
+#ifdef UTF8VALIDATOR_HAVE_SSSE3
+
+// 查表算法的错误类别，见 Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte"
+const char TOO_SHORT = 1 << 0;      // 11______ 0_______ / 11______ 11______
+const char TOO_LONG = 1 << 1;       // 0_______ 10______
+const char OVERLONG_3 = 1 << 2;     // 11100000 100_____
+const char TOO_LARGE = 1 << 3;      // 11110100 1001____ / 11110100 101_____ / 11110101+
+const char SURROGATE = 1 << 4;      // 11101101 101_____
+const char OVERLONG_2 = 1 << 5;     // 1100000_ 10______
+const char TOO_LARGE_1000 = 1 << 6; // 11110101+ 1000____
+const char OVERLONG_4 = 1 << 6;     // 11110000 1000____
+const char TWO_CONTS = char(1 << 7);// 10______ 10______
+const char CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+struct Ssse3State {
+    __m128i error;
+    __m128i prevInput;
+    __m128i prevIncomplete;
+    bool nonAscii;
+};
+
+UTF8VALIDATOR_TARGET_SSSE3
+inline __m128i highNibbles(__m128i v)
+{
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+}
+
+UTF8VALIDATOR_TARGET_SSSE3
+void checkBlock(Ssse3State& state, __m128i input)
+{
+    if(_mm_movemask_epi8(input) == 0) {
+        // 纯ASCII块：只需确认上一块没有以未完成的多字节序列结尾
+        state.error = _mm_or_si128(state.error, state.prevIncomplete);
+        state.prevIncomplete = _mm_setzero_si128();
+        state.prevInput = input;
+        return;
+    }
+    state.nonAscii = true;
+
+    const __m128i byte1HighTable = _mm_setr_epi8(
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2,
+        TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+    const __m128i byte1LowTable = _mm_setr_epi8(
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+        CARRY | OVERLONG_2,
+        CARRY,
+        CARRY,
+        CARRY | TOO_LARGE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000);
+    const __m128i byte2HighTable = _mm_setr_epi8(
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    // 两字节组合的特殊情况
+    const __m128i prev1 = _mm_alignr_epi8(input, state.prevInput, 15);
+    const __m128i byte1High = _mm_shuffle_epi8(byte1HighTable, highNibbles(prev1));
+    const __m128i byte1Low = _mm_shuffle_epi8(byte1LowTable,
+                                              _mm_and_si128(prev1, _mm_set1_epi8(0x0F)));
+    const __m128i byte2High = _mm_shuffle_epi8(byte2HighTable, highNibbles(input));
+    const __m128i special = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+    // 三、四字节序列的第3/4个字节必须是续字节
+    const __m128i prev2 = _mm_alignr_epi8(input, state.prevInput, 14);
+    const __m128i prev3 = _mm_alignr_epi8(input, state.prevInput, 13);
+    const __m128i isThird = _mm_subs_epu8(prev2, _mm_set1_epi8(char(0xE0 - 1)));
+    const __m128i isFourth = _mm_subs_epu8(prev3, _mm_set1_epi8(char(0xF0 - 1)));
+    const __m128i must23 = _mm_cmpgt_epi8(_mm_or_si128(isThird, isFourth), _mm_setzero_si128());
+    const __m128i must23As80 = _mm_and_si128(must23, _mm_set1_epi8(char(0x80)));
+    state.error = _mm_or_si128(state.error, _mm_xor_si128(must23As80, special));
+
+    // 块尾是否停在未完成的多字节序列中
+    const __m128i maxValue = _mm_setr_epi8(
+        char(0xFF), char(0xFF), char(0xFF), char(0xFF),
+        char(0xFF), char(0xFF), char(0xFF), char(0xFF),
+        char(0xFF), char(0xFF), char(0xFF), char(0xFF),
+        char(0xFF), char(0xF0 - 1), char(0xE0 - 1), char(0xC0 - 1));
+    state.prevIncomplete = _mm_subs_epu8(input, maxValue);
+    state.prevInput = input;
+}
+
+UTF8VALIDATOR_TARGET_SSSE3
+Utf8Validator::Result validateSsse3(const unsigned char* p, int size)
+{
+    Ssse3State state;
+    state.error = _mm_setzero_si128();
+    state.prevInput = _mm_setzero_si128();
+    state.prevIncomplete = _mm_setzero_si128();
+    state.nonAscii = false;
+
+    while(size >= 16) {
+        checkBlock(state, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        p += 16;
+        size -= 16;
+    }
+    if(size > 0) {
+        // 尾部补0（ASCII）到整块，截断的多字节序列会被判为TOO_SHORT
+        unsigned char tail[16] = { 0 };
+        std::memcpy(tail, p, static_cast<size_t>(size));
+        checkBlock(state, _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail)));
+    }
+    state.error = _mm_or_si128(state.error, state.prevIncomplete);
+
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(state.error, _mm_setzero_si128())) != 0xFFFF) {
+        return Utf8Validator::Invalid;
+    }
+    return state.nonAscii ? Utf8Validator::Utf8 : Utf8Validator::Ascii;
+}
+
+bool cpuHasSsse3()
+{
+#if defined(__SSSE3__)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+#endif // UTF8VALIDATOR_HAVE_SSSE3
+
+} // namespace
+
+Utf8Validator::Result Utf8Validator::validate(const char* data, int size)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+#ifdef UTF8VALIDATOR_HAVE_SSSE3
+    static const bool useSsse3 = cpuHasSsse3();
+    if(useSsse3) {
+        return validateSsse3(p, size);
+    }
+#endif
+    return validateScalarImpl(p, p + size);
+}
+
+Utf8Validator::Result Utf8Validator::validateScalar(const char* data, int size)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    return validateScalarImpl(p, p + size);
+}
@@ -0,0 +1,39 @@
+#ifndef UTF8VALIDATOR_H
+#define UTF8VALIDATOR_H
+
+/**
+ * @brief 不分配内存的UTF-8校验器
+ *
+ * 每帧只扫描一次，结果随帧传递，后续环节据此直接选择解码方式：
+ * - 纯ASCII数据每次比较16字节，直接判定为Ascii
+ * - 含多字节字符时使用SSSE3查表算法（Keiser/Lemire）整块校验，
+ *   检查截断、超长编码、代理区和超出U+10FFFF的码点
+ * - CPU不支持SSSE3时退化为逐字符的标量校验
+ */
+class Utf8Validator
+{
+public:
+    /**
+     * @brief 校验结果
+     */
+    enum Result {
+        Ascii,      ///< 纯ASCII，可按Latin-1直接转换
+        Utf8,       ///< 合法的UTF-8
+        Invalid     ///< 不是合法的UTF-8，应按本地编码解码
+    };
+
+    /**
+     * @brief 校验一段数据
+     * @param data 数据指针
+     * @param size 数据长度
+     * @return 校验结果
+     */
+    static Result validate(const char* data, int size);
+
+    /**
+     * @brief 强制使用标量实现（基准测试对比用）
+     */
+    static Result validateScalar(const char* data, int size);
+};
+
+#endif // UTF8VALIDATOR_H